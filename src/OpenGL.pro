@@ -12,11 +12,60 @@ QMAKE_CXXFLAGS += -Wextra -pedantic
 SOURCES += \
     main.cpp \
     mainwindow.cpp \
-    widgetopengldraw.cpp
+    widgetopengldraw.cpp \
+    objloader.cpp \
+    modelloader.cpp \
+    meshcache.cpp \
+    textureloader.cpp \
+    mipmap.cpp \
+    normalmap.cpp \
+    texturemapping.cpp \
+    voxelmesh.cpp \
+    parallel.cpp \
+    scene.cpp \
+    uniforms.cpp \
+    renderqueue.cpp \
+    culling.cpp \
+    meshbuffer.cpp \
+    lod.cpp \
+    meshoptimize.cpp \
+    vertexformat.cpp \
+    assetcache.cpp \
+    profiler.cpp \
+    lightclusters.cpp \
+    gbuffer.cpp \
+    shadervariants.cpp \
+    programcache.cpp \
+    benchmark.cpp
 
 HEADERS += \
     mainwindow.h \
-    widgetopengldraw.h
+    widgetopengldraw.h \
+    mesh.h \
+    objloader.h \
+    modelloader.h \
+    meshcache.h \
+    textureloader.h \
+    mipmap.h \
+    normalmap.h \
+    texturemapping.h \
+    voxelmesh.h \
+    parallel.h \
+    scene.h \
+    uniforms.h \
+    renderqueue.h \
+    culling.h \
+    meshbuffer.h \
+    lod.h \
+    meshoptimize.h \
+    vertexformat.h \
+    assetcache.h \
+    profiler.h \
+    lightclusters.h \
+    gbuffer.h \
+    shadervariants.h \
+    programcache.h \
+    benchmark.h
 
 FORMS += \
     mainwindow.ui
@@ -0,0 +1,80 @@
+#include "assetcache.h"
+
+#include <QFileInfo>
+
+QString assetKey(const QString &path, uint64_t contentHash) {
+    return QFileInfo(path).canonicalFilePath() + "#" + QString::number(contentHash, 16);
+}
+
+void AssetCache::initialize(QOpenGLFunctions_3_3_Core *gl_, MeshBuffer *meshBuffer_) {
+    gl = gl_;
+    meshBuffer = meshBuffer_;
+}
+
+template <typename T>
+std::shared_ptr<T> AssetCache::find(QHash<QString, std::weak_ptr<T>> &assets, const QString &key, bool count) {
+    std::shared_ptr<T> asset;
+    if (!key.isEmpty()) {
+        asset = assets.value(key).lock();
+    }
+
+    if (count) {
+        ++(asset ? cacheStats.hits : cacheStats.misses);
+    }
+    return asset;
+}
+
+std::shared_ptr<GpuMesh> AssetCache::findMesh(const QString &key, bool count) {
+    return find(meshes, key, count);
+}
+
+std::shared_ptr<GpuTexture> AssetCache::findTexture(const QString &key, bool count) {
+    return find(textures, key, count);
+}
+
+std::shared_ptr<GpuMesh> AssetCache::addMesh(const QString &key, const GpuMesh &mesh) {
+    std::shared_ptr<GpuMesh> asset(new GpuMesh(mesh), [this, key](GpuMesh *released) { releaseMesh(key, released); });
+    if (!key.isEmpty()) {
+        meshes.insert(key, asset);
+    }
+
+    ++cacheStats.meshes;
+    cacheStats.residentBytes += mesh.bytes;
+    return asset;
+}
+
+std::shared_ptr<GpuTexture> AssetCache::addTexture(const QString &key, const GpuTexture &texture) {
+    std::shared_ptr<GpuTexture> asset(new GpuTexture(texture), [this, key](GpuTexture *released) { releaseTexture(key, released); });
+    if (!key.isEmpty()) {
+        textures.insert(key, asset);
+    }
+
+    ++cacheStats.textures;
+    cacheStats.residentBytes += texture.bytes;
+    return asset;
+}
+
+void AssetCache::releaseMesh(const QString &key, GpuMesh *mesh) {
+    meshBuffer->remove(mesh->handle);
+
+    // Entry may already belong to a newer asset of the same key
+    if (!key.isEmpty() && meshes.value(key).expired()) {
+        meshes.remove(key);
+    }
+
+    --cacheStats.meshes;
+    cacheStats.residentBytes -= mesh->bytes;
+    delete mesh;
+}
+
+void AssetCache::releaseTexture(const QString &key, GpuTexture *texture) {
+    gl->glDeleteTextures(1, &texture->texture);
+
+    if (!key.isEmpty() && textures.value(key).expired()) {
+        textures.remove(key);
+    }
+
+    --cacheStats.textures;
+    cacheStats.residentBytes -= texture->bytes;
+    delete texture;
+}
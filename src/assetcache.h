@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include <QString>
+#include <QHash>
+#include <QOpenGLFunctions_3_3_Core>
+
+#include <glm/glm.hpp>
+
+#include "meshbuffer.h"
+#include "lod.h"
+
+// Mesh on GPU (range in mesh buffer), shared by all objects using the same mesh
+struct GpuMesh {
+    uint32_t handle = 0; // Mesh buffer handle
+    size_t vertexCount = 0;
+    size_t indexCount = 0; // Original level
+    std::vector<MeshLevel> levels; // Levels of detail, at least original one
+    glm::vec3 boundingBoxMin; // Local space
+    glm::vec3 boundingBoxMax;
+    size_t bytes = 0; // GPU memory
+};
+
+// Texture (with mip chain) on GPU, shared by all objects using the same image
+struct GpuTexture {
+    GLuint texture = 0;
+    size_t bytes = 0; // GPU memory
+};
+
+struct AssetCacheStats {
+    uint32_t hits = 0;
+    uint32_t misses = 0;
+    uint32_t meshes = 0; // Resident
+    uint32_t textures = 0;
+    size_t residentBytes = 0;
+};
+
+// Asset key of a file, canonical path and content hash (changed file is a different asset)
+QString assetKey(const QString &path, uint64_t contentHash);
+
+// Shared GPU meshes and textures by asset key (OpenGL thread only)
+// Objects hold returned handles, GPU memory is released when the last handle is released (context must be current)
+class AssetCache {
+public:
+    void initialize(QOpenGLFunctions_3_3_Core *gl_, MeshBuffer *meshBuffer_);
+
+    // Resident asset of key or nullptr (empty key never matches), lookups are counted as hits and misses unless count is false
+    std::shared_ptr<GpuMesh> findMesh(const QString &key, bool count = true);
+    std::shared_ptr<GpuTexture> findTexture(const QString &key, bool count = true);
+
+    // Take ownership of uploaded mesh range or texture, shared by key (empty key - not shared, eg. generated images)
+    std::shared_ptr<GpuMesh> addMesh(const QString &key, const GpuMesh &mesh);
+    std::shared_ptr<GpuTexture> addTexture(const QString &key, const GpuTexture &texture);
+
+    const AssetCacheStats &stats() const { return cacheStats; }
+
+private:
+    QOpenGLFunctions_3_3_Core *gl = nullptr;
+    MeshBuffer *meshBuffer = nullptr;
+    QHash<QString, std::weak_ptr<GpuMesh>> meshes;
+    QHash<QString, std::weak_ptr<GpuTexture>> textures;
+    AssetCacheStats cacheStats;
+
+    template <typename T>
+    std::shared_ptr<T> find(QHash<QString, std::weak_ptr<T>> &assets, const QString &key, bool count);
+
+    void releaseMesh(const QString &key, GpuMesh *mesh);
+    void releaseTexture(const QString &key, GpuTexture *texture);
+};
@@ -0,0 +1,1786 @@
+#include "benchmark.h"
+
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <string>
+
+#include <QTemporaryFile>
+#include <QTemporaryDir>
+#include <QFileInfo>
+#include <QDir>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QOpenGLContext>
+#include <QOffscreenSurface>
+#include <QOpenGLFramebufferObject>
+#include <QOpenGLFunctions_3_3_Core>
+
+#include <glm/glm.hpp>
+#include <glm/ext.hpp>
+
+#include "objloader.h"
+#include "modelloader.h"
+#include "textureloader.h"
+#include "mipmap.h"
+#include "culling.h"
+#include "meshbuffer.h"
+#include "lod.h"
+#include "meshoptimize.h"
+#include "vertexformat.h"
+#include "normalmap.h"
+#include "texturemapping.h"
+#include "scene.h"
+#include "widgetopengldraw.h"
+
+namespace {
+
+const int benchmarkRuns = 3;
+
+// Write a tessellated grid with positions, UVs and normals (2 triangles per quad)
+bool writeGridOBJ(QFile &file, uint32_t faces) {
+    uint32_t side = static_cast<uint32_t>(std::ceil(std::sqrt(faces / 2.0))) + 1;
+    QByteArray buffer;
+    char line[128];
+
+    auto append = [&](int length) -> bool {
+        buffer.append(line, length);
+        if (buffer.size() > (1 << 20)) {
+            if (file.write(buffer) != buffer.size()) return false;
+            buffer.resize(0);
+        }
+        return true;
+    };
+
+    bool ok = true;
+    for (uint32_t y = 0; y < side && ok; ++y) {
+        for (uint32_t x = 0; x < side && ok; ++x) {
+            float u = static_cast<float>(x) / (side - 1);
+            float v = static_cast<float>(y) / (side - 1);
+            float height = std::sin(u * 20.0f) * std::cos(v * 20.0f);
+            ok = append(std::snprintf(line, sizeof(line), "v %f %f %f\nvt %f %f\nvn %f %f %f\n", u * 100.0f, height, v * 100.0f, u, v, 0.0f, 1.0f, 0.0f));
+        }
+    }
+
+    uint32_t written = 0;
+    for (uint32_t y = 0; y + 1 < side && ok; ++y) {
+        for (uint32_t x = 0; x + 1 < side && written < faces && ok; ++x) {
+            uint32_t a = y * side + x + 1, b = a + 1, c = a + side, d = c + 1;
+            ok = append(std::snprintf(line, sizeof(line), "f %u/%u/%u %u/%u/%u %u/%u/%u\n", a, a, a, c, c, c, b, b, b));
+            ++written;
+            if (ok && written < faces) {
+                ok = append(std::snprintf(line, sizeof(line), "f %u/%u/%u %u/%u/%u %u/%u/%u\n", b, b, b, c, c, c, d, d, d));
+                ++written;
+            }
+        }
+    }
+
+    return ok && file.write(buffer) == buffer.size() && file.flush();
+}
+
+bool benchmarkOBJFile(const QString &path, const QString &name) {
+    OBJStats best;
+    for (int run = 0; run < benchmarkRuns; ++run) {
+        std::vector<Vertex> vertices;
+        std::vector<GLuint> indices;
+        OBJStats stats;
+        if (!loadOBJ(path, vertices, indices, &stats)) {
+            std::cerr << "Benchmark model loading failed! [" << path.toStdString() << "]" << std::endl;
+            return false;
+        }
+        if (run == 0 || stats.parseTime < best.parseTime) best = stats;
+    }
+
+    double seconds = std::max(best.parseTime / 1000.0, 1e-9);
+    std::cout << std::left << std::setw(24) << name.toStdString() << std::right << std::fixed << std::setprecision(2)
+              << std::setw(10) << best.bytes / (1024.0 * 1024.0)
+              << std::setw(12) << best.triangles
+              << std::setw(12) << best.parseTime
+              << std::setw(12) << best.bytes / (1024.0 * 1024.0) / seconds
+              << std::setw(14) << best.triangles / seconds / 1e6
+              << std::setw(12) << best.weldedVertices
+              << std::setw(12) << best.savedBytes / 1024 << std::endl;
+    return true;
+}
+
+// Images given on command line, or a generated noisy pattern (worst case for minification) if none are given
+bool benchmarkImages(const QStringList &paths, std::vector<std::pair<QString, QImage>> &images /* out */) {
+    for (const auto &path : paths) {
+        QImage image;
+        if (!TextureLoader::decode(path, image)) {
+            return false;
+        }
+        images.push_back({QFileInfo(path).fileName(), image});
+    }
+
+    if (images.empty()) {
+        QImage image(2048, 2048, QImage::Format_ARGB32);
+        uint32_t state = 1;
+        for (int y = 0; y < image.height(); ++y) {
+            uint32_t *row = reinterpret_cast<uint32_t *>(image.scanLine(y));
+            for (int x = 0; x < image.width(); ++x) {
+                state = state * 1664525u + 1013904223u;
+                row[x] = (((x / 16) + (y / 16)) % 2 == 0 ? 0xFFC0C0C0u : 0xFF404040u) ^ (state >> 24);
+            }
+        }
+        images.push_back({"generated (2048x2048)", image});
+    }
+    return true;
+}
+
+// UV sphere of given radius, seam column and poles have duplicated vertices (like textured models)
+void makeSphere(uint32_t segments, float radius, std::vector<Vertex> &vertices /* out */, std::vector<GLuint> &indices /* out */) {
+    uint32_t rings = segments / 2;
+    for (uint32_t ring = 0; ring <= rings; ++ring) {
+        for (uint32_t segment = 0; segment <= segments; ++segment) {
+            float theta = glm::pi<float>() * ring / rings;
+            float phi = glm::two_pi<float>() * segment / segments;
+            glm::vec3 normal(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+            vertices.push_back({normal * radius, glm::vec2(static_cast<float>(segment) / segments, static_cast<float>(ring) / rings), normal, glm::vec4(0.0f)});
+        }
+    }
+    for (uint32_t ring = 0; ring < rings; ++ring) {
+        for (uint32_t segment = 0; segment < segments; ++segment) {
+            GLuint a = ring * (segments + 1) + segment, b = a + 1, c = a + segments + 1, d = c + 1;
+            indices.insert(indices.end(), {a, c, b, b, c, d});
+        }
+    }
+    computeTangents(vertices, indices);
+}
+
+// Models given on command line (optimized like loaded models), or a generated sphere if none are given
+bool benchmarkModels(const QStringList &paths, std::vector<LoadedModel> &models /* out */) {
+    for (const auto &path : paths) {
+        models.emplace_back();
+        models.back().path = QFileInfo(path).fileName();
+        if (!loadOBJ(path, models.back().vertices, models.back().indices)) {
+            std::cerr << "Model OBJ file parsing failed! [" << path.toStdString() << "]" << std::endl;
+            return false;
+        }
+        optimizeMesh(models.back().vertices, models.back().indices);
+    }
+
+    if (models.empty()) {
+        models.emplace_back();
+        models.back().path = "generated sphere";
+        makeSphere(256, 1.0f, models.back().vertices, models.back().indices);
+        optimizeMesh(models.back().vertices, models.back().indices);
+    }
+    return true;
+}
+
+void boundingBox(const std::vector<Vertex> &vertices, glm::vec3 &min /* out */, glm::vec3 &max /* out */) {
+    min = glm::vec3(INFINITY);
+    max = glm::vec3(-INFINITY);
+    for (const auto &vertex : vertices) {
+        min = glm::min(min, vertex.position);
+        max = glm::max(max, vertex.position);
+    }
+}
+
+// Minimum, average, 95th and 99th percentile and maximum of frame times (milliseconds)
+QJsonObject frameTimeStats(std::vector<double> times) {
+    QJsonObject stats;
+    if (times.empty()) {
+        return stats;
+    }
+
+    std::sort(times.begin(), times.end());
+    auto percentile = [&times](double p) {
+        size_t rank = static_cast<size_t>(std::ceil(p * times.size()));
+        return times[std::min(std::max<size_t>(rank, 1), times.size()) - 1];
+    };
+    double sum = 0.0;
+    for (double time : times) {
+        sum += time;
+    }
+
+    stats["min"] = times.front();
+    stats["avg"] = sum / times.size();
+    stats["p95"] = percentile(0.95);
+    stats["p99"] = percentile(0.99);
+    stats["max"] = times.back();
+    return stats;
+}
+
+// Read one byte per page, so mapped data is really paged in (as it would be by glBufferData)
+uint64_t touchPages(const uchar *data, size_t size) {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < size; i += 4096) {
+        sum += data[i];
+    }
+    return sum;
+}
+
+// Pyramid generated like before greedy meshing, a full cube stamped for every block (every inner face kept)
+MeshObject stampedPyramid(WidgetOpenGLDraw &widget, uint32_t rows) {
+    MeshObject cube = widget.makeCube();
+    MeshObject pyramid("");
+    float offset = 0.0f;
+    for (uint32_t row = 0; row < rows; ++row) {
+        for (uint32_t i = 0; i < rows - row; ++i) {
+            for (uint32_t j = 0; j < rows - row; ++j) {
+                GLuint baseIndex = static_cast<GLuint>(pyramid.vertices.size());
+                for (Vertex vertex : cube.vertices) {
+                    vertex.position += glm::vec3(offset + i, row, offset + j);
+                    pyramid.vertices.push_back(vertex);
+                }
+                for (GLuint index : cube.indices) {
+                    pyramid.indices.push_back(baseIndex + index);
+                }
+            }
+        }
+
+        offset += 0.5f;
+    }
+    return pyramid;
+}
+
+} // namespace
+
+int benchmarkOBJParser(const QStringList &paths, uint32_t generatedFaces) {
+    std::cout << std::left << std::setw(24) << "File" << std::right << std::setw(10) << "MB" << std::setw(12) << "Triangles"
+              << std::setw(12) << "ms (best)" << std::setw(12) << "MB/s" << std::setw(14) << "MTriangles/s"
+              << std::setw(12) << "Welded" << std::setw(12) << "KiB saved" << std::endl;
+
+    bool ok = true;
+    if (generatedFaces > 0) {
+        QTemporaryFile file;
+        if (!file.open() || !writeGridOBJ(file, generatedFaces)) {
+            std::cerr << "Benchmark OBJ generation failed!" << std::endl;
+            return 1;
+        }
+        file.close();
+        ok = benchmarkOBJFile(file.fileName(), QString("generated (%1 faces)").arg(generatedFaces));
+    }
+
+    for (const auto &path : paths) {
+        ok = benchmarkOBJFile(path, QFileInfo(path).fileName()) && ok;
+    }
+
+    return ok ? 0 : 1;
+}
+
+int benchmarkMeshCache(const QStringList &paths) {
+    struct Result {
+        QString name;
+        double cold;
+        double warm;
+        double pack;
+    };
+    std::vector<Result> results;
+    uint64_t touched = 0;
+
+    for (const auto &path : paths) {
+        QFile::remove(meshCachePath(path));
+
+        // Cold - parse OBJ and write cache
+        QElapsedTimer timer;
+        timer.start();
+        LoadedModel model;
+        if (!loadModel(path, model)) {
+            return 1;
+        }
+        double cold = static_cast<double>(timer.nsecsElapsed()) / 1e6;
+
+        // Warm - map cache (best of runs)
+        double warm = 0.0;
+        for (int run = 0; run < benchmarkRuns; ++run) {
+            timer.restart();
+            LoadedModel cached;
+            if (!loadModel(path, cached) || !cached.mapped) {
+                std::cerr << "Benchmark mesh cache mapping failed! [" << path.toStdString() << "]" << std::endl;
+                return 1;
+            }
+            touched += touchPages(reinterpret_cast<const uchar *>(cached.mapped->vertices()), cached.mapped->vertexCount() * sizeof(Vertex));
+            touched += touchPages(reinterpret_cast<const uchar *>(cached.mapped->indices()), cached.mapped->indexCount() * sizeof(GLuint));
+
+            double time = static_cast<double>(timer.nsecsElapsed()) / 1e6;
+            if (run == 0 || time < warm) warm = time;
+        }
+
+        // Opt-in packing (WidgetOpenGLDraw::quantizeVertices) converts a copy of mapped mesh before upload, otherwise it is uploaded as is
+        LoadedModel cached;
+        loadModel(path, cached);
+        timer.restart();
+        std::vector<PackedVertex> packedVertices;
+        std::vector<uint16_t> packedIndices;
+        packVertices(cached.mapped->vertices(), cached.mapped->vertexCount(), cached.mapped->boundingBoxMin(), cached.mapped->boundingBoxMax(), packedVertices);
+        if (cached.mapped->vertexCount() <= maxShortIndexVertices) {
+            packIndices(cached.mapped->indices(), cached.mapped->indexCount(), packedIndices);
+        }
+        double pack = static_cast<double>(timer.nsecsElapsed()) / 1e6;
+
+        results.push_back({QFileInfo(path).fileName(), cold, warm, pack});
+    }
+
+    std::cout << std::left << std::setw(24) << "File" << std::right << std::setw(12) << "Cold ms" << std::setw(12) << "Warm ms"
+              << std::setw(12) << "Speedup" << std::setw(12) << "Pack ms" << std::endl;
+    for (const auto &result : results) {
+        std::cout << std::left << std::setw(24) << result.name.toStdString() << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(12) << result.cold << std::setw(12) << result.warm
+                  << std::setw(11) << result.cold / std::max(result.warm, 1e-6) << "x" << std::setw(12) << result.pack << std::endl;
+    }
+    std::cout << "(" << touched << ")" << std::endl; // Keep page touching from being optimized away
+
+    return 0;
+}
+
+int benchmarkCulling(uint32_t objects) {
+    // Unit cubes with random rotations scattered around camera at origin
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+    std::uniform_real_distribution<float> angle(0.0f, glm::two_pi<float>());
+    CullingBounds bounds;
+    for (uint32_t i = 0; i < objects; ++i) {
+        glm::mat4 M = glm::translate(glm::mat4(1), glm::vec3(position(rng), position(rng), position(rng)));
+        M = glm::rotate(M, angle(rng), glm::normalize(glm::vec3(position(rng), position(rng), position(rng))));
+        glm::vec3 center, extent;
+        transformBounds(M, glm::vec3(-1.0f), glm::vec3(1.0f), center, extent);
+        bounds.push(center, extent);
+    }
+
+    std::cout << std::left << std::setw(12) << "Heading" << std::right << std::setw(12) << "Visible" << std::setw(12) << "Culled"
+              << std::setw(12) << "ms (best)" << std::setw(14) << "MObjects/s" << std::endl;
+
+    glm::mat4 P = glm::perspective(glm::radians(70.0f), 16.0f / 9.0f, 0.01f, 1000.0f);
+    std::vector<uint8_t> visible;
+    for (int heading = 0; heading < 360; heading += 45) {
+        float yaw = glm::radians(static_cast<float>(heading));
+        glm::mat4 V = glm::lookAt(glm::vec3(0.0f), glm::vec3(std::cos(yaw), 0.0f, std::sin(yaw)), glm::vec3(0.0f, 1.0f, 0.0f));
+        Frustum frustum(P * V);
+
+        double best = 0.0;
+        size_t visibleCount = 0;
+        for (int run = 0; run < benchmarkRuns; ++run) {
+            QElapsedTimer timer;
+            timer.start();
+            visibleCount = cullBounds(frustum, bounds, visible);
+            double time = static_cast<double>(timer.nsecsElapsed()) / 1e6;
+            if (run == 0 || time < best) best = time;
+        }
+
+        std::cout << std::left << std::setw(12) << heading << std::right << std::setw(12) << visibleCount
+                  << std::setw(12) << objects - visibleCount << std::fixed << std::setprecision(3)
+                  << std::setw(12) << best << std::setw(14) << objects / std::max(best / 1000.0, 1e-9) / 1e6 << std::endl;
+    }
+
+    return 0;
+}
+
+int benchmarkScene(uint32_t objects) {
+    std::cout << std::left << std::setw(12) << "Objects" << std::right << std::setw(12) << "Add ns" << std::setw(12) << "Remove ns"
+              << std::setw(14) << "Update ms" << std::setw(12) << "Cull ms" << std::setw(16) << "Stale" << std::setw(16) << "Valid" << std::endl;
+
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+    std::uniform_real_distribution<float> angle(0.0f, glm::two_pi<float>());
+    glm::mat4 PV = glm::perspective(glm::radians(70.0f), 16.0f / 9.0f, 0.01f, 1000.0f) * glm::lookAt(glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+    // Growing counts, time per operation stays flat if adding and removing are O(1)
+    const uint32_t counts[] = {std::max(objects / 100, 1u), std::max(objects / 10, 1u), objects};
+    for (uint32_t count : counts) {
+        Scene scene;
+        std::vector<ObjectHandle> handles(count);
+
+        // Material specular power tags objects, to check handles still find their object after removals moved others
+        QElapsedTimer timer;
+        timer.start();
+        for (uint32_t i = 0; i < count; ++i) {
+            Transform transform;
+            transform.translation = glm::vec3(position(rng), position(rng), position(rng));
+            transform.rotation = glm::vec3(angle(rng), angle(rng), angle(rng));
+            Material material;
+            material.specularPower = static_cast<float>(i);
+            handles[i] = scene.add(MeshObject(""), transform, material);
+            scene.setBounds(handles[i], glm::vec3(-1.0f), glm::vec3(1.0f));
+        }
+        double addTime = static_cast<double>(timer.nsecsElapsed());
+
+        // Per-frame passes over all objects moved (dense transform arrays, then culling of world bounds)
+        timer.restart();
+        scene.updateTransforms();
+        double updateTime = static_cast<double>(timer.nsecsElapsed()) / 1e6;
+        std::vector<uint8_t> visible;
+        timer.restart();
+        cullBounds(Frustum(PV), scene.transforms.worldBounds, visible);
+        double cullTime = static_cast<double>(timer.nsecsElapsed()) / 1e6;
+
+        // Half of objects removed in random order
+        std::vector<uint32_t> order(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            order[i] = i;
+        }
+        std::shuffle(order.begin(), order.end(), rng);
+        size_t removedCount = count / 2;
+        timer.restart();
+        for (size_t i = 0; i < removedCount; ++i) {
+            scene.remove(handles[order[i]]);
+        }
+        double removeTime = static_cast<double>(timer.nsecsElapsed());
+
+        // Slots are reused by new objects, stale handles must not find them
+        for (size_t i = 0; i < removedCount; ++i) {
+            scene.add(MeshObject(""));
+        }
+        size_t stale = 0, valid = 0;
+        for (size_t i = 0; i < count; ++i) {
+            Material *material = scene.material(handles[order[i]]);
+            if (i < removedCount) {
+                stale += material == nullptr;
+            } else {
+                valid += material != nullptr && material->specularPower == static_cast<float>(order[i]);
+            }
+        }
+
+        std::cout << std::left << std::setw(12) << count << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(12) << addTime / count << std::setw(12) << removeTime / std::max<size_t>(removedCount, 1)
+                  << std::setprecision(3) << std::setw(14) << updateTime << std::setw(12) << cullTime
+                  << std::setw(16) << std::to_string(stale) + "/" + std::to_string(removedCount)
+                  << std::setw(16) << std::to_string(valid) + "/" + std::to_string(count - removedCount) << std::endl;
+    }
+
+    return 0;
+}
+
+int benchmarkPyramid() {
+    // Generators only, widget is never shown (no OpenGL context)
+    WidgetOpenGLDraw widget(nullptr);
+
+    std::cout << std::left << std::setw(8) << "Rows" << std::setw(12) << "Variant" << std::right << std::setw(12) << "Triangles" << std::setw(12) << "Vertices"
+              << std::setw(12) << "Instances" << std::setw(12) << "Build ms" << std::setw(14) << "Buffers KiB" << std::endl;
+
+    const char *variantNames[] = {"Stamped", "Greedy", "Instanced"};
+    const uint32_t rowCounts[] = {10, 25, 50, 100, 200};
+    for (uint32_t rows : rowCounts) {
+        for (int variant = 0; variant < 3; ++variant) {
+            // Stamped cubes of bigger pyramids take gigabytes
+            if (variant == 0 && rows > 100) {
+                continue;
+            }
+
+            QElapsedTimer timer;
+            timer.start();
+            MeshObject pyramid = variant == 0 ? stampedPyramid(widget, rows) : (variant == 1 ? widget.makePyramid(rows, "", false) : widget.makePyramidInstanced(rows));
+            double time = static_cast<double>(timer.nsecsElapsed()) / 1e6;
+
+            // Same sizes as uploaded by generateObjectBuffers()
+            GLenum indexType = widget.quantizeVertices && pyramid.vertexCount() <= maxShortIndexVertices ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+            size_t bytes = pyramid.vertexCount() * (widget.quantizeVertices ? sizeof(PackedVertex) : sizeof(Vertex)) +
+                           pyramid.indexCount() * indexTypeSize(indexType) + pyramid.instances.size() * sizeof(InstanceData);
+            size_t triangles = pyramid.indexCount() / 3 * std::max<size_t>(pyramid.instances.size(), 1);
+            std::cout << std::left << std::setw(8) << rows << std::setw(12) << variantNames[variant] << std::right
+                      << std::setw(12) << triangles << std::setw(12) << pyramid.vertexCount() << std::setw(12) << pyramid.instances.size()
+                      << std::fixed << std::setprecision(2) << std::setw(12) << time << std::setw(14) << bytes / 1024.0 << std::endl;
+        }
+    }
+
+    return 0;
+}
+
+int benchmarkMeshAllocator(uint32_t meshes) {
+    // Vertex counts of mixed meshes, mostly cubes, some models and a few dense scans
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<int> kind(0, 9);
+    std::uniform_int_distribution<size_t> model(2000, 4000);
+    std::uniform_int_distribution<size_t> scan(50000, 100000);
+    auto meshSize = [&]() -> size_t {
+        int k = kind(rng);
+        return k < 6 ? 14 : (k < 9 ? model(rng) : scan(rng));
+    };
+
+    // Same policy as MeshBuffer: compact if fragmented, double capacity (compacting) if full
+    FreeListAllocator allocator;
+    std::vector<std::pair<size_t, size_t>> live; // Offset, size
+    uint32_t compactions = 0, grows = 0;
+    auto compact = [&](size_t capacity) {
+        allocator.reset(capacity);
+        for (auto &mesh : live) {
+            allocator.allocate(mesh.second, mesh.first);
+        }
+    };
+    auto add = [&](size_t size) {
+        size_t offset;
+        if (!allocator.allocate(size, offset)) {
+            size_t capacity = allocator.capacity();
+            if (capacity - allocator.used() >= size) {
+                ++compactions;
+            } else {
+                while (capacity - allocator.used() < size) {
+                    capacity *= 2;
+                }
+                ++grows;
+            }
+            compact(capacity);
+            allocator.allocate(size, offset);
+        }
+        live.emplace_back(offset, size);
+    };
+
+    allocator.reset(1 << 16);
+    for (uint32_t i = 0; i < meshes; ++i) {
+        add(meshSize());
+    }
+
+    std::cout << std::left << std::setw(8) << "Round" << std::right << std::setw(12) << "Meshes" << std::setw(12) << "Used %"
+              << std::setw(14) << "Free Blocks" << std::setw(12) << "Fragment." << std::setw(14) << "Compactions"
+              << std::setw(8) << "Grows" << std::setw(12) << "ns/op" << std::endl;
+
+    // Each round removes and adds a quarter of meshes
+    for (int round = 0; round <= 10; ++round) {
+        QElapsedTimer timer;
+        timer.start();
+        size_t operations = 0;
+        if (round > 0) {
+            for (size_t i = 0; i < live.size() / 4; ++i) {
+                std::uniform_int_distribution<size_t> pick(0, live.size() - 1);
+                size_t index = pick(rng);
+                allocator.free(live[index].first, live[index].second);
+                live[index] = live.back();
+                live.pop_back();
+                add(meshSize());
+                operations += 2;
+            }
+        }
+        double time = static_cast<double>(timer.nsecsElapsed());
+
+        std::cout << std::left << std::setw(8) << round << std::right << std::setw(12) << live.size() << std::fixed << std::setprecision(1)
+                  << std::setw(12) << 100.0 * allocator.used() / allocator.capacity() << std::setw(14) << allocator.freeBlocks()
+                  << std::setprecision(3) << std::setw(12) << allocator.fragmentation() << std::setw(14) << compactions << std::setw(8) << grows
+                  << std::setprecision(1) << std::setw(12) << (operations > 0 ? time / operations : 0.0) << std::endl;
+    }
+
+    return 0;
+}
+
+int benchmarkVertexCache(const QStringList &paths) {
+    // Meshes in original order (OBJ parse order, pyramid face generation order)
+    struct Mesh {
+        QString name;
+        std::vector<Vertex> vertices;
+        std::vector<GLuint> indices;
+    };
+    std::vector<Mesh> meshes;
+    for (const auto &path : paths) {
+        meshes.emplace_back();
+        meshes.back().name = QFileInfo(path).fileName();
+        if (!loadOBJ(path, meshes.back().vertices, meshes.back().indices)) {
+            std::cerr << "Model OBJ file parsing failed! [" << path.toStdString() << "]" << std::endl;
+            return 1;
+        }
+    }
+    WidgetOpenGLDraw widget(nullptr); // Generators only
+    const uint32_t rowCounts[] = {10, 50};
+    for (uint32_t rows : rowCounts) {
+        MeshObject pyramid = widget.makePyramid(rows, "", false);
+        meshes.push_back({QString("pyramid (%1 rows)").arg(rows), pyramid.vertices, pyramid.indices});
+    }
+
+    std::cout << "Vertex cache size " << vertexCacheSize << " (FIFO)" << std::endl;
+    std::cout << std::left << std::setw(24) << "Mesh" << std::right << std::setw(12) << "Triangles" << std::setw(12) << "ACMR"
+              << std::setw(12) << "Optimized" << std::setw(12) << "ATVR" << std::setw(12) << "Optimized" << std::setw(12) << "ms" << std::endl;
+
+    for (auto &mesh : meshes) {
+        VertexCacheStats before = analyzeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size());
+
+        QElapsedTimer timer;
+        timer.start();
+        optimizeMesh(mesh.vertices, mesh.indices);
+        double time = static_cast<double>(timer.nsecsElapsed()) / 1e6;
+
+        VertexCacheStats after = analyzeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size());
+        std::cout << std::left << std::setw(24) << mesh.name.toStdString() << std::right << std::setw(12) << mesh.indices.size() / 3
+                  << std::fixed << std::setprecision(3) << std::setw(12) << before.acmr << std::setw(12) << after.acmr
+                  << std::setw(12) << before.atvr << std::setw(12) << after.atvr << std::setprecision(2) << std::setw(12) << time << std::endl;
+    }
+
+    return 0;
+}
+
+int benchmarkLevelsOfDetail(const QStringList &paths) {
+    struct Model {
+        QString name;
+        std::vector<Vertex> vertices;
+        std::vector<GLuint> indices;
+        std::vector<GLuint> levelIndices;
+        std::vector<MeshLevel> levels;
+        float radius = 0.0f;
+    };
+    std::vector<Model> models;
+    for (const auto &path : paths) {
+        models.emplace_back();
+        models.back().name = QFileInfo(path).fileName();
+        if (!loadOBJ(path, models.back().vertices, models.back().indices)) {
+            std::cerr << "Model OBJ file parsing failed! [" << path.toStdString() << "]" << std::endl;
+            return 1;
+        }
+    }
+    if (models.empty()) {
+        models.emplace_back();
+        models.back().name = "generated sphere";
+        makeSphere(512, 1.0f, models.back().vertices, models.back().indices);
+    }
+
+    std::cout << std::left << std::setw(24) << "Model" << std::setw(8) << "Level" << std::right << std::setw(12) << "Triangles"
+              << std::setw(16) << "Error (% r)" << std::setw(12) << "Build ms" << std::endl;
+
+    for (auto &model : models) {
+        for (const auto &vertex : model.vertices) {
+            model.radius = std::max(model.radius, glm::length(vertex.position));
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+        generateLevels(model.vertices.data(), model.vertices.size(), model.indices.data(), model.indices.size(), model.levelIndices, model.levels);
+        double time = static_cast<double>(timer.nsecsElapsed()) / 1e6;
+
+        for (size_t level = 0; level < model.levels.size(); ++level) {
+            std::cout << std::left << std::setw(24) << (level == 0 ? model.name.toStdString() : "") << std::setw(8) << level << std::right
+                      << std::setw(12) << model.levels[level].indexCount / 3 << std::fixed << std::setprecision(4)
+                      << std::setw(16) << 100.0f * model.levels[level].error / std::max(model.radius, 1e-6f) << std::setprecision(2);
+            if (level == 0) {
+                std::cout << std::setw(12) << time;
+            }
+            std::cout << std::endl;
+        }
+    }
+
+    // Every model scaled to 1 m radius, placed at 1 - 500 m (1080p, 70 degree field of view, 1 pixel error)
+    const int copies = 1000;
+    const float height = 1080.0f;
+    const float tanHalfFov = std::tan(glm::radians(70.0f) / 2.0f);
+    std::cout << std::endl << std::left << std::setw(24) << "Scene (1000 copies)" << std::right << std::setw(16) << "Triangles"
+              << std::setw(16) << "With LOD" << std::setw(10) << "Ratio" << std::endl;
+    for (const auto &model : models) {
+        uint64_t full = 0, reduced = 0;
+        for (int i = 0; i < copies; ++i) {
+            float distance = std::pow(500.0f, static_cast<float>(i) / (copies - 1));
+            float tolerance = 2.0f * std::max(distance - 1.0f, 0.01f) * tanHalfFov / height * model.radius;
+            uint32_t level = selectLevel(model.levels, 0, tolerance);
+            full += model.levels[0].indexCount / 3;
+            reduced += model.levels[level].indexCount / 3;
+        }
+        std::cout << std::left << std::setw(24) << model.name.toStdString() << std::right << std::setw(16) << full
+                  << std::setw(16) << reduced << std::fixed << std::setprecision(2) << std::setw(9)
+                  << static_cast<double>(full) / std::max<uint64_t>(reduced, 1) << "x" << std::endl;
+    }
+
+    return 0;
+}
+
+int benchmarkQuantization(const QStringList &paths) {
+    std::vector<LoadedModel> models;
+    if (!benchmarkModels(paths, models)) {
+        return 1;
+    }
+
+    std::cout << std::left << std::setw(24) << "Model" << std::right << std::setw(12) << "Vertices" << std::setw(12) << "Float KiB"
+              << std::setw(12) << "Packed KiB" << std::setw(8) << "Index" << std::setw(10) << "UV"
+              << std::setw(14) << "Pos max %" << std::setw(14) << "Pos mean %" << std::setw(12) << "UV max"
+              << std::setw(12) << "Normal max" << std::setw(12) << "Normal mean" << std::endl;
+
+    for (const auto &model : models) {
+        glm::vec3 min, max;
+        boundingBox(model.vertices, min, max);
+        std::vector<PackedVertex> packed;
+        VertexFormat format = packVertices(model.vertices.data(), model.vertices.size(), min, max, packed);
+        QuantizationError error = measureQuantizationError(model.vertices.data(), model.vertices.size(), packed.data(), format, min, max);
+
+        // Same choices as generateObjectBuffers()
+        GLenum indexType = model.vertices.size() <= maxShortIndexVertices ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+        size_t floatBytes = model.vertices.size() * sizeof(Vertex) + model.indices.size() * sizeof(GLuint);
+        size_t packedBytes = model.vertices.size() * sizeof(PackedVertex) + model.indices.size() * indexTypeSize(indexType);
+        float diagonal = std::max(glm::length(max - min), 1e-6f);
+
+        std::cout << std::left << std::setw(24) << model.path.toStdString() << std::right << std::setw(12) << model.vertices.size()
+                  << std::fixed << std::setprecision(1) << std::setw(12) << floatBytes / 1024.0 << std::setw(12) << packedBytes / 1024.0
+                  << std::setw(8) << (indexType == GL_UNSIGNED_SHORT ? "16" : "32")
+                  << std::setw(10) << (format == VERTEX_FORMAT_PACKED_UNORM_UV ? "unorm16" : "half")
+                  << std::setprecision(5) << std::setw(14) << 100.0f * error.maxPosition / diagonal << std::setw(14) << 100.0f * error.meanPosition / diagonal
+                  << std::setprecision(6) << std::setw(12) << error.maxUV
+                  << std::setprecision(3) << std::setw(12) << error.maxNormalAngle << std::setw(12) << error.meanNormalAngle << std::endl;
+    }
+    std::cout << "Position error relative to bounding box diagonal, normal error in degrees" << std::endl;
+
+    return 0;
+}
+
+int benchmarkVertexFormats(const QStringList &paths) {
+    std::vector<LoadedModel> models;
+    if (!benchmarkModels(paths, models)) {
+        return 1;
+    }
+
+    QOffscreenSurface surface;
+    surface.setFormat(QSurfaceFormat::defaultFormat());
+    surface.create();
+    QOpenGLContext context;
+    context.setFormat(QSurfaceFormat::defaultFormat());
+    if (!context.create() || !context.makeCurrent(&surface)) {
+        std::cerr << "Benchmark OpenGL context creation failed!" << std::endl;
+        return 1;
+    }
+
+    QOpenGLFunctions_3_3_Core gl;
+    gl.initializeOpenGLFunctions();
+    std::cout << gl.glGetString(GL_RENDERER) << std::endl;
+
+    // Small target, so vertex fetch and transform dominate over rasterization
+    const int width = 320, height = 180;
+    QOpenGLFramebufferObject fbo(width, height, QOpenGLFramebufferObject::Depth);
+    fbo.bind();
+    gl.glViewport(0, 0, width, height);
+    gl.glEnable(GL_DEPTH_TEST);
+
+    // Instances in a grid in front of camera, packed positions and normals are decoded like in scene shader
+    const GLchar *vertexSource = R"glsl(
+        #version 330 core
+        layout(location = 0) in vec3 position;
+        layout(location = 1) in vec2 uv;
+        layout(location = 2) in vec4 normal;
+        uniform mat4 VP;
+        uniform vec3 PositionOffset;
+        uniform vec3 PositionScale;
+        uniform float Radius;
+        uniform bool Packed;
+        out vec3 Color;
+        vec3 decodeOctahedral(vec2 e) {
+            vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+            float t = max(-n.z, 0.0);
+            n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+            return normalize(n);
+        }
+        void main() {
+            vec3 grid = vec3(gl_InstanceID % 16, (gl_InstanceID / 16) % 16, gl_InstanceID / 256) - vec3(7.5, 7.5, 0.0);
+            gl_Position = VP * vec4((PositionOffset + position * PositionScale) / Radius + grid * 2.5, 1.0);
+            vec3 objectNormal = Packed ? decodeOctahedral(normal.xy * 2.0 - 1.0) : normal.xyz;
+            Color = objectNormal * 0.5 + 0.5 + vec3(uv, 0.0) * 0.001;
+        }
+    )glsl";
+    const GLchar *fragmentSource = R"glsl(
+        #version 330 core
+        in vec3 Color;
+        out vec4 color;
+        void main() {
+            color = vec4(Color, 1.0);
+        }
+    )glsl";
+
+    GLuint program = gl.glCreateProgram();
+    GLuint shaders[2] = {gl.glCreateShader(GL_VERTEX_SHADER), gl.glCreateShader(GL_FRAGMENT_SHADER)};
+    gl.glShaderSource(shaders[0], 1, &vertexSource, nullptr);
+    gl.glShaderSource(shaders[1], 1, &fragmentSource, nullptr);
+    for (GLuint shader : shaders) {
+        gl.glCompileShader(shader);
+        gl.glAttachShader(program, shader);
+    }
+    gl.glLinkProgram(program);
+    gl.glUseProgram(program);
+
+    glm::mat4 VP = glm::perspective(glm::radians(70.0f), static_cast<float>(width) / height, 0.1f, 1000.0f) *
+                   glm::lookAt(glm::vec3(0.0f, 0.0f, -25.0f), glm::vec3(0.0f, 0.0f, 10.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    gl.glUniformMatrix4fv(gl.glGetUniformLocation(program, "VP"), 1, GL_FALSE, glm::value_ptr(VP));
+
+    const GLsizei instances = 1024;
+    GLuint query;
+    gl.glGenQueries(1, &query);
+
+    std::cout << std::left << std::setw(24) << "Model" << std::setw(24) << "Layout" << std::right << std::setw(14) << "Bytes/Vertex"
+              << std::setw(14) << "MiB/Frame" << std::setw(12) << "ms (best)" << std::endl;
+
+    for (const auto &model : models) {
+        glm::vec3 min, max;
+        boundingBox(model.vertices, min, max);
+        float radius = std::max(glm::length(max - min) / 2.0f, 1e-6f);
+        std::vector<PackedVertex> packed;
+        VertexFormat packedFormat = packVertices(model.vertices.data(), model.vertices.size(), min, max, packed);
+        std::vector<uint16_t> shortIndices;
+        packIndices(model.indices.data(), model.indices.size(), shortIndices);
+        bool shortFits = model.vertices.size() <= maxShortIndexVertices;
+
+        // Every layout stored in its own mesh buffer range, drawn with the format's VAO
+        struct Layout {
+            const char *name;
+            VertexFormat format;
+            GLenum indexType;
+        };
+        std::vector<Layout> layouts = {{"Float, 32-bit index", VERTEX_FORMAT_FLOAT, GL_UNSIGNED_INT},
+                                       {"Packed, 32-bit index", packedFormat, GL_UNSIGNED_INT}};
+        if (shortFits) {
+            layouts.push_back({"Float, 16-bit index", VERTEX_FORMAT_FLOAT, GL_UNSIGNED_SHORT});
+            layouts.push_back({"Packed, 16-bit index", packedFormat, GL_UNSIGNED_SHORT});
+        }
+
+        MeshBuffer meshBuffer;
+        meshBuffer.initialize(&gl);
+        for (size_t i = 0; i < layouts.size(); ++i) {
+            const Layout &layout = layouts[i];
+            const void *vertices = layout.format == VERTEX_FORMAT_FLOAT ? static_cast<const void *>(model.vertices.data()) : packed.data();
+            const void *indices = layout.indexType == GL_UNSIGNED_SHORT ? static_cast<const void *>(shortIndices.data()) : model.indices.data();
+            uint32_t handle = meshBuffer.add(layout.format, vertices, model.vertices.size(), layout.indexType, indices, model.indices.size());
+            const MeshRange &range = meshBuffer.range(handle);
+
+            glm::vec3 offset(0.0f), scale(1.0f);
+            if (layout.format != VERTEX_FORMAT_FLOAT) {
+                offset = min;
+                scale = max - min;
+            }
+            gl.glUniform3fv(gl.glGetUniformLocation(program, "PositionOffset"), 1, glm::value_ptr(offset));
+            gl.glUniform3fv(gl.glGetUniformLocation(program, "PositionScale"), 1, glm::value_ptr(scale));
+            gl.glUniform1f(gl.glGetUniformLocation(program, "Radius"), radius);
+            gl.glUniform1i(gl.glGetUniformLocation(program, "Packed"), layout.format != VERTEX_FORMAT_FLOAT);
+            gl.glBindVertexArray(meshBuffer.VAO(layout.format));
+
+            double best = 0.0;
+            for (int run = 0; run <= benchmarkRuns; ++run) {
+                gl.glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                gl.glBeginQuery(GL_TIME_ELAPSED, query);
+                gl.glDrawElementsInstancedBaseVertex(GL_TRIANGLES, range.indexCount, range.indexType,
+                                                     reinterpret_cast<const void *>(range.firstIndex * indexTypeSize(range.indexType)), instances, range.baseVertex);
+                gl.glEndQuery(GL_TIME_ELAPSED);
+
+                GLuint64 elapsed = 0;
+                gl.glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+                double time = static_cast<double>(elapsed) / 1e6;
+                if (run == 1 || time < best) best = time; // First run is warm up
+            }
+
+            // Vertex and index data read by all instances (upper bound, ignores post-transform cache hits)
+            double bytes = static_cast<double>(model.vertices.size() * vertexFormatSize(layout.format) + model.indices.size() * indexTypeSize(layout.indexType)) * instances;
+            std::cout << std::left << std::setw(24) << (i == 0 ? model.path.toStdString() : "") << std::setw(24) << layout.name << std::right
+                      << std::setw(14) << vertexFormatSize(layout.format) << std::fixed << std::setprecision(2)
+                      << std::setw(14) << bytes / (1024.0 * 1024.0) << std::setprecision(3) << std::setw(12) << best << std::endl;
+        }
+        gl.glBindVertexArray(0);
+        meshBuffer.destroy();
+    }
+
+    gl.glDeleteQueries(1, &query);
+    gl.glDeleteProgram(program);
+    gl.glDeleteShader(shaders[0]);
+    gl.glDeleteShader(shaders[1]);
+    fbo.release();
+    context.doneCurrent();
+
+    return 0;
+}
+
+int benchmarkFrames(const FrameBenchmarkOptions &options) {
+    QOffscreenSurface surface;
+    surface.setFormat(QSurfaceFormat::defaultFormat());
+    surface.create();
+    QOpenGLContext context;
+    context.setFormat(QSurfaceFormat::defaultFormat());
+    if (!context.create() || !context.makeCurrent(&surface)) {
+        std::cerr << "Benchmark OpenGL context creation failed!" << std::endl;
+        return 1;
+    }
+
+    QOpenGLFunctions_3_3_Core gl;
+    gl.initializeOpenGLFunctions();
+
+    if (!options.dumpDirectory.isEmpty() && !QDir().mkpath(options.dumpDirectory)) {
+        std::cerr << "Benchmark frame directory creation failed! [" << options.dumpDirectory.toStdString() << "]" << std::endl;
+        return 1;
+    }
+
+    QOpenGLFramebufferObjectFormat fboFormat;
+    fboFormat.setAttachment(QOpenGLFramebufferObject::Depth);
+    QOpenGLFramebufferObject fbo(options.width, options.height, fboFormat);
+    fbo.bind();
+
+    // Widget renders into bound framebuffer with current context, it is never shown (scene of initializeGL() and scaled-up variants)
+    QComboBox objectSelection;
+    {
+        WidgetOpenGLDraw widget(nullptr);
+        widget.objectSelection = &objectSelection;
+        widget.quantizeVertices = options.packedVertices;
+        widget.initializeOffscreen(options.width, options.height);
+        widget.deferredShading = options.deferred;
+        if (options.sceneScale > 0) {
+            widget.addBenchmarkObjects(options.sceneScale);
+        }
+
+        // Double buffered GPU timer queries, results of previous frame are read while current one is drawn
+        GLuint queries[2];
+        gl.glGenQueries(2, queries);
+
+        const uint32_t warmupFrames = 5;
+        const float pathRadius = 15.0f + 10.0f * options.sceneScale;
+        std::vector<double> cpuTimes, gpuTimes;
+        uint64_t drawCalls = 0, triangles = 0, stateChanges = 0, uploadedBytes = 0;
+
+        // Pass times from widget's profiler (a few frames behind, frames with results still in flight at the end are not included)
+        struct PassTotals {
+            double cpuTime = 0.0;
+            double gpuTime = 0.0;
+        };
+        std::map<std::string, PassTotals> passes;
+        uint32_t profiledFrames = 0;
+        uint64_t lastProfiled = 0;
+        for (uint32_t frame = 0; frame < warmupFrames + options.frames; ++frame) {
+            // Orbit around origin, bobbing up and down, looking at origin
+            float t = static_cast<float>(frame) / std::max<uint32_t>(warmupFrames + options.frames, 1);
+            float angle = glm::two_pi<float>() * t;
+            glm::vec3 position(std::sin(angle) * pathRadius, 5.0f + 3.0f * std::sin(2.0f * angle), std::cos(angle) * pathRadius);
+            glm::vec3 front = glm::normalize(-position);
+            widget.setCamera(position, glm::degrees(std::asin(front.y)), glm::degrees(std::atan2(front.x, front.z)));
+
+            QElapsedTimer timer;
+            timer.start();
+            gl.glBeginQuery(GL_TIME_ELAPSED, queries[frame % 2]);
+            widget.renderOffscreen();
+            gl.glEndQuery(GL_TIME_ELAPSED);
+            double cpuTime = static_cast<double>(timer.nsecsElapsed()) / 1e6;
+
+            if (frame > warmupFrames) {
+                GLuint64 elapsed = 0;
+                gl.glGetQueryObjectui64v(queries[(frame - 1) % 2], GL_QUERY_RESULT, &elapsed);
+                gpuTimes.push_back(static_cast<double>(elapsed) / 1e6);
+            }
+            if (frame >= warmupFrames) {
+                cpuTimes.push_back(cpuTime);
+                drawCalls += widget.renderStats().drawCalls;
+                triangles += widget.renderStats().triangles;
+
+                const FrameProfile &profile = widget.frameProfile();
+                if (profile.frame >= warmupFrames && profile.frame != lastProfiled) {
+                    for (const auto &scope : profile.scopes) {
+                        PassTotals &totals = passes[scope.name];
+                        totals.cpuTime += scope.cpuTime;
+                        totals.gpuTime += scope.gpuTime;
+                    }
+                    stateChanges += profile.stateChanges;
+                    uploadedBytes += profile.uploadedBytes;
+                    lastProfiled = profile.frame;
+                    ++profiledFrames;
+                }
+
+                if (!options.dumpDirectory.isEmpty()) {
+                    QString path = QDir(options.dumpDirectory).filePath(QString("frame_%1.png").arg(frame - warmupFrames, 5, 10, QChar('0')));
+                    if (!fbo.toImage().save(path)) {
+                        std::cerr << "Benchmark frame saving failed! [" << path.toStdString() << "]" << std::endl;
+                    }
+                }
+            }
+        }
+
+        // Last frame's query
+        if (options.frames > 0) {
+            GLuint64 elapsed = 0;
+            gl.glGetQueryObjectui64v(queries[(warmupFrames + options.frames - 1) % 2], GL_QUERY_RESULT, &elapsed);
+            gpuTimes.push_back(static_cast<double>(elapsed) / 1e6);
+        }
+        gl.glDeleteQueries(2, queries);
+
+        QJsonObject report;
+        report["renderer"] = QString(reinterpret_cast<const char *>(gl.glGetString(GL_RENDERER)));
+        report["width"] = options.width;
+        report["height"] = options.height;
+        report["frames"] = static_cast<int>(options.frames);
+        report["sceneScale"] = static_cast<int>(options.sceneScale);
+        report["shading"] = options.deferred ? "deferred" : "forward";
+        report["objects"] = static_cast<int>(widget.objectCount());
+        report["cpuFrameMs"] = frameTimeStats(cpuTimes);
+        report["gpuFrameMs"] = frameTimeStats(gpuTimes);
+        report["avgDrawCalls"] = options.frames > 0 ? static_cast<double>(drawCalls) / options.frames : 0.0;
+        report["avgTriangles"] = options.frames > 0 ? static_cast<double>(triangles) / options.frames : 0.0;
+        report["shaderVariants"] = static_cast<int>(widget.shaderVariantStats().live);
+
+        QJsonObject passReport;
+        for (const auto &pass : passes) {
+            QJsonObject times;
+            times["cpuAvgMs"] = pass.second.cpuTime / std::max<uint32_t>(profiledFrames, 1);
+            times["gpuAvgMs"] = pass.second.gpuTime / std::max<uint32_t>(profiledFrames, 1);
+            passReport[QString::fromStdString(pass.first)] = times;
+        }
+        report["passes"] = passReport;
+        report["profiledFrames"] = static_cast<int>(profiledFrames);
+        report["avgStateChanges"] = profiledFrames > 0 ? static_cast<double>(stateChanges) / profiledFrames : 0.0;
+        report["avgUploadedBytes"] = profiledFrames > 0 ? static_cast<double>(uploadedBytes) / profiledFrames : 0.0;
+
+        QByteArray json = QJsonDocument(report).toJson();
+        if (options.outputPath.isEmpty()) {
+            std::cout << json.toStdString();
+        } else {
+            QFile file(options.outputPath);
+            if (!file.open(QIODevice::WriteOnly) || file.write(json) != json.size()) {
+                std::cerr << "Benchmark report writing failed! [" << options.outputPath.toStdString() << "]" << std::endl;
+                return 1;
+            }
+        }
+    } // Widget releases its GL objects while context is still current
+
+    fbo.release();
+    context.doneCurrent();
+
+    return 0;
+}
+
+int benchmarkLights(uint32_t maxLights) {
+    QOffscreenSurface surface;
+    surface.setFormat(QSurfaceFormat::defaultFormat());
+    surface.create();
+    QOpenGLContext context;
+    context.setFormat(QSurfaceFormat::defaultFormat());
+    if (!context.create() || !context.makeCurrent(&surface)) {
+        std::cerr << "Benchmark OpenGL context creation failed!" << std::endl;
+        return 1;
+    }
+
+    QOpenGLFunctions_3_3_Core gl;
+    gl.initializeOpenGLFunctions();
+
+    const int width = 1280;
+    const int height = 720;
+    QOpenGLFramebufferObjectFormat fboFormat;
+    fboFormat.setAttachment(QOpenGLFramebufferObject::Depth);
+    QOpenGLFramebufferObject fbo(width, height, fboFormat);
+    fbo.bind();
+
+    // Light counts grow 4x up to given count, lights are added to the same scene
+    std::vector<uint32_t> counts;
+    for (uint32_t count = 1; count < maxLights; count *= 4) {
+        counts.push_back(count);
+    }
+    counts.push_back(std::max(maxLights, 1u));
+
+    std::cout << std::right << std::setw(8) << "Lights" << std::setw(10) << "Visible" << std::setw(14) << "Avg/Cluster"
+              << std::setw(14) << "Max/Cluster" << std::setw(14) << "Build ms" << std::setw(12) << "CPU ms" << std::setw(12) << "GPU ms" << std::endl;
+
+    QComboBox objectSelection;
+    {
+        WidgetOpenGLDraw widget(nullptr);
+        widget.objectSelection = &objectSelection;
+        widget.initializeOffscreen(width, height);
+        widget.addBenchmarkObjects(1);
+        widget.setCamera(glm::vec3(0.0f, 12.0f, 24.0f), -25.0f, 180.0f);
+
+        GLuint query;
+        gl.glGenQueries(1, &query);
+
+        const uint32_t warmupFrames = 5;
+        const uint32_t frames = 50;
+        for (uint32_t count : counts) {
+            // Small lights spread over scene, so clusters receive a realistic share of them
+            if (count > widget.lights.size()) {
+                widget.addScatteredLights(static_cast<uint32_t>(count - widget.lights.size()), 15.0f, 0.25f);
+            }
+
+            double buildTime = 0.0, cpuTime = 0.0, gpuTime = 0.0;
+            for (uint32_t frame = 0; frame < warmupFrames + frames; ++frame) {
+                QElapsedTimer timer;
+                timer.start();
+                gl.glBeginQuery(GL_TIME_ELAPSED, query);
+                widget.renderOffscreen();
+                gl.glEndQuery(GL_TIME_ELAPSED);
+                double time = static_cast<double>(timer.nsecsElapsed()) / 1e6;
+
+                GLuint64 elapsed = 0;
+                gl.glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+                if (frame >= warmupFrames) {
+                    cpuTime += time;
+                    gpuTime += static_cast<double>(elapsed) / 1e6;
+                    buildTime += widget.lightClusterStats().buildTime;
+                }
+            }
+
+            const ClusterStats &stats = widget.lightClusterStats();
+            double averageLights = stats.occupiedClusters > 0 ? static_cast<double>(stats.assignments) / stats.occupiedClusters : 0.0;
+            std::cout << std::setw(8) << stats.lights << std::setw(10) << stats.visibleLights << std::fixed << std::setprecision(2)
+                      << std::setw(14) << averageLights << std::setw(14) << stats.maxClusterLights << std::setprecision(3)
+                      << std::setw(14) << buildTime / frames << std::setw(12) << cpuTime / frames << std::setw(12) << gpuTime / frames << std::endl;
+        }
+
+        gl.glDeleteQueries(1, &query);
+    } // Widget releases its GL objects while context is still current
+
+    fbo.release();
+    context.doneCurrent();
+
+    return 0;
+}
+
+int benchmarkShading(uint32_t maxLights) {
+    QOffscreenSurface surface;
+    surface.setFormat(QSurfaceFormat::defaultFormat());
+    surface.create();
+    QOpenGLContext context;
+    context.setFormat(QSurfaceFormat::defaultFormat());
+    if (!context.create() || !context.makeCurrent(&surface)) {
+        std::cerr << "Benchmark OpenGL context creation failed!" << std::endl;
+        return 1;
+    }
+
+    QOpenGLFunctions_3_3_Core gl;
+    gl.initializeOpenGLFunctions();
+
+    const int width = 1280;
+    const int height = 720;
+    QOpenGLFramebufferObjectFormat fboFormat;
+    fboFormat.setAttachment(QOpenGLFramebufferObject::Depth);
+    QOpenGLFramebufferObject fbo(width, height, fboFormat);
+    fbo.bind();
+
+    // Light counts grow 4x up to given count, lights are added to the same scene
+    std::vector<uint32_t> counts;
+    for (uint32_t count = 1; count < maxLights; count *= 4) {
+        counts.push_back(count);
+    }
+    counts.push_back(std::max(maxLights, 1u));
+
+    std::cout << std::right << std::setw(8) << "Lights" << std::setw(12) << "Shading" << std::setw(12) << "CPU ms" << std::setw(12) << "GPU ms"
+              << std::setw(14) << "Lighting ms" << std::endl;
+
+    QComboBox objectSelection;
+    {
+        WidgetOpenGLDraw widget(nullptr);
+        widget.objectSelection = &objectSelection;
+        widget.initializeOffscreen(width, height);
+        widget.addBenchmarkObjects(1);
+
+        // Camera inside a dense cloud of cubes, most fragments are hidden behind nearer ones
+        widget.setCamera(glm::vec3(0.0f, 2.0f, 0.0f), 0.0f, 180.0f);
+        widget.addScatteredCubes(3000, 12.0f);
+
+        GLuint query;
+        gl.glGenQueries(1, &query);
+
+        const uint32_t warmupFrames = 5;
+        const uint32_t frames = 50;
+        for (uint32_t count : counts) {
+            if (count > widget.lights.size()) {
+                widget.addScatteredLights(static_cast<uint32_t>(count - widget.lights.size()), 15.0f, 0.25f);
+            }
+
+            for (bool deferred : {false, true}) {
+                widget.deferredShading = deferred;
+
+                // Lighting is shading in fragments of draws (forward) or lighting pass (deferred), from profiler
+                double cpuTime = 0.0, gpuTime = 0.0, lightingTime = 0.0;
+                uint32_t profiledFrames = 0;
+                uint64_t lastProfiled = 0;
+                for (uint32_t frame = 0; frame < warmupFrames + frames; ++frame) {
+                    QElapsedTimer timer;
+                    timer.start();
+                    gl.glBeginQuery(GL_TIME_ELAPSED, query);
+                    widget.renderOffscreen();
+                    gl.glEndQuery(GL_TIME_ELAPSED);
+                    double time = static_cast<double>(timer.nsecsElapsed()) / 1e6;
+
+                    GLuint64 elapsed = 0;
+                    gl.glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+                    if (frame < warmupFrames) {
+                        continue;
+                    }
+                    cpuTime += time;
+                    gpuTime += static_cast<double>(elapsed) / 1e6;
+
+                    const FrameProfile &profile = widget.frameProfile();
+                    if (profile.frame != lastProfiled) {
+                        for (const auto &scope : profile.scopes) {
+                            if (std::string(scope.name) == "Lighting Pass") {
+                                lightingTime += scope.gpuTime;
+                            }
+                        }
+                        lastProfiled = profile.frame;
+                        ++profiledFrames;
+                    }
+                }
+
+                std::cout << std::setw(8) << count << std::setw(12) << (deferred ? "deferred" : "forward") << std::fixed << std::setprecision(3)
+                          << std::setw(12) << cpuTime / frames << std::setw(12) << gpuTime / frames;
+                if (deferred) {
+                    std::cout << std::setw(14) << lightingTime / std::max<uint32_t>(profiledFrames, 1);
+                }
+                std::cout << std::endl;
+            }
+        }
+
+        gl.glDeleteQueries(1, &query);
+    } // Widget releases its GL objects while context is still current
+
+    fbo.release();
+    context.doneCurrent();
+
+    return 0;
+}
+
+int benchmarkShaderVariants() {
+    QOffscreenSurface surface;
+    surface.setFormat(QSurfaceFormat::defaultFormat());
+    surface.create();
+    QOpenGLContext context;
+    context.setFormat(QSurfaceFormat::defaultFormat());
+    if (!context.create() || !context.makeCurrent(&surface)) {
+        std::cerr << "Benchmark OpenGL context creation failed!" << std::endl;
+        return 1;
+    }
+
+    QOpenGLFunctions_3_3_Core gl;
+    gl.initializeOpenGLFunctions();
+
+    // GL exposes no ALU counters, vertex and fragment cost are separated by framebuffer size instead
+    struct Target {
+        const char *name;
+        int width;
+        int height;
+    };
+    const Target targets[] = {{"vertex bound", 64, 36}, {"fragment bound", 2560, 1440}};
+
+    std::cout << std::left << std::setw(16) << "Target" << std::setw(12) << "Shading" << std::setw(12) << "Programs" << std::right
+              << std::setw(10) << "Variants" << std::setw(12) << "CPU ms" << std::setw(12) << "GPU ms" << std::setw(12) << "Saving %" << std::endl;
+
+    for (const auto &target : targets) {
+        QOpenGLFramebufferObjectFormat fboFormat;
+        fboFormat.setAttachment(QOpenGLFramebufferObject::Depth);
+        QOpenGLFramebufferObject fbo(target.width, target.height, fboFormat);
+        fbo.bind();
+
+        QComboBox objectSelection;
+        {
+            WidgetOpenGLDraw widget(nullptr);
+            widget.objectSelection = &objectSelection;
+            widget.initializeOffscreen(target.width, target.height);
+            widget.addBenchmarkObjects(2);
+            widget.setCamera(glm::vec3(0.0f, 10.0f, 30.0f), -18.0f, 180.0f);
+
+            GLuint query;
+            gl.glGenQueries(1, &query);
+
+            const uint32_t warmupFrames = 5; // Variants are compiled while warming up
+            const uint32_t frames = 50;
+            for (bool deferred : {false, true}) {
+                widget.deferredShading = deferred;
+
+                double branchingTime = 0.0;
+                for (bool specialize : {false, true}) {
+                    widget.specializeShaders = specialize;
+
+                    double cpuTime = 0.0, gpuTime = 0.0;
+                    for (uint32_t frame = 0; frame < warmupFrames + frames; ++frame) {
+                        QElapsedTimer timer;
+                        timer.start();
+                        gl.glBeginQuery(GL_TIME_ELAPSED, query);
+                        widget.renderOffscreen();
+                        gl.glEndQuery(GL_TIME_ELAPSED);
+                        double time = static_cast<double>(timer.nsecsElapsed()) / 1e6;
+
+                        GLuint64 elapsed = 0;
+                        gl.glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+                        if (frame >= warmupFrames) {
+                            cpuTime += time;
+                            gpuTime += static_cast<double>(elapsed) / 1e6;
+                        }
+                    }
+                    cpuTime /= frames;
+                    gpuTime /= frames;
+
+                    std::cout << std::left << std::setw(16) << target.name << std::setw(12) << (deferred ? "deferred" : "forward")
+                              << std::setw(12) << (specialize ? "variants" : "branching") << std::right
+                              << std::setw(10) << (specialize ? widget.shaderVariantStats().used : 1) << std::fixed << std::setprecision(3)
+                              << std::setw(12) << cpuTime << std::setw(12) << gpuTime;
+                    if (specialize && branchingTime > 0.0) {
+                        std::cout << std::setprecision(1) << std::setw(12) << 100.0 * (branchingTime - gpuTime) / branchingTime;
+                    }
+                    std::cout << std::endl;
+                    branchingTime = gpuTime;
+                }
+            }
+
+            gl.glDeleteQueries(1, &query);
+        } // Widget releases its GL objects while context is still current
+
+        fbo.release();
+    }
+
+    context.doneCurrent();
+
+    return 0;
+}
+
+int benchmarkStartup() {
+    QOffscreenSurface surface;
+    surface.setFormat(QSurfaceFormat::defaultFormat());
+    surface.create();
+    QOpenGLContext context;
+    context.setFormat(QSurfaceFormat::defaultFormat());
+    if (!context.create() || !context.makeCurrent(&surface)) {
+        std::cerr << "Benchmark OpenGL context creation failed!" << std::endl;
+        return 1;
+    }
+
+    QOpenGLFunctions_3_3_Core gl;
+    gl.initializeOpenGLFunctions();
+
+    QTemporaryDir cacheDirectory;
+    if (!cacheDirectory.isValid()) {
+        std::cerr << "Benchmark cache directory creation failed!" << std::endl;
+        return 1;
+    }
+
+    const int width = 1280, height = 720;
+    QOpenGLFramebufferObjectFormat fboFormat;
+    fboFormat.setAttachment(QOpenGLFramebufferObject::Depth);
+    QOpenGLFramebufferObject fbo(width, height, fboFormat);
+    fbo.bind();
+
+    // Driver's own shader cache (eg. Mesa) may also speed up later runs, uncached run shows its effect
+    struct Run {
+        const char *name;
+        QString directory;
+    };
+    const Run runs[] = {{"uncached", ""}, {"cold", cacheDirectory.path()}, {"warm", cacheDirectory.path()}};
+
+    std::cout << std::left << std::setw(12) << "Cache" << std::right << std::setw(14) << "Init ms" << std::setw(14) << "Variants ms"
+              << std::setw(14) << "Startup ms" << std::setw(8) << "Hits" << std::setw(8) << "Misses" << std::setw(10) << "Rejected"
+              << std::setw(10) << "Written" << std::endl;
+
+    for (const auto &run : runs) {
+        QComboBox objectSelection;
+        {
+            WidgetOpenGLDraw widget(nullptr);
+            widget.objectSelection = &objectSelection;
+            widget.programCacheDirectory = run.directory;
+
+            // Base programs are compiled on initialization, variants of built-in objects on first forward and deferred frames
+            QElapsedTimer timer;
+            timer.start();
+            widget.initializeOffscreen(width, height);
+            gl.glFinish();
+            double initTime = static_cast<double>(timer.nsecsElapsed()) / 1e6;
+
+            timer.restart();
+            for (bool deferred : {false, true}) {
+                widget.deferredShading = deferred;
+                widget.renderOffscreen();
+            }
+            gl.glFinish();
+            double frameTime = static_cast<double>(timer.nsecsElapsed()) / 1e6;
+
+            const ProgramCacheStats &stats = widget.programCacheStats();
+            std::cout << std::left << std::setw(12) << run.name << std::right << std::fixed << std::setprecision(3)
+                      << std::setw(14) << initTime << std::setw(14) << widget.shaderVariantStats().compileTime
+                      << std::setw(14) << initTime + frameTime << std::setw(8) << stats.hits << std::setw(8) << stats.misses
+                      << std::setw(10) << stats.rejected << std::setw(10) << stats.written << std::endl;
+        } // Widget releases its GL objects while context is still current
+    }
+
+    fbo.release();
+    context.doneCurrent();
+
+    return 0;
+}
+
+int benchmarkBumpMapping(const QStringList &paths) {
+    std::vector<std::pair<QString, QImage>> images;
+    if (!benchmarkImages(paths, images)) {
+        return 1;
+    }
+
+    // Height to normal map conversion, done once per bump map on decoding threads
+    std::cout << std::left << std::setw(24) << "Image" << std::right << std::setw(12) << "Size"
+              << std::setw(12) << "ms (best)" << std::setw(12) << "MPixels/s" << std::endl;
+    for (const auto &image : images) {
+        double best = 0.0;
+        for (int run = 0; run < benchmarkRuns; ++run) {
+            QElapsedTimer timer;
+            timer.start();
+            QImage normalMap = heightToNormalMap(image.second, 1.0f);
+            double time = static_cast<double>(timer.nsecsElapsed()) / 1e6;
+            if (run == 0 || time < best) best = time;
+        }
+
+        double pixels = static_cast<double>(image.second.width()) * image.second.height();
+        std::cout << std::left << std::setw(24) << image.first.toStdString() << std::right
+                  << std::setw(12) << QString("%1x%2").arg(image.second.width()).arg(image.second.height()).toStdString()
+                  << std::fixed << std::setprecision(2) << std::setw(12) << best << std::setw(12) << pixels / std::max(best / 1000.0, 1e-9) / 1e6 << std::endl;
+    }
+    std::cout << std::endl;
+
+    QOffscreenSurface surface;
+    surface.setFormat(QSurfaceFormat::defaultFormat());
+    surface.create();
+    QOpenGLContext context;
+    context.setFormat(QSurfaceFormat::defaultFormat());
+    if (!context.create() || !context.makeCurrent(&surface)) {
+        std::cerr << "Benchmark OpenGL context creation failed!" << std::endl;
+        return 1;
+    }
+
+    QOpenGLFunctions_3_3_Core gl;
+    gl.initializeOpenGLFunctions();
+
+    // Built-in objects are bump mapped, large framebuffer makes frame time fragment bound
+    const int width = 2560, height = 1440;
+    QOpenGLFramebufferObjectFormat fboFormat;
+    fboFormat.setAttachment(QOpenGLFramebufferObject::Depth);
+    QOpenGLFramebufferObject fbo(width, height, fboFormat);
+    fbo.bind();
+
+    std::cout << std::left << std::setw(16) << "Bump mapping" << std::right << std::setw(12) << "CPU ms" << std::setw(12) << "GPU ms"
+              << std::setw(14) << "Mean diff" << std::setw(12) << "Max diff" << std::setw(12) << "PSNR dB" << std::endl;
+
+    QComboBox objectSelection;
+    {
+        WidgetOpenGLDraw widget(nullptr);
+        widget.objectSelection = &objectSelection;
+        widget.initializeOffscreen(width, height); // Initial camera looks at built-in objects
+
+        GLuint query;
+        gl.glGenQueries(1, &query);
+
+        const uint32_t warmupFrames = 5; // Variants are compiled while warming up
+        const uint32_t frames = 50;
+        QImage reference;
+        for (bool derivatives : {true, false}) {
+            widget.derivativeBumpMapping = derivatives;
+
+            double cpuTime = 0.0, gpuTime = 0.0;
+            for (uint32_t frame = 0; frame < warmupFrames + frames; ++frame) {
+                QElapsedTimer timer;
+                timer.start();
+                gl.glBeginQuery(GL_TIME_ELAPSED, query);
+                widget.renderOffscreen();
+                gl.glEndQuery(GL_TIME_ELAPSED);
+                double time = static_cast<double>(timer.nsecsElapsed()) / 1e6;
+
+                GLuint64 elapsed = 0;
+                gl.glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+                if (frame >= warmupFrames) {
+                    cpuTime += time;
+                    gpuTime += static_cast<double>(elapsed) / 1e6;
+                }
+            }
+            cpuTime /= frames;
+            gpuTime /= frames;
+
+            std::cout << std::left << std::setw(16) << (derivatives ? "derivatives" : "normal map") << std::right << std::fixed
+                      << std::setprecision(3) << std::setw(12) << cpuTime << std::setw(12) << gpuTime;
+
+            // Difference of final images against previous derivative path (RGB channels)
+            QImage image = fbo.toImage().convertToFormat(QImage::Format_ARGB32);
+            if (reference.isNull()) {
+                reference = image;
+            } else {
+                double sum = 0.0, squared = 0.0;
+                int maxDifference = 0;
+                for (int y = 0; y < height; ++y) {
+                    const QRgb *a = reinterpret_cast<const QRgb *>(reference.constScanLine(y));
+                    const QRgb *b = reinterpret_cast<const QRgb *>(image.constScanLine(y));
+                    for (int x = 0; x < width; ++x) {
+                        int differences[3] = {qRed(a[x]) - qRed(b[x]), qGreen(a[x]) - qGreen(b[x]), qBlue(a[x]) - qBlue(b[x])};
+                        for (int difference : differences) {
+                            sum += std::abs(difference);
+                            squared += difference * difference;
+                            maxDifference = std::max(maxDifference, std::abs(difference));
+                        }
+                    }
+                }
+                double samples = 3.0 * width * height;
+                double mse = squared / samples;
+                std::cout << std::setprecision(2) << std::setw(14) << sum / samples << std::setw(12) << maxDifference
+                          << std::setw(12) << (mse > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / mse) : INFINITY);
+            }
+            std::cout << std::endl;
+        }
+
+        gl.glDeleteQueries(1, &query);
+    } // Widget releases its GL objects while context is still current
+
+    fbo.release();
+    context.doneCurrent();
+
+    return 0;
+}
+
+// Shader's texture mapping with exact angles, single thread
+void referenceTextureMapping(std::vector<Vertex> &vertices, GLuint mappingType, GLuint mappingAxis, glm::vec3 boundingBoxMin, glm::vec3 boundingBoxMax) {
+    const int planar[3][2] = {{2, 1}, {0, 2}, {0, 1}};
+    const int angular[3][3] = {{1, 2, 0}, {2, 0, 1}, {1, 0, 2}};
+    glm::vec3 size = boundingBoxMax - boundingBoxMin;
+    glm::vec3 center = boundingBoxMin + size / 2.0f;
+    for (auto &vertex : vertices) {
+        glm::vec3 d = vertex.position - center;
+        if (mappingType == textureMappingPlanar) {
+            int u = planar[mappingAxis][0], v = planar[mappingAxis][1];
+            vertex.uv = glm::vec2((vertex.position[u] - boundingBoxMin[u]) / size[u], (vertex.position[v] - boundingBoxMin[v]) / size[v]);
+            continue;
+        }
+        int p = angular[mappingAxis][0], q = angular[mappingAxis][1], r = angular[mappingAxis][2];
+        vertex.uv.x = (glm::degrees(std::atan2(d[p], d[q])) + 180.0f) / 360.0f;
+        if (mappingType == textureMappingCylindrical) {
+            vertex.uv.y = d[r] / size[r] + 0.5f;
+        } else {
+            vertex.uv.y = (glm::degrees(std::asin(d[r] / glm::length(d))) + 90.0f) / 180.0f;
+        }
+    }
+}
+
+int benchmarkTextureMapping(uint32_t vertexCount) {
+    // Sphere with about given vertex count, (segments + 1) * (segments / 2 + 1) vertices
+    uint32_t segments = std::max(static_cast<uint32_t>(std::sqrt(2.0 * vertexCount)), 4u);
+    std::vector<Vertex> vertices;
+    std::vector<GLuint> indices;
+    makeSphere(segments, 1.0f, vertices, indices);
+    glm::vec3 boundingBoxMin(-1.0f), boundingBoxMax(1.0f);
+    std::cout << "Sphere: " << vertices.size() << " vertices, " << indices.size() / 3 << " triangles" << std::endl;
+
+    std::cout << std::left << std::setw(14) << "Mapping" << std::setw(6) << "Axis" << std::right << std::setw(14) << "Exact ms"
+              << std::setw(14) << "Baked ms" << std::setw(12) << "Speedup" << std::setw(14) << "MVertices/s" << std::setw(14) << "Max error" << std::endl;
+
+    const char *mappingNames[] = {"Simple", "Planar", "Cylindrical", "Spherical"};
+    const char *axisNames[] = {"X", "Y", "Z"};
+    std::vector<Vertex> reference = vertices;
+    for (GLuint mappingType = textureMappingPlanar; mappingType <= textureMappingSpherical; ++mappingType) {
+        for (GLuint mappingAxis = 0; mappingAxis < 3; ++mappingAxis) {
+            double exact = 0.0, baked = 0.0;
+            for (int run = 0; run < benchmarkRuns; ++run) {
+                QElapsedTimer timer;
+                timer.start();
+                referenceTextureMapping(reference, mappingType, mappingAxis, boundingBoxMin, boundingBoxMax);
+                double time = static_cast<double>(timer.nsecsElapsed()) / 1e6;
+                if (run == 0 || time < exact) exact = time;
+
+                timer.restart();
+                bakeTextureMapping(vertices.data(), vertices.size(), mappingType, mappingAxis, boundingBoxMin, boundingBoxMax);
+                time = static_cast<double>(timer.nsecsElapsed()) / 1e6;
+                if (run == 0 || time < baked) baked = time;
+            }
+
+            // U wraps around at seam, 0 and 1 are the same texel column
+            float maxError = 0.0f;
+            for (size_t i = 0; i < vertices.size(); ++i) {
+                glm::vec2 error = glm::abs(vertices[i].uv - reference[i].uv);
+                error.x = std::min(error.x, std::abs(1.0f - error.x));
+                maxError = std::max(maxError, std::max(error.x, error.y));
+            }
+
+            std::cout << std::left << std::setw(14) << mappingNames[mappingType] << std::setw(6) << axisNames[mappingAxis]
+                      << std::right << std::fixed << std::setprecision(3) << std::setw(14) << exact << std::setw(14) << baked
+                      << std::setw(12) << exact / std::max(baked, 1e-9) << std::setw(14) << vertices.size() / std::max(baked / 1000.0, 1e-9) / 1e6
+                      << std::scientific << std::setprecision(2) << std::setw(14) << maxError << std::endl;
+            std::cout.unsetf(std::ios::floatfield);
+        }
+    }
+
+    // Seam split of spherical mapping around Y (one column of sphere triangles spans the seam)
+    bakeTextureMapping(vertices.data(), vertices.size(), textureMappingSpherical, 1, boundingBoxMin, boundingBoxMax);
+    QElapsedTimer timer;
+    timer.start();
+    size_t added = splitMappingSeams(vertices, indices);
+    double time = static_cast<double>(timer.nsecsElapsed()) / 1e6;
+    std::cout << "Seam split: " << added << " vertices added, " << std::fixed << std::setprecision(3) << time << " ms" << std::endl;
+
+    return 0;
+}
+
+int benchmarkMipmaps(const QStringList &paths) {
+    std::vector<std::pair<QString, QImage>> images;
+    if (!benchmarkImages(paths, images)) {
+        return 1;
+    }
+
+    std::cout << std::left << std::setw(24) << "Image" << std::right << std::setw(12) << "Size" << std::setw(10) << "Levels"
+              << std::setw(12) << "ms (best)" << std::setw(12) << "MPixels/s" << std::endl;
+
+    for (const auto &image : images) {
+        double best = 0.0;
+        size_t levels = 0;
+        for (int run = 0; run < benchmarkRuns; ++run) {
+            QElapsedTimer timer;
+            timer.start();
+            std::vector<QImage> mipmaps = generateMipmaps(image.second);
+            double time = static_cast<double>(timer.nsecsElapsed()) / 1e6;
+            if (run == 0 || time < best) best = time;
+            levels = mipmaps.size() + 1;
+        }
+
+        double pixels = static_cast<double>(image.second.width()) * image.second.height(); // Source pixels read by first level
+        std::cout << std::left << std::setw(24) << image.first.toStdString() << std::right
+                  << std::setw(12) << QString("%1x%2").arg(image.second.width()).arg(image.second.height()).toStdString()
+                  << std::setw(10) << levels << std::fixed << std::setprecision(2)
+                  << std::setw(12) << best << std::setw(12) << pixels / std::max(best / 1000.0, 1e-9) / 1e6 << std::endl;
+    }
+
+    return 0;
+}
+
+int benchmarkTextureSampling(const QStringList &paths) {
+    std::vector<std::pair<QString, QImage>> images;
+    if (!benchmarkImages(paths, images)) {
+        return 1;
+    }
+    const QImage &image = images.front().second;
+
+    QOffscreenSurface surface;
+    surface.setFormat(QSurfaceFormat::defaultFormat());
+    surface.create();
+    QOpenGLContext context;
+    context.setFormat(QSurfaceFormat::defaultFormat());
+    if (!context.create() || !context.makeCurrent(&surface)) {
+        std::cerr << "Benchmark OpenGL context creation failed!" << std::endl;
+        return 1;
+    }
+
+    QOpenGLFunctions_3_3_Core gl;
+    gl.initializeOpenGLFunctions();
+    std::cout << gl.glGetString(GL_RENDERER) << std::endl;
+
+    const int width = 1280, height = 720;
+    QOpenGLFramebufferObject fbo(width, height);
+    fbo.bind();
+    gl.glViewport(0, 0, width, height);
+
+    // Textured ground plane, same size and texture repeat as the "Ground" scene object
+    const GLchar *vertexSource = R"glsl(
+        #version 330 core
+        layout(location = 0) in vec3 position;
+        layout(location = 1) in vec2 uv;
+        uniform mat4 MVP;
+        out vec2 UV;
+        void main() {
+            UV = uv;
+            gl_Position = MVP * vec4(position, 1.0);
+        }
+    )glsl";
+    const GLchar *fragmentSource = R"glsl(
+        #version 330 core
+        uniform sampler2D Texture;
+        in vec2 UV;
+        out vec4 color;
+        void main() {
+            color = texture(Texture, UV);
+        }
+    )glsl";
+
+    GLuint program = gl.glCreateProgram();
+    GLuint shaders[2] = {gl.glCreateShader(GL_VERTEX_SHADER), gl.glCreateShader(GL_FRAGMENT_SHADER)};
+    gl.glShaderSource(shaders[0], 1, &vertexSource, nullptr);
+    gl.glShaderSource(shaders[1], 1, &fragmentSource, nullptr);
+    for (GLuint shader : shaders) {
+        gl.glCompileShader(shader);
+        gl.glAttachShader(program, shader);
+    }
+    gl.glLinkProgram(program);
+    gl.glUseProgram(program);
+
+    std::vector<Vertex> vertices = {
+        {{-10.0f, 0.0f, -10.0f}, {0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}, {1.0f, 0.0f, 0.0f, 1.0f}},
+        {{-10.0f, 0.0f, 10.0f}, {0.0f, 10.0f}, {0.0f, 1.0f, 0.0f}, {1.0f, 0.0f, 0.0f, 1.0f}},
+        {{10.0f, 0.0f, 10.0f}, {10.0f, 10.0f}, {0.0f, 1.0f, 0.0f}, {1.0f, 0.0f, 0.0f, 1.0f}},
+        {{10.0f, 0.0f, -10.0f}, {10.0f, 0.0f}, {0.0f, 1.0f, 0.0f}, {1.0f, 0.0f, 0.0f, 1.0f}}
+    };
+    std::vector<GLuint> indices = {0, 1, 2, 2, 3, 0};
+
+    GLuint VAO, VBO, IBO;
+    gl.glGenVertexArrays(1, &VAO);
+    gl.glBindVertexArray(VAO);
+    gl.glGenBuffers(1, &VBO);
+    gl.glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    gl.glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(vertices.size() * sizeof(Vertex)), vertices.data(), GL_STATIC_DRAW);
+    gl.glGenBuffers(1, &IBO);
+    gl.glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IBO);
+    gl.glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(indices.size() * sizeof(GLuint)), indices.data(), GL_STATIC_DRAW);
+    gl.glEnableVertexAttribArray(0);
+    gl.glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<const void *>(offsetof(Vertex, position)));
+    gl.glEnableVertexAttribArray(1);
+    gl.glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<const void *>(offsetof(Vertex, uv)));
+
+    // Texture with (CPU generated) mip chain, filtering is switched per mode
+    GLuint texture;
+    gl.glGenTextures(1, &texture);
+    gl.glBindTexture(GL_TEXTURE_2D, texture);
+    std::vector<QImage> mipmaps = generateMipmaps(image);
+    gl.glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image.width(), image.height(), 0, GL_BGRA, GL_UNSIGNED_BYTE, image.constBits());
+    for (size_t i = 0; i < mipmaps.size(); ++i) {
+        gl.glTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(i) + 1, GL_RGBA, mipmaps[i].width(), mipmaps[i].height(), 0, GL_BGRA, GL_UNSIGNED_BYTE, mipmaps[i].constBits());
+    }
+    gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    float maxAnisotropy = 0.0f;
+    if (context.hasExtension("GL_EXT_texture_filter_anisotropic") || context.hasExtension("GL_ARB_texture_filter_anisotropic")) {
+        gl.glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &maxAnisotropy);
+    }
+
+    struct Mode {
+        const char *name;
+        GLint minFilter;
+        GLint maxLevel;
+        float anisotropy;
+    };
+    std::vector<Mode> modes = {
+        {"Nearest", GL_NEAREST, 0, 1.0f}, // Previous texture filtering
+        {"Bilinear", GL_LINEAR, 0, 1.0f}, // Previous bump map filtering
+        {"Trilinear", GL_LINEAR_MIPMAP_LINEAR, static_cast<GLint>(mipmaps.size()), 1.0f}
+    };
+    if (maxAnisotropy > 1.0f) {
+        modes.push_back({"Anisotropic", GL_LINEAR_MIPMAP_LINEAR, static_cast<GLint>(mipmaps.size()), std::min(16.0f, maxAnisotropy)});
+    }
+
+    // Each pass redraws the plane several times (no depth test), so sampling dominates the measured time
+    const int drawsPerPass = 20;
+    const float distances[] = {2.0f, 5.0f, 10.0f, 20.0f, 40.0f, 80.0f};
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), static_cast<float>(width) / height, 0.1f, 1000.0f);
+
+    GLuint query;
+    gl.glGenQueries(1, &query);
+
+    std::cout << std::left << std::setw(12) << "Distance";
+    for (const auto &mode : modes) {
+        std::cout << std::right << std::setw(14) << std::string(mode.name) + " ms";
+    }
+    std::cout << std::endl;
+
+    for (float distance : distances) {
+        // Low camera looking over the plane, so far side of the plane is strongly minified
+        glm::mat4 view = glm::lookAt(glm::vec3(0.0f, distance * 0.25f, distance), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        glm::mat4 MVP = projection * view;
+        gl.glUniformMatrix4fv(gl.glGetUniformLocation(program, "MVP"), 1, GL_FALSE, glm::value_ptr(MVP));
+
+        std::cout << std::left << std::setw(12) << distance << std::right << std::fixed << std::setprecision(3);
+        for (const auto &mode : modes) {
+            gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, mode.minFilter);
+            gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, mode.maxLevel);
+            if (maxAnisotropy > 0.0f) {
+                gl.glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, mode.anisotropy);
+            }
+
+            double best = 0.0;
+            for (int run = 0; run <= benchmarkRuns; ++run) {
+                gl.glClear(GL_COLOR_BUFFER_BIT);
+                gl.glBeginQuery(GL_TIME_ELAPSED, query);
+                for (int i = 0; i < drawsPerPass; ++i) {
+                    gl.glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indices.size()), GL_UNSIGNED_INT, nullptr);
+                }
+                gl.glEndQuery(GL_TIME_ELAPSED);
+
+                GLuint64 elapsed = 0;
+                gl.glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+                double time = static_cast<double>(elapsed) / 1e6;
+                if (run == 1 || time < best) best = time; // First run is warm up
+            }
+            std::cout << std::setw(14) << best;
+        }
+        std::cout << std::endl;
+    }
+
+    gl.glDeleteQueries(1, &query);
+    gl.glDeleteTextures(1, &texture);
+    gl.glDeleteBuffers(1, &VBO);
+    gl.glDeleteBuffers(1, &IBO);
+    gl.glDeleteVertexArrays(1, &VAO);
+    gl.glDeleteProgram(program);
+    gl.glDeleteShader(shaders[0]);
+    gl.glDeleteShader(shaders[1]);
+    fbo.release();
+    context.doneCurrent();
+
+    return 0;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+
+#include <QString>
+#include <QStringList>
+
+// Command line benchmarks (see main.cpp for options), return process exit code
+
+struct FrameBenchmarkOptions {
+    uint32_t frames = 300; // Measured, after a few warm up frames
+    uint32_t sceneScale = 1; // Scaled-up variants of built-in objects added (0 - built-in objects only)
+    int width = 1280;
+    int height = 720;
+    bool deferred = false; // Deferred shading instead of forward
+    bool packedVertices = false; // Meshes uploaded in packed vertex formats and 16-bit indices
+    QString dumpDirectory; // Every measured frame is saved as PNG if set
+    QString outputPath; // JSON report is written to standard output if empty
+};
+
+// CPU and GPU frame times of the scene rendered headless (offscreen surface and framebuffer) along a scripted camera path
+int benchmarkFrames(const FrameBenchmarkOptions &options);
+
+// Light cluster build and CPU and GPU frame times of the benchmark scene rendered headless with light counts up to given count
+int benchmarkLights(uint32_t maxLights);
+
+// CPU and GPU frame times of forward and deferred shading of an overdraw heavy scene (camera inside a cloud of cubes) with light counts up to given count
+int benchmarkShading(uint32_t maxLights);
+
+// CPU and GPU frame times of benchmark scene drawn with specialized shader variants and with one branching program
+// Small framebuffer is dominated by vertex work, large one by fragment work
+int benchmarkShaderVariants();
+
+// Startup time (program compilation on initialization and first frames) without program cache, with an empty one and with a filled one
+int benchmarkStartup();
+
+// Parse throughput of a generated OBJ with given face count and of given OBJ files
+int benchmarkOBJParser(const QStringList &paths, uint32_t generatedFaces);
+
+// Cold (parse OBJ and write mesh cache) and warm (map mesh cache) load time of given OBJ files, and time opt-in packing adds to warm uploads
+int benchmarkMeshCache(const QStringList &paths);
+
+// Frustum culling of given number of randomly scattered objects around camera, looking in several directions
+int benchmarkCulling(uint32_t objects);
+
+// Scene registry add and remove time per object, per-frame transform update and culling, and handle validity after removals, for growing object counts
+int benchmarkScene(uint32_t objects);
+
+// Triangles, build time and buffer memory of pyramids of several sizes: stamped cubes (previous generator), greedy meshed and instanced
+int benchmarkPyramid();
+
+// Mesh buffer allocator utilization and fragmentation while given number of meshes of mixed sizes are removed and added
+int benchmarkMeshAllocator(uint32_t meshes);
+
+// Vertex cache efficiency (ACMR, ATVR) of given OBJ files and generated pyramids before and after mesh optimization
+int benchmarkVertexCache(const QStringList &paths);
+
+// Level of detail generation of given OBJ files (or a generated sphere) and triangles drawn by a scene of them at many distances
+int benchmarkLevelsOfDetail(const QStringList &paths);
+
+// Precision error and memory of packed vertex formats and 16-bit indices of given OBJ files (or a generated sphere)
+int benchmarkQuantization(const QStringList &paths);
+
+// GPU time and vertex data read of drawing given OBJ files (or a generated sphere) many times with float and packed vertex formats
+int benchmarkVertexFormats(const QStringList &paths);
+
+// Height to normal map conversion time of given images (or a generated one), then GPU time and image difference of
+// built-in scene bump mapped from per-fragment height derivatives and from normal maps
+int benchmarkBumpMapping(const QStringList &paths);
+
+// Texture mapping bake time of a generated sphere with about given vertex count, against exact (shader's) mapping on one thread, and its UV error
+int benchmarkTextureMapping(uint32_t vertices);
+
+// Mip chain generation time of given images (or a generated one)
+int benchmarkMipmaps(const QStringList &paths);
+
+// GPU time of drawing a textured ground plane at several camera distances with different texture filtering
+int benchmarkTextureSampling(const QStringList &paths);
@@ -0,0 +1,129 @@
+#include "culling.h"
+
+#include <cmath>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+Frustum::Frustum(const glm::mat4 &PV) {
+    // Gribb-Hartmann, planes are sums and differences of 4th row with other rows (glm is column major)
+    glm::vec4 row[4];
+    for (int i = 0; i < 4; ++i) {
+        row[i] = glm::vec4(PV[0][i], PV[1][i], PV[2][i], PV[3][i]);
+    }
+
+    planes[0] = row[3] + row[0];
+    planes[1] = row[3] - row[0];
+    planes[2] = row[3] + row[1];
+    planes[3] = row[3] - row[1];
+    planes[4] = row[3] + row[2];
+    planes[5] = row[3] - row[2];
+
+    // Normalize, so distances are in world units
+    for (auto &plane : planes) {
+        plane = plane / glm::length(glm::vec3(plane));
+    }
+}
+
+void CullingBounds::clear() {
+    centerX.clear();
+    centerY.clear();
+    centerZ.clear();
+    extentX.clear();
+    extentY.clear();
+    extentZ.clear();
+}
+
+void CullingBounds::push(const glm::vec3 &center, const glm::vec3 &extent) {
+    centerX.push_back(center.x);
+    centerY.push_back(center.y);
+    centerZ.push_back(center.z);
+    extentX.push_back(extent.x);
+    extentY.push_back(extent.y);
+    extentZ.push_back(extent.z);
+}
+
+void CullingBounds::set(size_t index, const glm::vec3 &center, const glm::vec3 &extent) {
+    centerX[index] = center.x;
+    centerY[index] = center.y;
+    centerZ[index] = center.z;
+    extentX[index] = extent.x;
+    extentY[index] = extent.y;
+    extentZ[index] = extent.z;
+}
+
+void CullingBounds::swapRemove(size_t index) {
+    for (auto *array : {&centerX, &centerY, &centerZ, &extentX, &extentY, &extentZ}) {
+        (*array)[index] = array->back();
+        array->pop_back();
+    }
+}
+
+void transformBounds(const glm::mat4 &M, const glm::vec3 &boundsMin, const glm::vec3 &boundsMax, glm::vec3 &center, glm::vec3 &extent) {
+    glm::vec3 localCenter = (boundsMin + boundsMax) * 0.5f;
+    glm::vec3 localExtent = (boundsMax - boundsMin) * 0.5f;
+
+    // Extent along each world axis is the sum of projected local extents (absolute rotation-scale matrix)
+    for (int i = 0; i < 3; ++i) {
+        center[i] = M[3][i] + M[0][i] * localCenter.x + M[1][i] * localCenter.y + M[2][i] * localCenter.z;
+        extent[i] = std::abs(M[0][i]) * localExtent.x + std::abs(M[1][i]) * localExtent.y + std::abs(M[2][i]) * localExtent.z;
+    }
+}
+
+size_t cullBounds(const Frustum &frustum, const CullingBounds &bounds, std::vector<uint8_t> &visible) {
+    size_t count = bounds.size();
+    visible.resize(count);
+
+    size_t visibleCount = 0;
+    size_t i = 0;
+#ifdef __SSE2__
+    // 4 boxes per iteration, outside if (distance of center + projected extent) < 0 for any plane
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    for (; i + 4 <= count; i += 4) {
+        __m128 cx = _mm_loadu_ps(&bounds.centerX[i]);
+        __m128 cy = _mm_loadu_ps(&bounds.centerY[i]);
+        __m128 cz = _mm_loadu_ps(&bounds.centerZ[i]);
+        __m128 ex = _mm_loadu_ps(&bounds.extentX[i]);
+        __m128 ey = _mm_loadu_ps(&bounds.extentY[i]);
+        __m128 ez = _mm_loadu_ps(&bounds.extentZ[i]);
+
+        __m128 outside = _mm_setzero_ps();
+        for (const auto &plane : frustum.planes) {
+            __m128 px = _mm_set1_ps(plane.x);
+            __m128 py = _mm_set1_ps(plane.y);
+            __m128 pz = _mm_set1_ps(plane.z);
+
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px, cx), _mm_mul_ps(py, cy)),
+                                         _mm_add_ps(_mm_mul_ps(pz, cz), _mm_set1_ps(plane.w)));
+            __m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_andnot_ps(signMask, px), ex), _mm_mul_ps(_mm_andnot_ps(signMask, py), ey)),
+                                       _mm_mul_ps(_mm_andnot_ps(signMask, pz), ez));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+        }
+
+        int mask = _mm_movemask_ps(outside);
+        for (int j = 0; j < 4; ++j) {
+            uint8_t in = (mask >> j) & 1 ? 0 : 1;
+            visible[i + j] = in;
+            visibleCount += in;
+        }
+    }
+#endif
+
+    // Remaining boxes
+    for (; i < count; ++i) {
+        bool in = true;
+        for (const auto &plane : frustum.planes) {
+            float distance = plane.x * bounds.centerX[i] + plane.y * bounds.centerY[i] + plane.z * bounds.centerZ[i] + plane.w;
+            float radius = std::abs(plane.x) * bounds.extentX[i] + std::abs(plane.y) * bounds.extentY[i] + std::abs(plane.z) * bounds.extentZ[i];
+            if (distance + radius < 0.0f) {
+                in = false;
+                break;
+            }
+        }
+        visible[i] = in ? 1 : 0;
+        visibleCount += in ? 1 : 0;
+    }
+
+    return visibleCount;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// View frustum planes (xyz - inward normal, w - distance), extracted from projection-view matrix
+struct Frustum {
+    glm::vec4 planes[6]; // Left, right, bottom, top, near, far
+
+    explicit Frustum(const glm::mat4 &PV);
+};
+
+// Axis aligned boxes (center and half extent) in structure of arrays layout for SIMD testing
+struct CullingBounds {
+    std::vector<float> centerX, centerY, centerZ;
+    std::vector<float> extentX, extentY, extentZ;
+
+    void clear();
+    void push(const glm::vec3 &center, const glm::vec3 &extent);
+    void set(size_t index, const glm::vec3 &center, const glm::vec3 &extent);
+    void swapRemove(size_t index); // Last box moves into index
+    size_t size() const { return centerX.size(); }
+
+    glm::vec3 center(size_t index) const { return glm::vec3(centerX[index], centerY[index], centerZ[index]); }
+    glm::vec3 extent(size_t index) const { return glm::vec3(extentX[index], extentY[index], extentZ[index]); }
+};
+
+struct CullingStats {
+    uint32_t visible = 0;
+    uint32_t culled = 0;
+};
+
+// Transform local bounding box to world space box (still axis aligned, encloses transformed box)
+void transformBounds(const glm::mat4 &M, const glm::vec3 &boundsMin, const glm::vec3 &boundsMax, glm::vec3 &center /* out */, glm::vec3 &extent /* out */);
+
+// Test boxes against frustum (4 at a time with SSE when available), box is visible unless entirely outside one plane
+// Visibility (1 - visible, 0 - culled) is written for each box, returns visible count
+size_t cullBounds(const Frustum &frustum, const CullingBounds &bounds, std::vector<uint8_t> &visible /* out */);
@@ -0,0 +1,108 @@
+#include "gbuffer.h"
+
+#include <iostream>
+
+namespace {
+
+struct AttachmentFormat {
+    GLenum internalFormat;
+    GLenum format;
+    GLenum type;
+    size_t texelSize;
+};
+
+const AttachmentFormat attachmentFormats[gBufferAttachmentCount] = {
+    {GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, 4},
+    {GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, 4},
+    {GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, 4},
+    {GL_RGB10_A2, GL_RGBA, GL_UNSIGNED_INT_2_10_10_10_REV, 4},
+    {GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, 4}
+};
+
+} // namespace
+
+void GBuffer::initialize(QOpenGLFunctions_3_3_Core *gl_) {
+    gl = gl_;
+
+    gl->glGenFramebuffers(1, &framebuffer);
+    gl->glGenTextures(gBufferAttachmentCount, textures);
+    for (GLuint i = 0; i < gBufferAttachmentCount; ++i) {
+        // Read with texelFetch only, one texel per pixel
+        gl->glBindTexture(GL_TEXTURE_2D, textures[i]);
+        gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+
+#ifdef QT_DEBUG
+    // Unbind to avoid accidental modification
+    gl->glBindTexture(GL_TEXTURE_2D, 0);
+#endif
+}
+
+void GBuffer::destroy() {
+    if (gl == nullptr) {
+        return;
+    }
+    gl->glDeleteFramebuffers(1, &framebuffer);
+    gl->glDeleteTextures(gBufferAttachmentCount, textures);
+    gl = nullptr;
+}
+
+bool GBuffer::resize(int width_, int height_) {
+    if (width_ == width && height_ == height) {
+        return complete;
+    }
+    width = width_;
+    height = height_;
+
+    GLint previousFramebuffer = 0;
+    gl->glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFramebuffer);
+    gl->glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    for (GLuint i = 0; i < gBufferAttachmentCount; ++i) {
+        const AttachmentFormat &format = attachmentFormats[i];
+        gl->glBindTexture(GL_TEXTURE_2D, textures[i]);
+        gl->glTexImage2D(GL_TEXTURE_2D, 0, static_cast<GLint>(format.internalFormat), width, height, 0, format.format, format.type, nullptr);
+
+        GLenum attachment = i == GBUFFER_DEPTH ? GL_DEPTH_ATTACHMENT : GL_COLOR_ATTACHMENT0 + i;
+        gl->glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, textures[i], 0);
+    }
+
+    const GLenum drawBuffers[] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2, GL_COLOR_ATTACHMENT3};
+    gl->glDrawBuffers(4, drawBuffers);
+
+    GLenum status = gl->glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    gl->glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(previousFramebuffer));
+
+#ifdef QT_DEBUG
+    // Unbind to avoid accidental modification
+    gl->glBindTexture(GL_TEXTURE_2D, 0);
+#endif
+
+    complete = status == GL_FRAMEBUFFER_COMPLETE;
+    if (!complete) {
+        std::cerr << "G-buffer framebuffer incomplete! [" << status << "]" << std::endl;
+    }
+    return complete;
+}
+
+void GBuffer::bindFramebuffer() {
+    gl->glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+}
+
+void GBuffer::bindTextures(GLuint firstUnit) {
+    for (GLuint i = 0; i < gBufferAttachmentCount; ++i) {
+        gl->glActiveTexture(GL_TEXTURE0 + firstUnit + i);
+        gl->glBindTexture(GL_TEXTURE_2D, textures[i]);
+    }
+    gl->glActiveTexture(GL_TEXTURE0);
+}
+
+size_t GBuffer::bytes() const {
+    size_t texelSize = 0;
+    for (const auto &format : attachmentFormats) {
+        texelSize += format.texelSize;
+    }
+    return static_cast<size_t>(width) * static_cast<size_t>(height) * texelSize;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <QOpenGLFunctions_3_3_Core>
+
+// G-buffer attachments (texture units are consecutive in this order when bound)
+enum GBufferAttachment : GLuint {
+    GBUFFER_ALBEDO = 0, // RGBA8, texture color and ambient red
+    GBUFFER_DIFFUSE = 1, // RGBA8, diffuse color and ambient green
+    GBUFFER_SPECULAR = 2, // RGBA8, specular color and ambient blue
+    GBUFFER_NORMAL = 3, // RGB10_A2, octahedral normal and specular power / 1023
+    GBUFFER_DEPTH = 4 // 24-bit depth, positions are reconstructed from it
+};
+
+const GLuint gBufferAttachmentCount = 5;
+
+// Surface attributes for deferred shading, written by geometry pass and read by lighting pass (OpenGL thread only)
+class GBuffer {
+public:
+    void initialize(QOpenGLFunctions_3_3_Core *gl_);
+    void destroy();
+
+    // Reallocate attachments when size changes, false if framebuffer is incomplete
+    bool resize(int width_, int height_);
+
+    // Draw into color attachments and depth
+    void bindFramebuffer();
+
+    // Bind attachments to consecutive texture units
+    void bindTextures(GLuint firstUnit);
+
+    size_t bytes() const; // GPU memory of attachments
+
+private:
+    QOpenGLFunctions_3_3_Core *gl = nullptr;
+    GLuint framebuffer = 0;
+    GLuint textures[gBufferAttachmentCount] = {0, 0, 0, 0, 0};
+    int width = 0;
+    int height = 0;
+    bool complete = false;
+};
@@ -0,0 +1,219 @@
+#include "lightclusters.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <QElapsedTimer>
+
+#include "parallel.h"
+
+namespace {
+
+// Fewer lights per band are not worth a pool task
+const size_t bandLights = 128;
+
+uint32_t clampCell(float value, uint32_t size) {
+    return static_cast<uint32_t>(std::min(std::max(value, 0.0f), static_cast<float>(size - 1)));
+}
+
+// Cluster range of light sphere, false if it is outside frustum
+bool lightClusterRange(const PointLight &light, const glm::mat4 &P, const glm::mat4 &V, const ClusterDepth &depth,
+                       glm::uvec3 &min /* out */, glm::uvec3 &max /* out */) {
+    glm::vec3 center = glm::vec3(V * glm::vec4(light.position, 1.0f));
+    float nearDepth = -center.z - light.radius;
+    float farDepth = -center.z + light.radius;
+    if (farDepth < depth.nearPlane || nearDepth > depth.farPlane) {
+        return false;
+    }
+    nearDepth = std::max(nearDepth, depth.nearPlane);
+    farDepth = std::min(farDepth, depth.farPlane);
+
+    // Projected corners of view space box, all in front of camera after clamping to near plane
+    glm::vec2 ndcMin(INFINITY), ndcMax(-INFINITY);
+    for (int corner = 0; corner < 8; ++corner) {
+        glm::vec4 position(center.x + ((corner & 1) ? light.radius : -light.radius),
+                           center.y + ((corner & 2) ? light.radius : -light.radius),
+                           (corner & 4) ? -farDepth : -nearDepth, 1.0f);
+        glm::vec4 clip = P * position;
+        glm::vec2 ndc = glm::vec2(clip) / clip.w;
+        ndcMin = glm::min(ndcMin, ndc);
+        ndcMax = glm::max(ndcMax, ndc);
+    }
+    if (ndcMax.x < -1.0f || ndcMax.y < -1.0f || ndcMin.x > 1.0f || ndcMin.y > 1.0f) {
+        return false;
+    }
+
+    min.x = clampCell(std::floor((ndcMin.x * 0.5f + 0.5f) * clusterGridX), clusterGridX);
+    min.y = clampCell(std::floor((ndcMin.y * 0.5f + 0.5f) * clusterGridY), clusterGridY);
+    min.z = clampCell(std::floor(depth.slice(nearDepth)), clusterGridZ);
+    max.x = clampCell(std::floor((ndcMax.x * 0.5f + 0.5f) * clusterGridX), clusterGridX);
+    max.y = clampCell(std::floor((ndcMax.y * 0.5f + 0.5f) * clusterGridY), clusterGridY);
+    max.z = clampCell(std::floor(depth.slice(farDepth)), clusterGridZ);
+    return true;
+}
+
+// Count (or write with offsets) lights of clusters in depth slices [sliceBegin, sliceEnd), slices are not shared between threads
+void fillSlices(ClusterLists &lists, size_t lightCount, uint32_t sliceBegin, uint32_t sliceEnd, bool write) {
+    for (size_t light = 0; light < lightCount; ++light) {
+        const glm::uvec3 &min = lists.lightMin[light];
+        const glm::uvec3 &max = lists.lightMax[light];
+        uint32_t zBegin = std::max(min.z, sliceBegin);
+        uint32_t zEnd = std::min(max.z + 1, sliceEnd);
+        for (uint32_t z = zBegin; z < zEnd; ++z) {
+            for (uint32_t y = min.y; y <= max.y; ++y) {
+                uint32_t cluster = (z * clusterGridY + y) * clusterGridX + min.x;
+                for (uint32_t x = min.x; x <= max.x; ++x, ++cluster) {
+                    if (write) {
+                        lists.indices[lists.ranges[cluster * 2] + lists.counts[cluster]] = static_cast<uint16_t>(light);
+                    }
+                    ++lists.counts[cluster];
+                }
+            }
+        }
+    }
+}
+
+} // namespace
+
+float lightRadius(float power, const glm::vec3 &color) {
+    float intensity = power * std::max(color.r, std::max(color.g, color.b));
+    return std::sqrt(std::max(intensity, 0.0f) / lightCutoffIntensity);
+}
+
+ClusterDepth::ClusterDepth(float nearPlane_, float farPlane_, bool logarithmic_)
+    : nearPlane(nearPlane_), farPlane(farPlane_), logarithmic(logarithmic_) {
+    // Logarithmic slices keep clusters roughly cubic in perspective, orthographic clusters are equally deep
+    if (logarithmic) {
+        float range = std::log(farPlane / nearPlane);
+        scale = clusterGridZ / range;
+        bias = -clusterGridZ * std::log(nearPlane) / range;
+    } else {
+        scale = clusterGridZ / (farPlane - nearPlane);
+        bias = -nearPlane * scale;
+    }
+}
+
+float ClusterDepth::slice(float depth) const {
+    if (logarithmic) {
+        return std::log(std::max(depth, nearPlane)) * scale + bias;
+    }
+    return depth * scale + bias;
+}
+
+ClusterStats assignLights(const std::vector<PointLight> &lights, const glm::mat4 &P, const glm::mat4 &V, const ClusterDepth &depth,
+                          ClusterLists &lists) {
+    QElapsedTimer timer;
+    timer.start();
+
+    ClusterStats stats;
+    size_t lightCount = std::min(lights.size(), maxClusteredLights);
+    stats.lights = static_cast<uint32_t>(lightCount);
+
+    // Cluster range of each light (empty range if outside frustum)
+    lists.lightMin.resize(lightCount);
+    lists.lightMax.resize(lightCount);
+    parallelFor(lightCount, bandLights, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            if (!lightClusterRange(lights[i], P, V, depth, lists.lightMin[i], lists.lightMax[i])) {
+                lists.lightMin[i] = glm::uvec3(1);
+                lists.lightMax[i] = glm::uvec3(0);
+            }
+        }
+    });
+
+    // Count lights per cluster, prefix sum into offsets, then write indices in light order
+    lists.counts.assign(clusterCount, 0);
+    lists.ranges.resize(clusterCount * 2);
+    size_t bandSlices = lightCount < bandLights * 2 ? clusterGridZ : 1; // Work per slice grows with lights
+    auto countSlices = [&](size_t begin, size_t end) {
+        fillSlices(lists, lightCount, static_cast<uint32_t>(begin), static_cast<uint32_t>(end), false);
+    };
+    parallelFor(clusterGridZ, bandSlices, countSlices);
+
+    uint32_t offset = 0;
+    for (uint32_t cluster = 0; cluster < clusterCount; ++cluster) {
+        uint32_t count = lists.counts[cluster];
+        lists.ranges[cluster * 2] = offset;
+        lists.ranges[cluster * 2 + 1] = count;
+        offset += count;
+        stats.maxClusterLights = std::max(stats.maxClusterLights, count);
+        stats.occupiedClusters += count > 0;
+    }
+    stats.assignments = offset;
+
+    lists.indices.resize(offset);
+    std::fill(lists.counts.begin(), lists.counts.end(), 0);
+    auto writeSlices = [&](size_t begin, size_t end) {
+        fillSlices(lists, lightCount, static_cast<uint32_t>(begin), static_cast<uint32_t>(end), true);
+    };
+    parallelFor(clusterGridZ, bandSlices, writeSlices);
+
+    for (size_t i = 0; i < lightCount; ++i) {
+        stats.visibleLights += lists.lightMin[i].x <= lists.lightMax[i].x;
+    }
+    stats.buildTime = timer.nsecsElapsed() / 1e6;
+    return stats;
+}
+
+void LightClusters::initialize(QOpenGLFunctions_3_3_Core *gl_) {
+    gl = gl_;
+
+    // Lights as position and radius, color texels, ranges as offset and count, 16-bit indices
+    const GLenum formats[3] = {GL_RGBA32F, GL_RG32UI, GL_R16UI};
+    gl->glGenBuffers(3, buffers);
+    gl->glGenTextures(3, textures);
+    for (int i = 0; i < 3; ++i) {
+        gl->glBindBuffer(GL_TEXTURE_BUFFER, buffers[i]);
+        gl->glBufferData(GL_TEXTURE_BUFFER, 16, nullptr, GL_STREAM_DRAW); // Never empty
+        gl->glBindTexture(GL_TEXTURE_BUFFER, textures[i]);
+        gl->glTexBuffer(GL_TEXTURE_BUFFER, formats[i], buffers[i]);
+    }
+
+#ifdef QT_DEBUG
+    // Unbind to avoid accidental modification
+    gl->glBindTexture(GL_TEXTURE_BUFFER, 0);
+    gl->glBindBuffer(GL_TEXTURE_BUFFER, 0);
+#endif
+}
+
+void LightClusters::destroy() {
+    if (gl == nullptr) {
+        return;
+    }
+    gl->glDeleteTextures(3, textures);
+    gl->glDeleteBuffers(3, buffers);
+    gl = nullptr;
+}
+
+size_t LightClusters::update(const std::vector<PointLight> &lights, const glm::mat4 &P, const glm::mat4 &V, const ClusterDepth &depth) {
+    lastStats = assignLights(lights, P, V, depth, lists);
+
+    size_t bytes = upload(buffers[0], lights.data(), lastStats.lights * sizeof(PointLight));
+    bytes += upload(buffers[1], lists.ranges.data(), lists.ranges.size() * sizeof(uint32_t));
+    bytes += upload(buffers[2], lists.indices.data(), lists.indices.size() * sizeof(uint16_t));
+
+#ifdef QT_DEBUG
+    // Unbind to avoid accidental modification
+    gl->glBindBuffer(GL_TEXTURE_BUFFER, 0);
+#endif
+
+    return bytes;
+}
+
+size_t LightClusters::upload(GLuint buffer, const void *data, size_t size) {
+    // Orphan previous contents (may still be read by frames in flight), texture keeps pointing at buffer
+    gl->glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+    gl->glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(std::max<size_t>(size, 16)), nullptr, GL_STREAM_DRAW);
+    if (size > 0) {
+        gl->glBufferSubData(GL_TEXTURE_BUFFER, 0, static_cast<GLsizeiptr>(size), data);
+    }
+    return size;
+}
+
+void LightClusters::bind(GLuint firstUnit) {
+    for (GLuint i = 0; i < 3; ++i) {
+        gl->glActiveTexture(GL_TEXTURE0 + firstUnit + i);
+        gl->glBindTexture(GL_TEXTURE_BUFFER, textures[i]);
+    }
+    gl->glActiveTexture(GL_TEXTURE0);
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <QOpenGLFunctions_3_3_Core>
+
+#include <glm/glm.hpp>
+
+// Froxel grid over view frustum (screen tiles times depth slices), must match ClusterGrid in fragment shader
+const uint32_t clusterGridX = 16;
+const uint32_t clusterGridY = 9;
+const uint32_t clusterGridZ = 24;
+const uint32_t clusterCount = clusterGridX * clusterGridY * clusterGridZ;
+
+// Light indices are 16-bit in cluster lists
+const size_t maxClusteredLights = 65535;
+
+// Intensity (power * color / distance^2) at which light range ends, shaders fade lights out towards it
+const float lightCutoffIntensity = 0.01f;
+
+// Point light in world space, radius bounds its influence
+struct PointLight {
+    glm::vec3 position;
+    float radius;
+    glm::vec3 color; // Color * power
+    float padding;
+};
+
+static_assert(sizeof(PointLight) == 32, "Point light must match 2 RGBA32F texels");
+
+// Distance at which light of given power and color falls below cutoff intensity
+float lightRadius(float power, const glm::vec3 &color);
+
+// Depth slicing of grid, slice = depth * scale + bias (logarithmic depth for perspective projections)
+struct ClusterDepth {
+    float nearPlane = 0.0f; // Projection planes
+    float farPlane = 0.0f;
+    float scale = 0.0f;
+    float bias = 0.0f;
+    bool logarithmic = true;
+
+    ClusterDepth() = default;
+    ClusterDepth(float nearPlane_, float farPlane_, bool logarithmic_);
+
+    float slice(float depth) const; // Depth is positive distance along view direction
+};
+
+// Compact light lists of all clusters (cluster index = (z * Y + y) * X + x)
+struct ClusterLists {
+    std::vector<uint32_t> ranges; // Offset and count pairs into indices, per cluster
+    std::vector<uint16_t> indices;
+    std::vector<uint32_t> counts; // Helpers, reused between builds
+    std::vector<glm::uvec3> lightMin; // Cluster range of each light, min > max if outside frustum
+    std::vector<glm::uvec3> lightMax;
+};
+
+struct ClusterStats {
+    uint32_t lights = 0;
+    uint32_t visibleLights = 0; // Intersecting frustum
+    uint32_t assignments = 0; // Total light indices
+    uint32_t maxClusterLights = 0;
+    uint32_t occupiedClusters = 0;
+    double buildTime = 0.0; // CPU milliseconds
+};
+
+// Assign lights to clusters they may touch (conservative, view space box of light sphere)
+// Lights are split into bands on the shared thread pool above a threshold, lists by depth slices
+ClusterStats assignLights(const std::vector<PointLight> &lights, const glm::mat4 &P, const glm::mat4 &V, const ClusterDepth &depth,
+                          ClusterLists &lists /* out */);
+
+// Lights and cluster lists in texture buffers (OpenGL thread only), updated every frame
+class LightClusters {
+public:
+    void initialize(QOpenGLFunctions_3_3_Core *gl_);
+    void destroy();
+
+    // Build lists for projection and view, upload them with lights, returns uploaded bytes
+    size_t update(const std::vector<PointLight> &lights, const glm::mat4 &P, const glm::mat4 &V, const ClusterDepth &depth);
+
+    // Bind lights, cluster ranges and light indices to 3 consecutive texture units
+    void bind(GLuint firstUnit);
+
+    const ClusterStats &stats() const { return lastStats; }
+
+private:
+    QOpenGLFunctions_3_3_Core *gl = nullptr;
+    GLuint buffers[3] = {0, 0, 0}; // Lights, ranges, indices
+    GLuint textures[3] = {0, 0, 0};
+    ClusterLists lists;
+    ClusterStats lastStats;
+
+    size_t upload(GLuint buffer, const void *data, size_t size);
+};
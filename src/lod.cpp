@@ -0,0 +1,310 @@
+#include "lod.h"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+#include "meshoptimize.h"
+
+namespace {
+
+// Sum of squared distances to planes (symmetric 4x4 matrix), weighted by triangle area
+struct Quadric {
+    double a2 = 0, ab = 0, ac = 0, ad = 0;
+    double b2 = 0, bc = 0, bd = 0;
+    double c2 = 0, cd = 0;
+    double d2 = 0;
+    double weight = 0;
+
+    void addPlane(const glm::dvec3 &normal, double d, double w) {
+        a2 += w * normal.x * normal.x; ab += w * normal.x * normal.y; ac += w * normal.x * normal.z; ad += w * normal.x * d;
+        b2 += w * normal.y * normal.y; bc += w * normal.y * normal.z; bd += w * normal.y * d;
+        c2 += w * normal.z * normal.z; cd += w * normal.z * d;
+        d2 += w * d * d;
+        weight += w;
+    }
+
+    void add(const Quadric &q) {
+        a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad;
+        b2 += q.b2; bc += q.bc; bd += q.bd;
+        c2 += q.c2; cd += q.cd;
+        d2 += q.d2;
+        weight += q.weight;
+    }
+
+    // Mean squared distance of point to accumulated planes
+    double error(const glm::vec3 &p) const {
+        double x = p.x, y = p.y, z = p.z;
+        double sum = a2 * x * x + 2 * ab * x * y + 2 * ac * x * z + 2 * ad * x +
+                     b2 * y * y + 2 * bc * y * z + 2 * bd * y +
+                     c2 * z * z + 2 * cd * z + d2;
+        return weight > 0 ? std::abs(sum) / weight : 0;
+    }
+};
+
+struct Collapse {
+    GLuint from;
+    GLuint to;
+    double error;
+};
+
+struct PositionHash {
+    size_t operator()(const glm::vec3 &p) const {
+        size_t h = std::hash<float>()(p.x);
+        h = h * 31 + std::hash<float>()(p.y);
+        return h * 31 + std::hash<float>()(p.z);
+    }
+};
+
+// Collapses edges in passes, quadrics and error carry over between successive targets (levels)
+class Simplifier {
+public:
+    Simplifier(const Vertex *vertices_, size_t vertexCount_, const GLuint *indices, size_t indexCount)
+        : vertices(vertices_), vertexCount(vertexCount_), result(indices, indices + indexCount),
+          quadrics(vertexCount_), locked(vertexCount_, 0) {
+        lockSeamsAndBorders();
+
+        for (size_t i = 0; i + 2 < result.size(); i += 3) {
+            glm::dvec3 p0(position(result[i])), p1(position(result[i + 1])), p2(position(result[i + 2]));
+            glm::dvec3 normal = glm::cross(p1 - p0, p2 - p0);
+            double length = glm::length(normal);
+            if (length == 0) {
+                continue;
+            }
+            normal /= length;
+            double d = -glm::dot(normal, p0);
+            for (int j = 0; j < 3; ++j) {
+                quadrics[result[i + j]].addPlane(normal, d, length * 0.5);
+            }
+        }
+    }
+
+    // Collapse until at most target indices are left, false if nothing could be collapsed
+    bool simplify(size_t targetIndexCount) {
+        size_t startCount = result.size();
+        while (result.size() > targetIndexCount) {
+            if (!pass((result.size() - targetIndexCount) / 3)) {
+                break;
+            }
+        }
+        return result.size() < startCount;
+    }
+
+    const std::vector<GLuint> &indices() const { return result; }
+    float error() const { return static_cast<float>(std::sqrt(maxError)); }
+
+private:
+    const Vertex *vertices;
+    size_t vertexCount;
+    std::vector<GLuint> result;
+    std::vector<Quadric> quadrics;
+    std::vector<uint8_t> locked;
+    double maxError = 0;
+
+    // Triangles around each vertex (rebuilt every pass)
+    std::vector<uint32_t> adjacencyOffsets;
+    std::vector<uint32_t> adjacency;
+
+    std::vector<Collapse> collapses; // Reused between passes
+    std::vector<GLuint> target;
+    std::vector<uint8_t> touched;
+
+    const glm::vec3 &position(GLuint vertex) const { return vertices[vertex].position; }
+
+    void lockSeamsAndBorders() {
+        // Seams, vertices sharing position with another vertex (attributes differ)
+        std::unordered_map<glm::vec3, GLuint, PositionHash> positions;
+        positions.reserve(vertexCount);
+        for (GLuint i = 0; i < vertexCount; ++i) {
+            auto inserted = positions.emplace(vertices[i].position, i);
+            if (!inserted.second) {
+                locked[i] = 1;
+                locked[inserted.first->second] = 1;
+            }
+        }
+
+        // Borders, edges without opposite half-edge
+        std::unordered_map<uint64_t, uint32_t> edges;
+        edges.reserve(result.size());
+        auto edgeKey = [](GLuint a, GLuint b) { return (static_cast<uint64_t>(a) << 32) | b; };
+        for (size_t i = 0; i + 2 < result.size(); i += 3) {
+            for (int j = 0; j < 3; ++j) {
+                ++edges[edgeKey(result[i + j], result[i + (j + 1) % 3])];
+            }
+        }
+        for (const auto &edge : edges) {
+            GLuint a = static_cast<GLuint>(edge.first >> 32), b = static_cast<GLuint>(edge.first & 0xFFFFFFFF);
+            if (edge.second != 1 || edges.find(edgeKey(b, a)) == edges.end()) {
+                locked[a] = 1;
+                locked[b] = 1;
+            }
+        }
+    }
+
+    void buildAdjacency() {
+        adjacencyOffsets.assign(vertexCount + 1, 0);
+        for (GLuint vertex : result) {
+            ++adjacencyOffsets[vertex + 1];
+        }
+        for (size_t i = 0; i < vertexCount; ++i) {
+            adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+        }
+        adjacency.resize(result.size());
+        std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for (size_t i = 0; i < result.size(); ++i) {
+            adjacency[fill[result[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+    }
+
+    // Moving vertex onto another must not turn any remaining triangle around
+    bool flips(GLuint from, GLuint to) const {
+        const glm::vec3 &moved = position(to);
+        for (uint32_t a = adjacencyOffsets[from]; a < adjacencyOffsets[from + 1]; ++a) {
+            const GLuint *triangle = &result[adjacency[a] * 3];
+            if (triangle[0] == to || triangle[1] == to || triangle[2] == to) {
+                continue; // Collapsed away
+            }
+
+            // Rotate so from is first
+            int k = triangle[0] == from ? 0 : (triangle[1] == from ? 1 : 2);
+            const glm::vec3 &p0 = position(from);
+            const glm::vec3 &p1 = position(triangle[(k + 1) % 3]);
+            const glm::vec3 &p2 = position(triangle[(k + 2) % 3]);
+            glm::vec3 before = glm::cross(p1 - p0, p2 - p0);
+            glm::vec3 after = glm::cross(p1 - moved, p2 - moved);
+            if (glm::dot(before, after) <= 0.0f) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool pass(size_t trianglesToRemove) {
+        buildAdjacency();
+
+        // Candidates along every edge, in both directions where vertex may move
+        collapses.clear();
+        for (size_t i = 0; i + 2 < result.size(); i += 3) {
+            for (int j = 0; j < 3; ++j) {
+                GLuint a = result[i + j], b = result[i + (j + 1) % 3];
+                Quadric q = quadrics[a];
+                q.add(quadrics[b]);
+                if (!locked[a]) {
+                    collapses.push_back({a, b, q.error(position(b))});
+                }
+                if (!locked[b]) {
+                    collapses.push_back({b, a, q.error(position(a))});
+                }
+            }
+        }
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse &a, const Collapse &b) { return a.error < b.error; });
+
+        // Cheapest first, vertices around a collapse are not touched again in same pass (their costs changed)
+        target.resize(vertexCount);
+        for (GLuint i = 0; i < vertexCount; ++i) {
+            target[i] = i;
+        }
+        touched.assign(vertexCount, 0);
+        size_t removed = 0;
+        for (const auto &collapse : collapses) {
+            if (removed >= trianglesToRemove) {
+                break;
+            }
+            if (touched[collapse.from] || touched[collapse.to] || flips(collapse.from, collapse.to)) {
+                continue;
+            }
+
+            target[collapse.from] = collapse.to;
+            quadrics[collapse.to].add(quadrics[collapse.from]);
+            maxError = std::max(maxError, collapse.error);
+
+            for (uint32_t a = adjacencyOffsets[collapse.from]; a < adjacencyOffsets[collapse.from + 1]; ++a) {
+                const GLuint *triangle = &result[adjacency[a] * 3];
+                bool collapsed = false;
+                for (int k = 0; k < 3; ++k) {
+                    touched[triangle[k]] = 1;
+                    collapsed = collapsed || triangle[k] == collapse.to;
+                }
+                removed += collapsed ? 1 : 0;
+            }
+        }
+
+        if (removed == 0) {
+            return false;
+        }
+
+        // Remap and drop degenerate triangles
+        size_t count = 0;
+        for (size_t i = 0; i + 2 < result.size(); i += 3) {
+            GLuint a = target[result[i]], b = target[result[i + 1]], c = target[result[i + 2]];
+            if (a != b && b != c && c != a) {
+                result[count++] = a;
+                result[count++] = b;
+                result[count++] = c;
+            }
+        }
+        result.resize(count);
+        return true;
+    }
+};
+
+} // namespace
+
+std::vector<GLuint> simplifyMesh(const Vertex *vertices, size_t vertexCount, const GLuint *indices, size_t indexCount,
+                                 size_t targetIndexCount, float *error) {
+    Simplifier simplifier(vertices, vertexCount, indices, indexCount);
+    simplifier.simplify(targetIndexCount);
+    if (error != nullptr) {
+        *error = simplifier.error();
+    }
+    return simplifier.indices();
+}
+
+void generateLevels(const Vertex *vertices, size_t vertexCount, const GLuint *indices, size_t indexCount,
+                    std::vector<GLuint> &levelIndices, std::vector<MeshLevel> &levels) {
+    levels.clear();
+    levelIndices.clear();
+    levels.push_back({0, static_cast<uint32_t>(indexCount), 0.0f});
+    if (indexCount / 3 < lodMinTriangles) {
+        return;
+    }
+
+    Simplifier simplifier(vertices, vertexCount, indices, indexCount);
+    while (levels.size() < lodMaxLevels) {
+        size_t previousCount = levels.back().indexCount;
+        simplifier.simplify(previousCount / 6 * 3);
+
+        // Stalled (mostly seams or borders left), level would barely save anything
+        size_t count = simplifier.indices().size();
+        if (count > previousCount * 3 / 4) {
+            break;
+        }
+
+        levels.push_back({static_cast<uint32_t>(indexCount + levelIndices.size()), static_cast<uint32_t>(count), simplifier.error()});
+        levelIndices.insert(levelIndices.end(), simplifier.indices().begin(), simplifier.indices().end());
+        optimizeVertexCache(&levelIndices[levelIndices.size() - count], count, vertexCount);
+    }
+}
+
+uint32_t selectLevel(const std::vector<MeshLevel> &levels, uint32_t current, float tolerance, float hysteresis) {
+    // Coarsest level within tolerance (error grows with level)
+    uint32_t desired = 0;
+    for (uint32_t level = 1; level < levels.size(); ++level) {
+        if (levels[level].error <= tolerance) {
+            desired = level;
+        }
+    }
+
+    if (desired <= current) {
+        return desired; // Current level is too coarse now (or still the right one)
+    }
+
+    // Step to coarser levels only when clearly within tolerance
+    uint32_t level = std::min<uint32_t>(current, static_cast<uint32_t>(levels.size()) - 1);
+    for (uint32_t coarser = level + 1; coarser <= desired; ++coarser) {
+        if (levels[coarser].error <= tolerance * hysteresis) {
+            level = coarser;
+        }
+    }
+    return level;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "mesh.h"
+
+// Index range of one level of detail, all levels of a mesh share its vertices
+struct MeshLevel {
+    uint32_t firstIndex; // Relative to start of mesh indices
+    uint32_t indexCount;
+    float error; // Geometric error (local units), approximate distance of simplified surface from original
+};
+
+// Levels of detail of meshes with at least this many triangles are generated
+const size_t lodMinTriangles = 1024;
+const size_t lodMaxLevels = 5; // Including original
+
+// Simplify by collapsing edges onto existing vertices in order of quadric error, until at most target index count is left
+// Vertices on UV/normal seams (same position, different attributes) and open borders are never moved
+std::vector<GLuint> simplifyMesh(const Vertex *vertices, size_t vertexCount, const GLuint *indices, size_t indexCount,
+                                 size_t targetIndexCount, float *error = nullptr /* out */);
+
+// Levels of detail, each with about half the triangles of previous one (stops early when simplification stalls)
+// Level 0 is the original mesh, indices of further levels are appended to levelIndices
+void generateLevels(const Vertex *vertices, size_t vertexCount, const GLuint *indices, size_t indexCount,
+                    std::vector<GLuint> &levelIndices /* out */, std::vector<MeshLevel> &levels /* out */);
+
+// Level to draw with given geometric error tolerance (in local units, eg. a pixel projected at object's distance)
+// Coarser levels are only taken once their error is below tolerance by hysteresis factor, so levels don't flicker at threshold
+uint32_t selectLevel(const std::vector<MeshLevel> &levels, uint32_t current, float tolerance, float hysteresis = 0.8f);
@@ -1,7 +1,9 @@
 #include "mainwindow.h"
+#include "benchmark.h"
 
 #include <QApplication>
 #include <QSurfaceFormat>
+#include <QCommandLineParser>
 
 int main(int argc, char *argv[]) {
     // Parameters for loading OpenGL context, version selection
@@ -10,10 +12,146 @@ int main(int argc, char *argv[]) {
     glFormat.setProfile(QSurfaceFormat::CoreProfile);
     QSurfaceFormat::setDefaultFormat(glFormat);
 
+    // CPU benchmarks and headless frame benchmark don't open any windows, don't require a display for them
+    const char *cpuBenchmarks[] = {"--benchmark-obj", "--benchmark-cache", "--benchmark-mipmaps", "--benchmark-culling", "--benchmark-scene", "--benchmark-pyramid", "--benchmark-allocator", "--benchmark-lod", "--benchmark-vertexcache", "--benchmark-quantization", "--benchmark-frames", "--benchmark-lights", "--benchmark-shading", "--benchmark-variants", "--benchmark-startup", "--benchmark-bumpmap", "--benchmark-mapping"};
+    for (int i = 1; i < argc; ++i) {
+        for (const char *benchmark : cpuBenchmarks) {
+            if (QByteArray(argv[i]).startsWith(benchmark) && qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+                qputenv("QT_QPA_PLATFORM", "offscreen");
+            }
+        }
+    }
+
     // Desktop OpenGL has to be selected for Windows compatibility
     // http://doc.qt.io/qt-5/windows-requirements.html#graphics-drivers
     QApplication::setAttribute(Qt::AA_UseDesktopOpenGL);
     QApplication a(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    parser.addPositionalArgument("files", "OBJ files or images used by benchmarks.", "[files...]");
+    QCommandLineOption benchmarkOBJOption("benchmark-obj", "Benchmark OBJ parsing of a generated model with <faces> faces and given models.", "faces");
+    parser.addOption(benchmarkOBJOption);
+    QCommandLineOption benchmarkCacheOption("benchmark-cache", "Benchmark cold (OBJ parsing) and warm (mesh cache mapping) loading of given models.");
+    parser.addOption(benchmarkCacheOption);
+    QCommandLineOption benchmarkCullingOption("benchmark-culling", "Benchmark frustum culling of <objects> randomly scattered objects.", "objects");
+    parser.addOption(benchmarkCullingOption);
+    QCommandLineOption benchmarkSceneOption("benchmark-scene", "Benchmark adding, updating and removing up to <objects> scene objects through handles.", "objects");
+    parser.addOption(benchmarkSceneOption);
+    QCommandLineOption benchmarkPyramidOption("benchmark-pyramid", "Benchmark stamped, greedy meshed and instanced pyramid generation, triangle counts and buffer sizes.");
+    parser.addOption(benchmarkPyramidOption);
+    QCommandLineOption benchmarkAllocatorOption("benchmark-allocator", "Benchmark mesh buffer allocator fragmentation while adding and removing <meshes> meshes.", "meshes");
+    parser.addOption(benchmarkAllocatorOption);
+    QCommandLineOption benchmarkLODOption("benchmark-lod", "Benchmark level of detail generation of given models (or a generated sphere) and triangles drawn at many distances.");
+    parser.addOption(benchmarkLODOption);
+    QCommandLineOption benchmarkVertexCacheOption("benchmark-vertexcache", "Benchmark vertex cache efficiency of given models and generated pyramids before and after optimization.");
+    parser.addOption(benchmarkVertexCacheOption);
+    QCommandLineOption benchmarkQuantizationOption("benchmark-quantization", "Benchmark precision error and memory of packed vertices of given models (or a generated sphere).");
+    parser.addOption(benchmarkQuantizationOption);
+    QCommandLineOption benchmarkVertexFormatsOption("benchmark-vertexformats", "Benchmark GPU time of drawing given models (or a generated sphere) with float and packed vertices.");
+    parser.addOption(benchmarkVertexFormatsOption);
+    QCommandLineOption benchmarkFramesOption("benchmark-frames", "Benchmark CPU and GPU frame times of <frames> frames rendered headless along a camera path (JSON report).", "frames");
+    parser.addOption(benchmarkFramesOption);
+    QCommandLineOption sceneScaleOption("scene-scale", "Scaled-up object variants added to frame benchmark scene (0 - built-in objects only).", "scale", "1");
+    parser.addOption(sceneScaleOption);
+    QCommandLineOption frameSizeOption("frame-size", "Frame benchmark framebuffer size.", "WxH", "1280x720");
+    parser.addOption(frameSizeOption);
+    QCommandLineOption dumpFramesOption("dump-frames", "Save every frame benchmark frame as PNG into <directory>.", "directory");
+    parser.addOption(dumpFramesOption);
+    QCommandLineOption deferredOption("deferred", "Render frame benchmark with deferred shading.");
+    parser.addOption(deferredOption);
+    QCommandLineOption packedVerticesOption("packed-vertices", "Render frame benchmark with packed vertices and 16-bit indices.");
+    parser.addOption(packedVerticesOption);
+    QCommandLineOption outputOption("output", "Write frame benchmark JSON report to <file> instead of standard output.", "file");
+    parser.addOption(outputOption);
+    QCommandLineOption benchmarkLightsOption("benchmark-lights", "Benchmark light clustering and frame times of benchmark scene rendered headless with up to <lights> point lights.", "lights");
+    parser.addOption(benchmarkLightsOption);
+    QCommandLineOption benchmarkShadingOption("benchmark-shading", "Benchmark forward and deferred shading of an overdraw heavy scene with up to <lights> point lights.", "lights");
+    parser.addOption(benchmarkShadingOption);
+    QCommandLineOption benchmarkVariantsOption("benchmark-variants", "Benchmark specialized shader variants against one branching program, vertex and fragment bound.");
+    parser.addOption(benchmarkVariantsOption);
+    QCommandLineOption benchmarkStartupOption("benchmark-startup", "Benchmark startup time without, with a cold and with a warm program binary cache.");
+    parser.addOption(benchmarkStartupOption);
+    QCommandLineOption benchmarkBumpMapOption("benchmark-bumpmap", "Benchmark normal map conversion of given images (or a generated one) and derivative bump mapping against normal mapping.");
+    parser.addOption(benchmarkBumpMapOption);
+    QCommandLineOption benchmarkMappingOption("benchmark-mapping", "Benchmark baking of procedural texture mappings into UVs of a generated sphere with about <vertices> vertices.", "vertices");
+    parser.addOption(benchmarkMappingOption);
+    QCommandLineOption benchmarkMipmapsOption("benchmark-mipmaps", "Benchmark mip chain generation of given images (or a generated one).");
+    parser.addOption(benchmarkMipmapsOption);
+    QCommandLineOption benchmarkSamplingOption("benchmark-sampling", "Benchmark texture sampling at several camera distances with first given image (or a generated one).");
+    parser.addOption(benchmarkSamplingOption);
+    parser.process(a);
+
+    if (parser.isSet(benchmarkOBJOption)) {
+        return benchmarkOBJParser(parser.positionalArguments(), parser.value(benchmarkOBJOption).toUInt());
+    }
+    if (parser.isSet(benchmarkCacheOption)) {
+        return benchmarkMeshCache(parser.positionalArguments());
+    }
+    if (parser.isSet(benchmarkCullingOption)) {
+        return benchmarkCulling(parser.value(benchmarkCullingOption).toUInt());
+    }
+    if (parser.isSet(benchmarkSceneOption)) {
+        return benchmarkScene(parser.value(benchmarkSceneOption).toUInt());
+    }
+    if (parser.isSet(benchmarkPyramidOption)) {
+        return benchmarkPyramid();
+    }
+    if (parser.isSet(benchmarkAllocatorOption)) {
+        return benchmarkMeshAllocator(parser.value(benchmarkAllocatorOption).toUInt());
+    }
+    if (parser.isSet(benchmarkLODOption)) {
+        return benchmarkLevelsOfDetail(parser.positionalArguments());
+    }
+    if (parser.isSet(benchmarkVertexCacheOption)) {
+        return benchmarkVertexCache(parser.positionalArguments());
+    }
+    if (parser.isSet(benchmarkQuantizationOption)) {
+        return benchmarkQuantization(parser.positionalArguments());
+    }
+    if (parser.isSet(benchmarkVertexFormatsOption)) {
+        return benchmarkVertexFormats(parser.positionalArguments());
+    }
+    if (parser.isSet(benchmarkFramesOption)) {
+        FrameBenchmarkOptions options;
+        options.frames = parser.value(benchmarkFramesOption).toUInt();
+        options.sceneScale = parser.value(sceneScaleOption).toUInt();
+        QStringList size = parser.value(frameSizeOption).split('x');
+        if (size.size() == 2 && size[0].toInt() > 0 && size[1].toInt() > 0) {
+            options.width = size[0].toInt();
+            options.height = size[1].toInt();
+        }
+        options.deferred = parser.isSet(deferredOption);
+        options.packedVertices = parser.isSet(packedVerticesOption);
+        options.dumpDirectory = parser.value(dumpFramesOption);
+        options.outputPath = parser.value(outputOption);
+        return benchmarkFrames(options);
+    }
+    if (parser.isSet(benchmarkLightsOption)) {
+        return benchmarkLights(parser.value(benchmarkLightsOption).toUInt());
+    }
+    if (parser.isSet(benchmarkShadingOption)) {
+        return benchmarkShading(parser.value(benchmarkShadingOption).toUInt());
+    }
+    if (parser.isSet(benchmarkVariantsOption)) {
+        return benchmarkShaderVariants();
+    }
+    if (parser.isSet(benchmarkStartupOption)) {
+        return benchmarkStartup();
+    }
+    if (parser.isSet(benchmarkBumpMapOption)) {
+        return benchmarkBumpMapping(parser.positionalArguments());
+    }
+    if (parser.isSet(benchmarkMappingOption)) {
+        return benchmarkTextureMapping(parser.value(benchmarkMappingOption).toUInt());
+    }
+    if (parser.isSet(benchmarkMipmapsOption)) {
+        return benchmarkMipmaps(parser.positionalArguments());
+    }
+    if (parser.isSet(benchmarkSamplingOption)) {
+        return benchmarkTextureSampling(parser.positionalArguments());
+    }
+
     MainWindow w;
     w.show();
 
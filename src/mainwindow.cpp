@@ -7,6 +7,21 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), ui(new Ui::MainWi
 
     // Link WidgetOpenGLDraw and ComboBox (object selection)
     ui->widget->objectSelection = ui->objectSelection;
+
+    // Model loading progress and cancellation in status bar (shown only while loading)
+    loadProgressBar = new QProgressBar(this);
+    loadProgressBar->setFormat("Loading models %v/%m");
+    loadProgressBar->hide();
+    ui->statusBar->addPermanentWidget(loadProgressBar);
+
+    loadCancelButton = new QPushButton("Cancel", this);
+    loadCancelButton->setFocusPolicy(Qt::NoFocus);
+    loadCancelButton->hide();
+    ui->statusBar->addPermanentWidget(loadCancelButton);
+
+    QObject::connect(&ui->widget->modelLoader, SIGNAL(progress(int, int)), this, SLOT(modelLoadProgress(int, int)));
+    QObject::connect(&ui->widget->modelLoader, SIGNAL(finished()), this, SLOT(modelLoadFinished()));
+    QObject::connect(loadCancelButton, SIGNAL(clicked()), &ui->widget->modelLoader, SLOT(cancel()));
 }
 
 MainWindow::~MainWindow() {
@@ -95,12 +110,31 @@ void MainWindow::on_applyBumpMapButton_clicked() {
     }
 }
 
+void MainWindow::on_removeObjectButton_clicked() {
+    if (!ui->widget->isMeshObjectSelected() && ui->widget->lights.size() == 1) {
+        std::cerr << "Last light can not be removed" << std::endl;
+        return;
+    }
+
+    ui->widget->removeSelectedObject();
+}
+
+void MainWindow::on_addLightButton_clicked() {
+    ui->widget->addLight();
+}
+
 void MainWindow::on_lightColorButton_clicked() {
+    if (ui->widget->isMeshObjectSelected()) {
+        std::cerr << "Light color can only be applied to a light" << std::endl;
+        return;
+    }
+
     QColor color = QColorDialog::getColor();
     resetOpenGLContext();
 
-    if (color.isValid()) {
-        ui->widget->light.color = {color.redF(), color.greenF(), color.blueF()};
+    LightObject *light = ui->widget->selectedLight();
+    if (color.isValid() && light != nullptr) {
+        light->color = {color.redF(), color.greenF(), color.blueF()};
         ui->widget->update(); // Redraw scene
     }
 }
@@ -114,9 +148,9 @@ void MainWindow::on_objectAmbientColorButton_clicked() {
     QColor color = QColorDialog::getColor();
     resetOpenGLContext();
 
-    if (color.isValid()) {
-        MeshObject *object = static_cast<MeshObject *>(ui->widget->selectedObject);
-        object->material.ambientColor = {color.redF(), color.greenF(), color.blueF()};
+    Material *material = ui->widget->selectedMaterial();
+    if (color.isValid() && material != nullptr) {
+        material->ambientColor = {color.redF(), color.greenF(), color.blueF()};
         ui->widget->update(); // Redraw scene
     }
 }
@@ -130,9 +164,9 @@ void MainWindow::on_objectDiffuseColorButton_clicked() {
     QColor color = QColorDialog::getColor();
     resetOpenGLContext();
 
-    if (color.isValid()) {
-        MeshObject *object = static_cast<MeshObject *>(ui->widget->selectedObject);
-        object->material.diffuseColor = {color.redF(), color.greenF(), color.blueF()};
+    Material *material = ui->widget->selectedMaterial();
+    if (color.isValid() && material != nullptr) {
+        material->diffuseColor = {color.redF(), color.greenF(), color.blueF()};
         ui->widget->update(); // Redraw scene
     }
 }
@@ -146,9 +180,9 @@ void MainWindow::on_objectSpecularColorButton_clicked() {
     QColor color = QColorDialog::getColor();
     resetOpenGLContext();
 
-    if (color.isValid()) {
-        MeshObject *object = static_cast<MeshObject *>(ui->widget->selectedObject);
-        object->material.specularColor = {color.redF(), color.greenF(), color.blueF()};
+    Material *material = ui->widget->selectedMaterial();
+    if (color.isValid() && material != nullptr) {
+        material->specularColor = {color.redF(), color.greenF(), color.blueF()};
         ui->widget->update(); // Redraw scene
     }
 }
@@ -159,7 +193,21 @@ void MainWindow::on_objectSpecularPowerSlider_valueChanged(int value) {
         return;
     }
 
-    MeshObject *object = static_cast<MeshObject *>(ui->widget->selectedObject);
-    object->material.specularPower = value;
-    ui->widget->update(); // Redraw scene
+    Material *material = ui->widget->selectedMaterial();
+    if (material != nullptr) {
+        material->specularPower = value;
+        ui->widget->update(); // Redraw scene
+    }
+}
+
+void MainWindow::modelLoadProgress(int finished, int total) {
+    loadProgressBar->setRange(0, total);
+    loadProgressBar->setValue(finished);
+    loadProgressBar->show();
+    loadCancelButton->show();
+}
+
+void MainWindow::modelLoadFinished() {
+    loadProgressBar->hide();
+    loadCancelButton->hide();
 }
@@ -5,6 +5,8 @@
 #include <QFileDialog>
 #include <QInputDialog>
 #include <QColorDialog>
+#include <QProgressBar>
+#include <QPushButton>
 
 namespace Ui {
     class MainWindow;
@@ -24,12 +26,20 @@ private:
     Ui::MainWindow *ui;
     QSet<int> pressedKeys;
 
+    // Model loading status
+    QProgressBar *loadProgressBar;
+    QPushButton *loadCancelButton;
+
     void resetOpenGLContext();
 
 private slots:
+    void modelLoadProgress(int finished, int total);
+    void modelLoadFinished();
     void on_loadObjectButton_clicked();
     void on_applyTextureButton_clicked();
     void on_applyBumpMapButton_clicked();
+    void on_removeObjectButton_clicked();
+    void on_addLightButton_clicked();
     void on_lightColorButton_clicked();
     void on_objectAmbientColorButton_clicked();
     void on_objectDiffuseColorButton_clicked();
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+
+#include <QOpenGLFunctions_3_3_Core>
+
+#include <glm/glm.hpp>
+
+struct Vertex {
+    glm::vec3 position;
+    glm::vec2 uv;
+    glm::vec3 normal;
+    glm::vec4 tangent; // Direction of increasing U, w - bitangent sign (see computeTangents())
+};
+
+// Compact vertex, see packVertices() (a third of the size of Vertex)
+struct PackedVertex {
+    uint16_t position[4]; // Unorm16 in mesh bounding box, last is bitangent sign (0 - negative, 65535 - positive)
+    uint16_t uv[2]; // Unorm16 or half float, depending on vertex format
+    uint8_t normal[4]; // Unorm8 octahedral normal (0-1) and octahedral tangent (2-3)
+};
+
+static_assert(sizeof(Vertex) == 48 && sizeof(PackedVertex) == 16, "Vertex sizes must be multiples of each other (shared mesh buffer)");
+
+// Layout of vertices of a mesh in mesh buffer
+enum VertexFormat : uint32_t {
+    VERTEX_FORMAT_FLOAT = 0, // Vertex
+    VERTEX_FORMAT_PACKED = 1, // PackedVertex, UVs as half floats
+    VERTEX_FORMAT_PACKED_UNORM_UV = 2 // PackedVertex, UVs as unorm16 (all UVs in [0, 1])
+};
+const size_t vertexFormatCount = 3;
+
+// Per-instance vertex attributes of instanced meshes
+struct InstanceData {
+    glm::mat4 M; // Model matrix relative to object
+    GLuint materialIndex; // 0 - object material, 1 and up - material palette
+};
@@ -0,0 +1,323 @@
+#include "meshbuffer.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace {
+
+// Allocation units per vertex or index, also their alignment (offsets must be whole elements)
+size_t vertexUnits(VertexFormat format) {
+    return vertexFormatSize(format) / meshBufferVertexUnit;
+}
+
+size_t indexUnits(GLenum type) {
+    return indexTypeSize(type) / meshBufferIndexUnit;
+}
+
+} // namespace
+
+void FreeListAllocator::reset(size_t capacity) {
+    blocks.clear();
+    if (capacity > 0) {
+        blocks[0] = capacity;
+    }
+    totalCapacity = capacity;
+    usedSize = 0;
+}
+
+bool FreeListAllocator::allocate(size_t size, size_t &offset, size_t alignment) {
+    if (size == 0) {
+        offset = 0;
+        return true;
+    }
+
+    for (auto it = blocks.begin(); it != blocks.end(); ++it) {
+        size_t start = (it->first + alignment - 1) / alignment * alignment;
+        size_t padding = start - it->first;
+        if (it->second < padding + size) {
+            continue;
+        }
+
+        // Take from (aligned) block start, padding and rest stay free
+        size_t blockOffset = it->first;
+        size_t rest = it->second - padding - size;
+        blocks.erase(it);
+        if (padding > 0) {
+            blocks[blockOffset] = padding;
+        }
+        if (rest > 0) {
+            blocks[start + size] = rest;
+        }
+        offset = start;
+        usedSize += size;
+        return true;
+    }
+    return false;
+}
+
+void FreeListAllocator::free(size_t offset, size_t size) {
+    if (size == 0) {
+        return;
+    }
+    usedSize -= size;
+
+    auto it = blocks.emplace(offset, size).first;
+
+    // Merge with following block
+    auto next = std::next(it);
+    if (next != blocks.end() && it->first + it->second == next->first) {
+        it->second += next->second;
+        blocks.erase(next);
+    }
+
+    // Merge with preceding block
+    if (it != blocks.begin()) {
+        auto previous = std::prev(it);
+        if (previous->first + previous->second == it->first) {
+            previous->second += it->second;
+            blocks.erase(it);
+        }
+    }
+}
+
+size_t FreeListAllocator::largestFreeBlock() const {
+    size_t largest = 0;
+    for (const auto &block : blocks) {
+        largest = std::max(largest, block.second);
+    }
+    return largest;
+}
+
+float FreeListAllocator::fragmentation() const {
+    size_t freeSize = totalCapacity - usedSize;
+    if (freeSize == 0) {
+        return 0.0f;
+    }
+    return 1.0f - static_cast<float>(largestFreeBlock()) / static_cast<float>(freeSize);
+}
+
+void MeshBuffer::initialize(QOpenGLFunctions_3_3_Core *gl_, size_t vertexCapacity, size_t indexCapacity) {
+    gl = gl_;
+    gl->glGenVertexArrays(static_cast<GLsizei>(vertexFormatCount), vertexArrays);
+    reallocate(vertexCapacity, indexCapacity);
+}
+
+void MeshBuffer::destroy() {
+    if (gl == nullptr) {
+        return;
+    }
+
+    gl->glDeleteVertexArrays(static_cast<GLsizei>(vertexFormatCount), vertexArrays);
+    gl->glDeleteBuffers(1, &VBO);
+    gl->glDeleteBuffers(1, &IBO);
+    gl = nullptr;
+}
+
+bool MeshBuffer::allocateVertices(MeshRange &range) {
+    size_t units = vertexUnits(range.vertexFormat);
+    size_t offset;
+    if (!vertexAllocator.allocate(static_cast<size_t>(range.vertexCount) * units, offset, units)) {
+        return false;
+    }
+    range.baseVertex = static_cast<GLint>(offset / units);
+    return true;
+}
+
+bool MeshBuffer::allocateIndices(MeshRange &range) {
+    size_t units = indexUnits(range.indexType);
+    size_t offset;
+    if (!indexAllocator.allocate(static_cast<size_t>(range.indexCount) * units, offset, units)) {
+        return false;
+    }
+    range.firstIndex = static_cast<GLuint>(offset / units);
+    return true;
+}
+
+bool MeshBuffer::allocate(MeshRange &range) {
+    if (!allocateVertices(range)) {
+        return false;
+    }
+    if (!allocateIndices(range)) {
+        vertexAllocator.free(static_cast<size_t>(range.baseVertex) * vertexUnits(range.vertexFormat),
+                             static_cast<size_t>(range.vertexCount) * vertexUnits(range.vertexFormat));
+        return false;
+    }
+    return true;
+}
+
+uint32_t MeshBuffer::add(VertexFormat vertexFormat, const void *vertices, size_t vertexCount, GLenum indexType, const void *indices, size_t indexCount) {
+    MeshRange range;
+    range.vertexFormat = vertexFormat;
+    range.indexType = indexType;
+    range.vertexCount = static_cast<GLsizei>(vertexCount);
+    range.indexCount = static_cast<GLsizei>(indexCount);
+
+    // Alignment may need one more unit in front of the free block at the end of compacted buffers
+    size_t vertexSize = vertexCount * vertexUnits(vertexFormat) + vertexUnits(vertexFormat) - 1;
+    size_t indexSize = indexCount * indexUnits(indexType) + indexUnits(indexType) - 1;
+    if (!allocate(range)) {
+        bool fits = vertexAllocator.capacity() - vertexAllocator.used() >= vertexSize && indexAllocator.capacity() - indexAllocator.used() >= indexSize;
+        if (fits) {
+            // Enough free space, but split into blocks that are too small
+            defragment();
+        }
+
+        // Single free block at the end is checked, not assumed, the range is never uploaded with stale offsets
+        while (!allocate(range)) {
+            size_t vertexCapacity = vertexAllocator.capacity();
+            size_t indexCapacity = indexAllocator.capacity();
+            while (vertexCapacity - vertexAllocator.used() < vertexSize) {
+                vertexCapacity *= 2;
+            }
+            while (indexCapacity - indexAllocator.used() < indexSize) {
+                indexCapacity *= 2;
+            }
+            if (vertexCapacity == vertexAllocator.capacity() && indexCapacity == indexAllocator.capacity()) {
+                // Free space suffices, but alignment left the block at the end too short
+                vertexCapacity *= 2;
+                indexCapacity *= 2;
+            }
+            reallocate(vertexCapacity, indexCapacity);
+            ++grows;
+        }
+    }
+
+    // Upload through copy target, element array binding is VAO state
+    size_t vertexBytes = vertexFormatSize(vertexFormat);
+    size_t indexBytes = indexTypeSize(indexType);
+    gl->glBindBuffer(GL_COPY_WRITE_BUFFER, VBO);
+    gl->glBufferSubData(GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(static_cast<size_t>(range.baseVertex) * vertexBytes), static_cast<GLsizeiptr>(vertexCount * vertexBytes), vertices);
+    gl->glBindBuffer(GL_COPY_WRITE_BUFFER, IBO);
+    gl->glBufferSubData(GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(range.firstIndex * indexBytes), static_cast<GLsizeiptr>(indexCount * indexBytes), indices);
+    gl->glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    uint32_t handle;
+    if (!freeHandles.empty()) {
+        handle = freeHandles.back();
+        freeHandles.pop_back();
+    } else {
+        handle = static_cast<uint32_t>(ranges.size());
+        ranges.emplace_back();
+        live.push_back(0);
+    }
+    ranges[handle] = range;
+    live[handle] = 1;
+    return handle;
+}
+
+void MeshBuffer::read(uint32_t handle, std::vector<uint8_t> &vertices, std::vector<GLuint> &indices) {
+    const MeshRange &range = ranges[handle];
+    size_t vertexBytes = vertexFormatSize(range.vertexFormat);
+    size_t indexBytes = indexTypeSize(range.indexType);
+
+    vertices.resize(static_cast<size_t>(range.vertexCount) * vertexBytes);
+    gl->glBindBuffer(GL_COPY_READ_BUFFER, VBO);
+    gl->glGetBufferSubData(GL_COPY_READ_BUFFER, static_cast<GLintptr>(static_cast<size_t>(range.baseVertex) * vertexBytes),
+                           static_cast<GLsizeiptr>(vertices.size()), vertices.data());
+
+    std::vector<uint8_t> indexData(static_cast<size_t>(range.indexCount) * indexBytes);
+    gl->glBindBuffer(GL_COPY_READ_BUFFER, IBO);
+    gl->glGetBufferSubData(GL_COPY_READ_BUFFER, static_cast<GLintptr>(range.firstIndex * indexBytes), static_cast<GLsizeiptr>(indexData.size()), indexData.data());
+    gl->glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+    indices.resize(static_cast<size_t>(range.indexCount));
+    for (size_t i = 0; i < indices.size(); ++i) {
+        if (range.indexType == GL_UNSIGNED_SHORT) {
+            indices[i] = reinterpret_cast<const uint16_t *>(indexData.data())[i];
+        } else {
+            indices[i] = reinterpret_cast<const GLuint *>(indexData.data())[i];
+        }
+    }
+}
+
+void MeshBuffer::remove(uint32_t handle) {
+    const MeshRange &range = ranges[handle];
+    size_t units = vertexUnits(range.vertexFormat);
+    vertexAllocator.free(static_cast<size_t>(range.baseVertex) * units, static_cast<size_t>(range.vertexCount) * units);
+    units = indexUnits(range.indexType);
+    indexAllocator.free(range.firstIndex * units, static_cast<size_t>(range.indexCount) * units);
+
+    ranges[handle] = MeshRange();
+    live[handle] = 0;
+    freeHandles.push_back(handle);
+}
+
+void MeshBuffer::defragment() {
+    reallocate(vertexAllocator.capacity(), indexAllocator.capacity());
+    ++defragmentations;
+}
+
+void MeshBuffer::reallocate(size_t vertexCapacity, size_t indexCapacity) {
+    GLuint newVBO, newIBO;
+    gl->glGenBuffers(1, &newVBO);
+    gl->glBindBuffer(GL_COPY_WRITE_BUFFER, newVBO);
+    gl->glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(vertexCapacity * meshBufferVertexUnit), nullptr, GL_STATIC_DRAW);
+    gl->glGenBuffers(1, &newIBO);
+    gl->glBindBuffer(GL_COPY_WRITE_BUFFER, newIBO);
+    gl->glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(indexCapacity * meshBufferIndexUnit), nullptr, GL_STATIC_DRAW);
+
+    // Copy meshes one after another on GPU, indices are relative to base vertex and stay valid
+    // Larger elements come first, so alignment leaves no gaps between compacted meshes
+    vertexAllocator.reset(vertexCapacity);
+    indexAllocator.reset(indexCapacity);
+    std::vector<MeshRange> moved(ranges);
+    for (size_t pass = std::max(vertexUnits(VERTEX_FORMAT_FLOAT), indexUnits(GL_UNSIGNED_INT)); pass > 0; --pass) {
+        for (size_t handle = 0; handle < ranges.size(); ++handle) {
+            if (!live[handle]) {
+                continue;
+            }
+            const MeshRange &range = ranges[handle];
+
+            if (vertexUnits(range.vertexFormat) == pass) {
+                size_t bytes = vertexFormatSize(range.vertexFormat);
+                allocateVertices(moved[handle]);
+                gl->glBindBuffer(GL_COPY_READ_BUFFER, VBO);
+                gl->glBindBuffer(GL_COPY_WRITE_BUFFER, newVBO);
+                gl->glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(static_cast<size_t>(range.baseVertex) * bytes),
+                                        static_cast<GLintptr>(static_cast<size_t>(moved[handle].baseVertex) * bytes), static_cast<GLsizeiptr>(static_cast<size_t>(range.vertexCount) * bytes));
+            }
+            if (indexUnits(range.indexType) == pass) {
+                size_t bytes = indexTypeSize(range.indexType);
+                allocateIndices(moved[handle]);
+                gl->glBindBuffer(GL_COPY_READ_BUFFER, IBO);
+                gl->glBindBuffer(GL_COPY_WRITE_BUFFER, newIBO);
+                gl->glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(range.firstIndex * bytes),
+                                        static_cast<GLintptr>(moved[handle].firstIndex * bytes), static_cast<GLsizeiptr>(static_cast<size_t>(range.indexCount) * bytes));
+            }
+        }
+    }
+    ranges.swap(moved);
+    gl->glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    gl->glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    gl->glDeleteBuffers(1, &VBO);
+    gl->glDeleteBuffers(1, &IBO);
+    VBO = newVBO;
+    IBO = newIBO;
+
+    // Point shared VAOs to new buffers
+    gl->glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    for (size_t format = 0; format < vertexFormatCount; ++format) {
+        gl->glBindVertexArray(vertexArrays[format]);
+        setupVertexAttributes(gl, static_cast<VertexFormat>(format));
+        gl->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IBO);
+    }
+    gl->glBindVertexArray(0);
+    gl->glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    ++bufferGeneration;
+}
+
+MeshBufferStats MeshBuffer::stats() const {
+    MeshBufferStats stats;
+    stats.vertexCapacity = vertexAllocator.capacity() * meshBufferVertexUnit;
+    stats.vertexUsed = vertexAllocator.used() * meshBufferVertexUnit;
+    stats.indexCapacity = indexAllocator.capacity() * meshBufferIndexUnit;
+    stats.indexUsed = indexAllocator.used() * meshBufferIndexUnit;
+    stats.freeBlocks = vertexAllocator.freeBlocks() + indexAllocator.freeBlocks();
+    stats.fragmentation = std::max(vertexAllocator.fragmentation(), indexAllocator.fragmentation());
+    stats.meshes = static_cast<uint32_t>(ranges.size() - freeHandles.size());
+    stats.grows = grows;
+    stats.defragmentations = defragmentations;
+    return stats;
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include <QOpenGLFunctions_3_3_Core>
+
+#include "mesh.h"
+#include "vertexformat.h"
+
+// First-fit allocator of element ranges in [0, capacity), free neighbours are merged
+class FreeListAllocator {
+public:
+    void reset(size_t capacity); // Everything free
+
+    // Offset is a multiple of alignment, skipped elements stay free
+    bool allocate(size_t size, size_t &offset /* out */, size_t alignment = 1);
+    void free(size_t offset, size_t size);
+
+    size_t capacity() const { return totalCapacity; }
+    size_t used() const { return usedSize; }
+    size_t freeBlocks() const { return blocks.size(); }
+    size_t largestFreeBlock() const;
+
+    // 0 - all free space is one block, close to 1 - free space is split into many small blocks
+    float fragmentation() const;
+
+private:
+    std::map<size_t, size_t> blocks; // Free blocks, offset -> size
+    size_t totalCapacity = 0;
+    size_t usedSize = 0;
+};
+
+// Allocation units of mesh buffer, vertices of every format and indices of every type are whole multiples
+const size_t meshBufferVertexUnit = sizeof(PackedVertex);
+const size_t meshBufferIndexUnit = sizeof(uint16_t);
+
+// Place of a mesh in mesh buffer, indices are relative to base vertex
+struct MeshRange {
+    VertexFormat vertexFormat = VERTEX_FORMAT_FLOAT;
+    GLenum indexType = GL_UNSIGNED_INT; // Or GL_UNSIGNED_SHORT
+    GLint baseVertex = 0; // Vertices of mesh's format
+    GLsizei vertexCount = 0;
+    GLuint firstIndex = 0; // Indices of mesh's type
+    GLsizei indexCount = 0;
+};
+
+struct MeshBufferStats {
+    size_t vertexCapacity = 0; // Bytes
+    size_t vertexUsed = 0;
+    size_t indexCapacity = 0;
+    size_t indexUsed = 0;
+    size_t freeBlocks = 0; // Vertex and index
+    float fragmentation = 0.0f; // Worse of vertex and index, see FreeListAllocator::fragmentation()
+    uint32_t meshes = 0;
+    uint32_t grows = 0; // Buffers reallocated bigger
+    uint32_t defragmentations = 0; // Meshes compacted to buffer start
+};
+
+// Vertices and indices of all meshes in a single vertex and index buffer, drawn from one VAO per vertex format with base vertex
+// Meshes are referred to by stable handles, their ranges move when buffers grow or are defragmented (OpenGL thread only)
+// Capacities are in allocation units (see above)
+class MeshBuffer {
+public:
+    void initialize(QOpenGLFunctions_3_3_Core *gl_, size_t vertexCapacity = 2 << 16, size_t indexCapacity = 6 << 16);
+    void destroy();
+
+    // Upload a mesh (vertices of given format, indices of given type), buffers grow (or are defragmented first) if it doesn't fit
+    uint32_t add(VertexFormat vertexFormat, const void *vertices, size_t vertexCount, GLenum indexType, const void *indices, size_t indexCount);
+    void remove(uint32_t handle);
+    const MeshRange &range(uint32_t handle) const { return ranges[handle]; }
+
+    // Read mesh back from GPU (waits for pending uploads), vertices in mesh's format, indices widened to GLuint
+    void read(uint32_t handle, std::vector<uint8_t> &vertices /* out */, std::vector<GLuint> &indices /* out */);
+
+    // Compact all meshes to buffer start, leaving a single free block at the end
+    void defragment();
+
+    GLuint VAO(VertexFormat format) const { return vertexArrays[format]; }
+    GLuint vertexBuffer() const { return VBO; }
+    GLuint indexBuffer() const { return IBO; }
+    // Increased whenever buffers are replaced, other VAOs referencing them must be set up again
+    uint32_t generation() const { return bufferGeneration; }
+
+    MeshBufferStats stats() const;
+
+private:
+    QOpenGLFunctions_3_3_Core *gl = nullptr;
+    GLuint vertexArrays[vertexFormatCount] = {};
+    GLuint VBO = 0;
+    GLuint IBO = 0;
+    uint32_t bufferGeneration = 0;
+
+    FreeListAllocator vertexAllocator;
+    FreeListAllocator indexAllocator;
+    std::vector<MeshRange> ranges; // By handle
+    std::vector<uint8_t> live;
+    std::vector<uint32_t> freeHandles;
+    uint32_t grows = 0;
+    uint32_t defragmentations = 0;
+
+    bool allocate(MeshRange &range); // Vertices and indices of range's counts, formats and types
+    bool allocateVertices(MeshRange &range);
+    bool allocateIndices(MeshRange &range);
+    void reallocate(size_t vertexCapacity, size_t indexCapacity); // Copies meshes compacted into new buffers
+};
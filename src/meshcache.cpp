@@ -0,0 +1,212 @@
+#include "meshcache.h"
+
+#include <algorithm>
+#include <iostream>
+#include <cstring>
+
+#include <QFileInfo>
+#include <QDir>
+#include <QDateTime>
+#include <QSaveFile>
+
+namespace {
+
+const uint64_t alignment = 16;
+
+static_assert(sizeof(MeshLevel) == 12, "Levels are stored as is, layout changes need a cache version bump");
+
+uint64_t alignUp(uint64_t offset) {
+    return (offset + alignment - 1) & ~(alignment - 1);
+}
+
+inline uint64_t mix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    return h ^ (h >> 33);
+}
+
+// Hash 8 bytes at a time, fast enough to be dwarfed by reading the file
+uint64_t hashBytes(const uchar *data, uint64_t size) {
+    uint64_t h = 0x9E3779B97F4A7C15ULL ^ size;
+    uint64_t words = size / 8;
+    for (uint64_t i = 0; i < words; ++i) {
+        uint64_t word;
+        memcpy(&word, data + i * 8, 8);
+        h = (h ^ mix(word)) * 0x100000001B3ULL;
+        h = (h << 29) | (h >> 35);
+    }
+
+    uint64_t tail = 0;
+    memcpy(&tail, data + words * 8, static_cast<size_t>(size - words * 8));
+    return mix(h ^ mix(tail));
+}
+
+} // namespace
+
+MappedMesh::MappedMesh(std::unique_ptr<QFile> file_, uchar *data_)
+    : file(std::move(file_)), data(data_) {}
+
+MappedMesh::~MappedMesh() {
+    file->unmap(data);
+    file->close();
+}
+
+glm::vec3 MappedMesh::boundingBoxMin() const {
+    const float *v = header().boundingBoxMin;
+    return {v[0], v[1], v[2]};
+}
+
+glm::vec3 MappedMesh::boundingBoxMax() const {
+    const float *v = header().boundingBoxMax;
+    return {v[0], v[1], v[2]};
+}
+
+QString meshCachePath(const QString &sourcePath) {
+    QFileInfo fileInfo(sourcePath);
+    return fileInfo.absolutePath() + "/.meshcache/" + fileInfo.fileName() + ".mesh";
+}
+
+uint64_t hashFileContents(const QString &path) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return 0;
+    }
+
+    qint64 size = file.size();
+    uchar *data = (size > 0) ? file.map(0, size) : nullptr;
+    if (data == nullptr) {
+        QByteArray contents = file.readAll();
+        return hashBytes(reinterpret_cast<const uchar *>(contents.constData()), static_cast<uint64_t>(contents.size()));
+    }
+
+    uint64_t hash = hashBytes(data, static_cast<uint64_t>(size));
+    file.unmap(data);
+    return hash;
+}
+
+uint64_t hashData(const void *data, size_t size) {
+    return hashBytes(static_cast<const uchar *>(data), static_cast<uint64_t>(size));
+}
+
+std::shared_ptr<MappedMesh> openMeshCache(const QString &sourcePath) {
+    QFileInfo sourceInfo(sourcePath);
+    std::unique_ptr<QFile> file(new QFile(meshCachePath(sourcePath)));
+    if (!sourceInfo.exists() || !file->open(QIODevice::ReadOnly)) {
+        return nullptr;
+    }
+
+    qint64 size = file->size();
+    if (size < static_cast<qint64>(sizeof(MeshCacheHeader))) {
+        return nullptr;
+    }
+
+    uchar *data = file->map(0, size);
+    if (data == nullptr) {
+        return nullptr;
+    }
+
+    // Validate format and bounds before handing out any pointers
+    MeshCacheHeader header;
+    memcpy(&header, data, sizeof(header));
+    uint64_t fileSize = static_cast<uint64_t>(size);
+    bool valid = memcmp(header.magic, meshCacheMagic, sizeof(meshCacheMagic)) == 0 &&
+                 header.version == meshCacheVersion &&
+                 header.vertexSize == sizeof(Vertex) && header.indexSize == sizeof(GLuint) &&
+                 header.vertexOffset % alignment == 0 && header.indexOffset % alignment == 0 &&
+                 header.vertexOffset >= sizeof(MeshCacheHeader) && header.vertexOffset <= fileSize && header.indexOffset <= fileSize &&
+                 header.vertexCount <= fileSize / sizeof(Vertex) && header.indexCount <= fileSize / sizeof(GLuint) &&
+                 header.vertexOffset + header.vertexCount * sizeof(Vertex) <= fileSize &&
+                 header.levelIndexCount <= fileSize / sizeof(GLuint) &&
+                 header.indexOffset + (header.indexCount + header.levelIndexCount) * sizeof(GLuint) <= fileSize &&
+                 header.levelOffset % alignment == 0 && header.levelOffset <= fileSize && header.levelCount <= lodMaxLevels &&
+                 header.levelOffset + header.levelCount * sizeof(MeshLevel) <= fileSize &&
+                 header.sourceSize == static_cast<uint64_t>(sourceInfo.size());
+
+    // Source touched, but possibly not changed
+    if (valid && header.sourceModified != sourceInfo.lastModified().toMSecsSinceEpoch()) {
+        valid = header.sourceHash == hashFileContents(sourcePath);
+    }
+
+    // Header may match a truncated or corrupted payload, indices out of range would be read past vertices by every later pass
+    if (valid) {
+        const GLuint *indices = reinterpret_cast<const GLuint *>(data + header.indexOffset);
+        uint64_t totalIndexCount = header.indexCount + header.levelIndexCount;
+        GLuint maxIndex = 0;
+        for (uint64_t i = 0; i < totalIndexCount; ++i) {
+            maxIndex = std::max(maxIndex, indices[i]);
+        }
+        valid = header.indexCount % 3 == 0 && (totalIndexCount == 0 || maxIndex < header.vertexCount);
+
+        const MeshLevel *levels = reinterpret_cast<const MeshLevel *>(data + header.levelOffset);
+        for (uint32_t level = 0; level < header.levelCount && valid; ++level) {
+            valid = static_cast<uint64_t>(levels[level].firstIndex) + levels[level].indexCount <= totalIndexCount && levels[level].indexCount % 3 == 0;
+        }
+    }
+
+    if (!valid) {
+        file->unmap(data);
+        return nullptr;
+    }
+
+    return std::make_shared<MappedMesh>(std::move(file), data);
+}
+
+bool writeMeshCache(const QString &sourcePath, uint64_t sourceHash, const std::vector<Vertex> &vertices, const std::vector<GLuint> &indices,
+                    const std::vector<GLuint> &levelIndices, const std::vector<MeshLevel> &levels) {
+    QFileInfo sourceInfo(sourcePath);
+    QString path = meshCachePath(sourcePath);
+    if (!QDir().mkpath(QFileInfo(path).absolutePath())) {
+        std::cerr << "Mesh cache directory creation failed! [" << path.toStdString() << "]" << std::endl;
+        return false;
+    }
+
+    MeshCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, meshCacheMagic, sizeof(meshCacheMagic));
+    header.version = meshCacheVersion;
+    header.vertexSize = sizeof(Vertex);
+    header.indexSize = sizeof(GLuint);
+    header.sourceSize = static_cast<uint64_t>(sourceInfo.size());
+    header.sourceModified = sourceInfo.lastModified().toMSecsSinceEpoch();
+    header.sourceHash = sourceHash;
+    header.vertexOffset = alignUp(sizeof(MeshCacheHeader));
+    header.vertexCount = vertices.size();
+    header.indexOffset = alignUp(header.vertexOffset + vertices.size() * sizeof(Vertex));
+    header.indexCount = indices.size();
+    header.levelIndexCount = levelIndices.size();
+    header.levelOffset = alignUp(header.indexOffset + (indices.size() + levelIndices.size()) * sizeof(GLuint));
+    header.levelCount = static_cast<uint32_t>(levels.size());
+
+    glm::vec3 boundingBoxMin(INFINITY), boundingBoxMax(-INFINITY);
+    for (const auto &vertex : vertices) {
+        boundingBoxMin = glm::min(boundingBoxMin, vertex.position);
+        boundingBoxMax = glm::max(boundingBoxMax, vertex.position);
+    }
+    memcpy(header.boundingBoxMin, &boundingBoxMin[0], sizeof(header.boundingBoxMin));
+    memcpy(header.boundingBoxMax, &boundingBoxMax[0], sizeof(header.boundingBoxMax));
+
+    const char padding[alignment] = {};
+    uint64_t vertexBytes = vertices.size() * sizeof(Vertex);
+    uint64_t indexBytes = indices.size() * sizeof(GLuint);
+    uint64_t levelIndexBytes = levelIndices.size() * sizeof(GLuint);
+    uint64_t levelBytes = levels.size() * sizeof(MeshLevel);
+
+    QSaveFile file(path);
+    bool ok = file.open(QIODevice::WriteOnly) &&
+              file.write(reinterpret_cast<const char *>(&header), sizeof(header)) == sizeof(header) &&
+              file.write(padding, static_cast<qint64>(header.vertexOffset - sizeof(header))) >= 0 &&
+              file.write(reinterpret_cast<const char *>(vertices.data()), static_cast<qint64>(vertexBytes)) == static_cast<qint64>(vertexBytes) &&
+              file.write(padding, static_cast<qint64>(header.indexOffset - header.vertexOffset - vertexBytes)) >= 0 &&
+              file.write(reinterpret_cast<const char *>(indices.data()), static_cast<qint64>(indexBytes)) == static_cast<qint64>(indexBytes) &&
+              file.write(reinterpret_cast<const char *>(levelIndices.data()), static_cast<qint64>(levelIndexBytes)) == static_cast<qint64>(levelIndexBytes) &&
+              file.write(padding, static_cast<qint64>(header.levelOffset - header.indexOffset - indexBytes - levelIndexBytes)) >= 0 &&
+              file.write(reinterpret_cast<const char *>(levels.data()), static_cast<qint64>(levelBytes)) == static_cast<qint64>(levelBytes) &&
+              file.commit();
+
+    if (!ok) {
+        std::cerr << "Mesh cache writing failed! [" << path.toStdString() << "]" << std::endl;
+    }
+    return ok;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <QString>
+#include <QFile>
+#include <QOpenGLFunctions_3_3_Core>
+
+#include "mesh.h"
+#include "lod.h"
+
+// Binary mesh cache file (.mesh), written beside source model in ".meshcache" directory
+// Layout: MeshCacheHeader, interleaved Vertex array, GLuint index array followed by level of detail indices, MeshLevel array (arrays 16-byte aligned)
+const char meshCacheMagic[4] = {'F', 'M', 'S', 'H'};
+const uint32_t meshCacheVersion = 5; // 2 - meshes are stored optimized (see optimizeMesh()), 3 - vertices have tangents, 4 - corners without normals are welded, 5 - levels of detail are stored
+
+struct MeshCacheHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t vertexSize; // sizeof(Vertex), guards against layout changes
+    uint32_t indexSize; // sizeof(GLuint)
+    uint64_t sourceSize;
+    int64_t sourceModified; // Milliseconds since epoch
+    uint64_t sourceHash; // Content hash of source file
+    uint64_t vertexOffset;
+    uint64_t vertexCount;
+    uint64_t indexOffset;
+    uint64_t indexCount;
+    uint64_t levelIndexCount; // Indices of levels of detail beyond original, right after mesh indices
+    uint64_t levelOffset;
+    uint32_t levelCount; // Including original (level 0)
+    uint32_t padding;
+    float boundingBoxMin[3];
+    float boundingBoxMax[3];
+};
+
+// Read-only memory mapping of a valid cache file, data is used in place (eg. straight for glBufferData)
+class MappedMesh {
+public:
+    MappedMesh(std::unique_ptr<QFile> file_, uchar *data_);
+    ~MappedMesh();
+
+    const MeshCacheHeader &header() const { return *reinterpret_cast<const MeshCacheHeader *>(data); }
+    const Vertex *vertices() const { return reinterpret_cast<const Vertex *>(data + header().vertexOffset); }
+    const GLuint *indices() const { return reinterpret_cast<const GLuint *>(data + header().indexOffset); }
+    size_t vertexCount() const { return static_cast<size_t>(header().vertexCount); }
+    size_t indexCount() const { return static_cast<size_t>(header().indexCount); }
+    const GLuint *levelIndices() const { return indices() + indexCount(); }
+    size_t levelIndexCount() const { return static_cast<size_t>(header().levelIndexCount); }
+    const MeshLevel *levels() const { return reinterpret_cast<const MeshLevel *>(data + header().levelOffset); }
+    size_t levelCount() const { return header().levelCount; }
+    glm::vec3 boundingBoxMin() const;
+    glm::vec3 boundingBoxMax() const;
+
+private:
+    std::unique_ptr<QFile> file; // Mapping is valid only while the file is open
+    uchar *data;
+};
+
+QString meshCachePath(const QString &sourcePath);
+
+// Content hash (64-bit, non-cryptographic) of the whole file, 0 if it can't be read
+uint64_t hashFileContents(const QString &path);
+
+// Content hash of memory, same as hashFileContents() of a file with these contents
+uint64_t hashData(const void *data, size_t size);
+
+// Map cache of given source model, nullptr if there is none or it is out of date
+// Cache is valid if source size and modification time match, or if size matches and content hash is unchanged
+// Indices and level ranges are checked against vertex and index counts, so a corrupted payload falls back to parsing the source
+std::shared_ptr<MappedMesh> openMeshCache(const QString &sourcePath);
+
+// Write cache of given source model (atomically, other readers never see a partial file), levels as from generateLevels()
+bool writeMeshCache(const QString &sourcePath, uint64_t sourceHash /* hashFileContents() */, const std::vector<Vertex> &vertices, const std::vector<GLuint> &indices,
+                    const std::vector<GLuint> &levelIndices, const std::vector<MeshLevel> &levels);
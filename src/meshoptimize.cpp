@@ -0,0 +1,221 @@
+#include "meshoptimize.h"
+
+#include <algorithm>
+#include <numeric>
+
+VertexCacheStats analyzeVertexCache(const GLuint *indices, size_t indexCount, size_t vertexCount, size_t cacheSize) {
+    VertexCacheStats stats;
+    if (indexCount == 0) {
+        return stats;
+    }
+
+    // FIFO, vertex is in cache if it was inserted less than cache size misses ago
+    std::vector<size_t> insertedAt(vertexCount, 0);
+    std::vector<uint8_t> used(vertexCount, 0);
+    size_t misses = 0;
+    size_t usedCount = 0;
+    for (size_t i = 0; i < indexCount; ++i) {
+        GLuint vertex = indices[i];
+        if (insertedAt[vertex] == 0 || misses - insertedAt[vertex] + 1 > cacheSize) {
+            ++misses;
+            insertedAt[vertex] = misses;
+        }
+        if (!used[vertex]) {
+            used[vertex] = 1;
+            ++usedCount;
+        }
+    }
+
+    stats.acmr = static_cast<float>(misses) / static_cast<float>(indexCount / 3);
+    stats.atvr = static_cast<float>(misses) / static_cast<float>(usedCount);
+    return stats;
+}
+
+std::vector<uint32_t> optimizeVertexCache(GLuint *indices, size_t indexCount, size_t vertexCount, size_t cacheSize) {
+    std::vector<uint32_t> clusters;
+    size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0) {
+        return clusters;
+    }
+
+    // Triangles around each vertex, live count is decreased as they are emitted
+    std::vector<uint32_t> offsets(vertexCount + 1, 0);
+    for (size_t i = 0; i < triangleCount * 3; ++i) {
+        ++offsets[indices[i] + 1];
+    }
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    std::vector<uint32_t> adjacency(triangleCount * 3);
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < triangleCount * 3; ++i) {
+        adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+    std::vector<uint32_t> live(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        live[v] = offsets[v + 1] - offsets[v];
+    }
+
+    std::vector<GLuint> output;
+    output.reserve(triangleCount * 3);
+    std::vector<uint8_t> emitted(triangleCount, 0);
+    std::vector<size_t> cacheTime(vertexCount, 0);
+    size_t time = cacheSize + 1;
+    std::vector<GLuint> deadEnd; // Recently used vertices, fallback when no candidate is in cache
+    std::vector<GLuint> candidates;
+    size_t cursor = 0; // Fallback when dead-end stack is empty, in input order
+
+    // Next vertex with live triangles, from dead-end stack or input order (cache locality is lost, new cluster)
+    auto skipDeadEnd = [&]() -> int64_t {
+        while (!deadEnd.empty()) {
+            GLuint vertex = deadEnd.back();
+            deadEnd.pop_back();
+            if (live[vertex] > 0) {
+                return vertex;
+            }
+        }
+        for (; cursor < vertexCount; ++cursor) {
+            if (live[cursor] > 0) {
+                return static_cast<int64_t>(cursor);
+            }
+        }
+        return -1;
+    };
+
+    int64_t fanning = skipDeadEnd();
+    clusters.push_back(0);
+    while (fanning >= 0) {
+        // Emit all remaining triangles around fanning vertex
+        candidates.clear();
+        for (uint32_t a = offsets[fanning]; a < offsets[fanning + 1]; ++a) {
+            uint32_t triangle = adjacency[a];
+            if (emitted[triangle]) {
+                continue;
+            }
+            emitted[triangle] = 1;
+
+            for (int k = 0; k < 3; ++k) {
+                GLuint vertex = indices[triangle * 3 + k];
+                output.push_back(vertex);
+                deadEnd.push_back(vertex);
+                candidates.push_back(vertex);
+                --live[vertex];
+                if (time - cacheTime[vertex] > cacheSize) {
+                    cacheTime[vertex] = time++;
+                }
+            }
+        }
+
+        // Candidate that will still be in cache after its remaining triangles are emitted, oldest in cache first
+        int64_t next = -1;
+        int64_t bestPriority = -1;
+        for (GLuint vertex : candidates) {
+            if (live[vertex] == 0) {
+                continue;
+            }
+            int64_t priority = 0;
+            if (time - cacheTime[vertex] + 2 * live[vertex] <= cacheSize) {
+                priority = static_cast<int64_t>(time - cacheTime[vertex]);
+            }
+            if (priority > bestPriority) {
+                bestPriority = priority;
+                next = vertex;
+            }
+        }
+
+        if (next < 0) {
+            next = skipDeadEnd();
+            if (next >= 0) {
+                clusters.push_back(static_cast<uint32_t>(output.size() / 3));
+            }
+        }
+        fanning = next;
+    }
+
+    std::copy(output.begin(), output.end(), indices);
+    return clusters;
+}
+
+void optimizeOverdraw(GLuint *indices, size_t indexCount, const Vertex *vertices, const std::vector<uint32_t> &clusters) {
+    size_t triangleCount = indexCount / 3;
+    if (clusters.size() < 2) {
+        return;
+    }
+
+    // Area weighted centroid and normal of each cluster and of whole mesh
+    struct Cluster {
+        uint32_t first;
+        uint32_t count;
+        glm::vec3 centroid;
+        glm::vec3 normal;
+        float area;
+        float key;
+    };
+    std::vector<Cluster> sorted(clusters.size());
+    glm::vec3 meshCentroid(0.0f);
+    float meshArea = 0.0f;
+    for (size_t c = 0; c < clusters.size(); ++c) {
+        Cluster &cluster = sorted[c];
+        cluster.first = clusters[c];
+        cluster.count = static_cast<uint32_t>((c + 1 < clusters.size() ? clusters[c + 1] : triangleCount) - clusters[c]);
+        cluster.centroid = glm::vec3(0.0f);
+        cluster.normal = glm::vec3(0.0f);
+        cluster.area = 0.0f;
+
+        for (uint32_t t = cluster.first; t < cluster.first + cluster.count; ++t) {
+            const glm::vec3 &p0 = vertices[indices[t * 3]].position;
+            const glm::vec3 &p1 = vertices[indices[t * 3 + 1]].position;
+            const glm::vec3 &p2 = vertices[indices[t * 3 + 2]].position;
+            glm::vec3 normal = glm::cross(p1 - p0, p2 - p0); // Length is twice the area
+            float area = glm::length(normal) * 0.5f;
+            cluster.centroid += (p0 + p1 + p2) / 3.0f * area;
+            cluster.normal += normal;
+            cluster.area += area;
+        }
+
+        meshCentroid += cluster.centroid;
+        meshArea += cluster.area;
+        if (cluster.area > 0.0f) {
+            cluster.centroid /= cluster.area;
+        }
+        float length = glm::length(cluster.normal);
+        if (length > 0.0f) {
+            cluster.normal /= length;
+        }
+    }
+    if (meshArea > 0.0f) {
+        meshCentroid /= meshArea;
+    }
+
+    // Clusters further out along their normal are likely in front of others from any view
+    for (auto &cluster : sorted) {
+        cluster.key = glm::dot(cluster.centroid - meshCentroid, cluster.normal);
+    }
+    std::stable_sort(sorted.begin(), sorted.end(), [](const Cluster &a, const Cluster &b) { return a.key > b.key; });
+
+    std::vector<GLuint> output;
+    output.reserve(triangleCount * 3);
+    for (const auto &cluster : sorted) {
+        output.insert(output.end(), indices + cluster.first * 3, indices + (cluster.first + cluster.count) * 3);
+    }
+    std::copy(output.begin(), output.end(), indices);
+}
+
+void optimizeVertexFetch(std::vector<Vertex> &vertices, std::vector<GLuint> &indices) {
+    const GLuint unused = ~0u;
+    std::vector<GLuint> remap(vertices.size(), unused);
+    std::vector<Vertex> output;
+    output.reserve(vertices.size());
+    for (auto &index : indices) {
+        if (remap[index] == unused) {
+            remap[index] = static_cast<GLuint>(output.size());
+            output.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+    vertices.swap(output);
+}
+
+void optimizeMesh(std::vector<Vertex> &vertices, std::vector<GLuint> &indices) {
+    std::vector<uint32_t> clusters = optimizeVertexCache(indices.data(), indices.size(), vertices.size());
+    optimizeOverdraw(indices.data(), indices.size(), vertices.data(), clusters);
+    optimizeVertexFetch(vertices, indices);
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "mesh.h"
+
+// Simulated post-transform vertex cache (FIFO, typical size of desktop GPUs)
+const size_t vertexCacheSize = 16;
+
+struct VertexCacheStats {
+    float acmr = 0.0f; // Average cache miss ratio, transformed vertices per triangle (0.5 - 3)
+    float atvr = 0.0f; // Average transform to vertex ratio, transformed vertices per used vertex (1 - best)
+};
+
+VertexCacheStats analyzeVertexCache(const GLuint *indices, size_t indexCount, size_t vertexCount, size_t cacheSize = vertexCacheSize);
+
+// Reorder triangles for vertex cache locality (Tipsify), fanning around vertices still in cache
+// Returns first triangle of each cluster, clusters start where cache locality is lost anyway (free to reorder)
+std::vector<uint32_t> optimizeVertexCache(GLuint *indices, size_t indexCount, size_t vertexCount, size_t cacheSize = vertexCacheSize);
+
+// Reorder clusters of triangles so those facing outwards come first, occluding inner ones for early depth test (view independent)
+void optimizeOverdraw(GLuint *indices, size_t indexCount, const Vertex *vertices, const std::vector<uint32_t> &clusters);
+
+// Reorder vertices in order of first use by indices (fetch locality), unused vertices are dropped
+void optimizeVertexFetch(std::vector<Vertex> &vertices, std::vector<GLuint> &indices);
+
+// All of the above, in order (after loading or generating a mesh, before levels of detail are generated)
+void optimizeMesh(std::vector<Vertex> &vertices, std::vector<GLuint> &indices);
@@ -0,0 +1,106 @@
+#include "mipmap.h"
+
+#include <algorithm>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "parallel.h"
+
+namespace {
+
+// Bands with fewer output pixels are not worth a pool task
+const int bandPixels = 256 * 256;
+
+// Average 2x2 blocks of source rows (2 * y) and (2 * y + 1) into destination row y, for rows [rowBegin, rowEnd)
+// Odd source sizes: last destination row and column also take the edge texel that halving drops (2x3, 3x2 or 3x3 blocks)
+// Destination is written through raw pointer, non-const QImage access may detach and is not safe between threads
+void downsampleRows(const QImage &source, uchar *destination, int destinationStride, int width, int rowBegin, int rowEnd) {
+    int sourceWidth = source.width();
+    int sourceHeight = source.height();
+    int height = std::max(sourceHeight / 2, 1);
+    bool extraColumn = 2 * width < sourceWidth;
+    int blockWidth = extraColumn ? width - 1 : width; // Destination columns of 2 source columns
+
+    for (int y = rowBegin; y < rowEnd; ++y) {
+        const uchar *rows[3] = {source.constScanLine(std::min(2 * y, sourceHeight - 1)), source.constScanLine(std::min(2 * y + 1, sourceHeight - 1)),
+                                source.constScanLine(std::min(2 * y + 2, sourceHeight - 1))};
+        int rowCount = y == height - 1 && 2 * height < sourceHeight ? 3 : 2;
+        const uchar *row0 = rows[0];
+        const uchar *row1 = rows[1];
+        uchar *out = destination + static_cast<size_t>(y) * destinationStride;
+
+        int x = 0;
+#ifdef __SSE2__
+        // 4 output pixels (8 source pixels from each row) per iteration
+        if (sourceWidth >= 2 && rowCount == 2) {
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i rounding = _mm_set1_epi16(2);
+            for (; x + 4 <= blockWidth; x += 4) {
+                __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row0 + x * 8));
+                __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row0 + x * 8 + 16));
+                __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row1 + x * 8));
+                __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row1 + x * 8 + 16));
+
+                // Vertical sums widened to 16 bits, 2 pixels per register
+                __m128i s01 = _mm_add_epi16(_mm_unpacklo_epi8(a0, zero), _mm_unpacklo_epi8(b0, zero));
+                __m128i s23 = _mm_add_epi16(_mm_unpackhi_epi8(a0, zero), _mm_unpackhi_epi8(b0, zero));
+                __m128i s45 = _mm_add_epi16(_mm_unpacklo_epi8(a1, zero), _mm_unpacklo_epi8(b1, zero));
+                __m128i s67 = _mm_add_epi16(_mm_unpackhi_epi8(a1, zero), _mm_unpackhi_epi8(b1, zero));
+
+                // Horizontal pair sums end up in the low 64 bits
+                __m128i h0 = _mm_add_epi16(s01, _mm_srli_si128(s01, 8));
+                __m128i h1 = _mm_add_epi16(s23, _mm_srli_si128(s23, 8));
+                __m128i h2 = _mm_add_epi16(s45, _mm_srli_si128(s45, 8));
+                __m128i h3 = _mm_add_epi16(s67, _mm_srli_si128(s67, 8));
+
+                __m128i lo = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(h0, h1), rounding), 2);
+                __m128i hi = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(h2, h3), rounding), 2);
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(out + x * 4), _mm_packus_epi16(lo, hi));
+            }
+        }
+#endif
+
+        // Remaining pixels (and 1 pixel wide sources, odd edges)
+        for (; x < width; ++x) {
+            int columns[3] = {std::min(2 * x, sourceWidth - 1) * 4, std::min(2 * x + 1, sourceWidth - 1) * 4, std::min(2 * x + 2, sourceWidth - 1) * 4};
+            int columnCount = x == width - 1 && extraColumn ? 3 : 2;
+            int count = rowCount * columnCount;
+            for (int c = 0; c < 4; ++c) {
+                int sum = count / 2;
+                for (int r = 0; r < rowCount; ++r) {
+                    for (int k = 0; k < columnCount; ++k) {
+                        sum += rows[r][columns[k] + c];
+                    }
+                }
+                out[x * 4 + c] = static_cast<uchar>(sum / count);
+            }
+        }
+    }
+}
+
+QImage downsample(const QImage &source) {
+    QImage destination(std::max(source.width() / 2, 1), std::max(source.height() / 2, 1), QImage::Format_ARGB32);
+    int width = destination.width();
+    int height = destination.height();
+    uchar *bits = destination.bits();
+    int stride = destination.bytesPerLine();
+
+    parallelFor(static_cast<size_t>(height), static_cast<size_t>(std::max(bandPixels / width, 1)), [&](size_t begin, size_t end) {
+        downsampleRows(source, bits, stride, width, static_cast<int>(begin), static_cast<int>(end));
+    });
+    return destination;
+}
+
+} // namespace
+
+std::vector<QImage> generateMipmaps(const QImage &image) {
+    std::vector<QImage> levels;
+    const QImage *previous = &image;
+    while (previous->width() > 1 || previous->height() > 1) {
+        levels.push_back(downsample(*previous));
+        previous = &levels.back();
+    }
+    return levels;
+}
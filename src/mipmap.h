@@ -0,0 +1,10 @@
+#pragma once
+
+#include <vector>
+
+#include <QImage>
+
+// Build mip chain of an ARGB32 image down to 1x1 (level 0, the image itself, is not included)
+// Each level is a 2x2 box filter of the previous one (SSE2 when available), large levels are split into bands on the shared thread pool
+// Odd sizes keep all texels, the dropped last row or column is averaged into the edge of the smaller level
+std::vector<QImage> generateMipmaps(const QImage &image);
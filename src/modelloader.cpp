@@ -0,0 +1,169 @@
+#include "modelloader.h"
+
+#include <iostream>
+#include <sstream>
+#include <iterator>
+
+#include <QRunnable>
+#include <QElapsedTimer>
+
+namespace {
+
+bool loadModelMesh(const QString &path, LoadedModel &model) {
+    model.path = path;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    model.mapped = openMeshCache(path);
+    if (model.mapped) {
+        model.sourceHash = model.mapped->header().sourceHash;
+
+        // Levels of detail were generated when cache was written
+        model.levelIndices.assign(model.mapped->levelIndices(), model.mapped->levelIndices() + model.mapped->levelIndexCount());
+        model.levels.assign(model.mapped->levels(), model.mapped->levels() + model.mapped->levelCount());
+
+        std::ostringstream out;
+        out << "Mapped model cache: " << model.mapped->vertexCount() << " vertices, " << model.mapped->indexCount() << " indices, "
+            << model.levels.size() << " levels in " << static_cast<double>(timer.nsecsElapsed()) / 1e6 << " ms [" << path.toStdString() << "]\n";
+        std::cout << out.str() << std::flush;
+        return true;
+    }
+
+    OBJStats stats;
+    if (!loadOBJ(path, model.vertices, model.indices, &stats)) {
+        std::cerr << "Model OBJ file parsing failed! [" << path.toStdString() << "]" << std::endl;
+        return false;
+    }
+    printOBJStats(path, stats);
+
+    // Normal mapping frame from OBJ UVs
+    computeTangents(model.vertices, model.indices);
+
+    // Triangle and vertex order for GPU, cache stores optimized mesh
+    optimizeMesh(model.vertices, model.indices);
+    return true;
+}
+
+} // namespace
+
+bool loadModel(const QString &path, LoadedModel &model) {
+    if (!loadModelMesh(path, model)) {
+        return false;
+    }
+    if (model.mapped) {
+        return true;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // Levels of detail of dense models share model's vertices
+    generateLevels(model.vertices.data(), model.vertices.size(), model.indices.data(), model.indices.size(), model.levelIndices, model.levels);
+
+    if (model.levels.size() > 1) {
+        std::ostringstream out;
+        out << "Generated levels of detail: " << model.levels.size() - 1 << " levels, down to " << model.levels.back().indexCount / 3
+            << " triangles in " << static_cast<double>(timer.nsecsElapsed()) / 1e6 << " ms [" << path.toStdString() << "]\n";
+        std::cout << out.str() << std::flush;
+    }
+
+    // Cache stores levels too, later loads (including synchronous preloads) skip simplification
+    model.sourceHash = hashFileContents(path);
+    writeMeshCache(path, model.sourceHash, model.vertices, model.indices, model.levelIndices, model.levels);
+    return true;
+}
+
+class ModelLoadTask : public QRunnable {
+public:
+    ModelLoadTask(ModelLoader *loader_, QString path_, int generation_)
+        : loader(loader_), path(path_), generation(generation_) {}
+
+    void run() override {
+        // Skip tasks cancelled while still queued
+        if (loader->generation.load() != generation) {
+            loader->taskDone(nullptr, generation);
+            return;
+        }
+
+        LoadedModel model;
+        bool loaded = loadModel(path, model);
+        loader->taskDone(loaded ? &model : nullptr, generation);
+    }
+
+private:
+    ModelLoader *loader;
+    QString path;
+    int generation;
+};
+
+ModelLoader::ModelLoader(QObject *parent) : QObject(parent), generation(0) {}
+
+ModelLoader::~ModelLoader() {
+    cancel();
+    pool.waitForDone();
+}
+
+void ModelLoader::load(const QStringList &paths) {
+    int finishedNow, total;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (pending == 0) {
+            // New batch
+            finishedCount = 0;
+            totalCount = 0;
+        }
+        pending += paths.size();
+        totalCount += paths.size();
+        finishedNow = finishedCount;
+        total = totalCount;
+    }
+
+    for (const auto &path : paths) {
+        pool.start(new ModelLoadTask(this, path, generation.load()));
+    }
+
+    emit progress(finishedNow, total);
+}
+
+void ModelLoader::cancel() {
+    std::lock_guard<std::mutex> lock(mutex);
+    ++generation;
+    loaded.clear();
+    totalCount = finishedCount;
+}
+
+bool ModelLoader::isLoading() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return pending > 0;
+}
+
+std::vector<LoadedModel> ModelLoader::takeLoaded() {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<LoadedModel> models(std::make_move_iterator(loaded.begin()), std::make_move_iterator(loaded.end()));
+    loaded.clear();
+    return models;
+}
+
+void ModelLoader::taskDone(LoadedModel *model, int taskGeneration) {
+    bool ready = false, done = false;
+    int finishedNow, total;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (taskGeneration == generation.load()) {
+            ++finishedCount;
+            if (model != nullptr) {
+                loaded.push_back(std::move(*model));
+                ready = true;
+            }
+        }
+        done = --pending == 0;
+        finishedNow = finishedCount;
+        total = totalCount;
+    }
+
+    // Emitted from worker thread, delivered queued to receivers on the GUI thread
+    if (ready) emit modelsReady();
+    emit progress(finishedNow, total);
+    if (done) emit finished();
+}
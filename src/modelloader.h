@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include <QObject>
+#include <QThreadPool>
+#include <QStringList>
+
+#include "mesh.h"
+#include "objloader.h"
+#include "meshcache.h"
+#include "lod.h"
+#include "meshoptimize.h"
+#include "normalmap.h"
+
+struct LoadedModel {
+    QString path;
+    std::vector<Vertex> vertices;
+    std::vector<GLuint> indices;
+    std::shared_ptr<MappedMesh> mapped; // Set instead of vertices and indices if loaded from mesh cache
+    uint64_t sourceHash = 0; // Content hash of source file (asset key)
+    std::vector<GLuint> levelIndices; // Levels of detail beyond original (see generateLevels())
+    std::vector<MeshLevel> levels;
+};
+
+// Load a model synchronously, mapping its binary mesh cache if it is valid, otherwise parsing it and writing the cache
+// Parsed meshes are optimized and their levels of detail generated before caching, mapped caches bring stored levels (no simplification)
+bool loadModel(const QString &path, LoadedModel &model /* out */);
+
+// Parses model files on a worker thread pool (one file per task)
+// Finished models are queued for the GUI (OpenGL) thread, which takes them when modelsReady() is emitted
+class ModelLoader : public QObject {
+    Q_OBJECT
+public:
+    explicit ModelLoader(QObject *parent = nullptr);
+    ~ModelLoader() override;
+
+    void load(const QStringList &paths);
+    bool isLoading();
+
+    // Take all models finished so far
+    std::vector<LoadedModel> takeLoaded();
+
+public slots:
+    void cancel(); // Discards queued and running tasks (a file being parsed is still finished, but dropped)
+
+signals:
+    void modelsReady();
+    void progress(int finished, int total);
+    void finished();
+
+private:
+    friend class ModelLoadTask;
+
+    QThreadPool pool;
+
+    std::mutex mutex; // Guards everything below
+    std::deque<LoadedModel> loaded;
+    int pending = 0; // Tasks not yet done (including cancelled ones)
+    int finishedCount = 0;
+    int totalCount = 0;
+    std::atomic<int> generation; // Increased on cancel, tasks of older generations are discarded
+
+    void taskDone(LoadedModel *model /* nullptr if failed or cancelled */, int taskGeneration);
+};
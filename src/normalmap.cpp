@@ -0,0 +1,184 @@
+#include "normalmap.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "parallel.h"
+
+namespace {
+
+// Bands with fewer pixels are not worth a pool task
+const int bandPixels = 256 * 256;
+
+const float inverseSqrt3 = 0.57735027f;
+
+// Heights of rows [rowBegin, rowEnd) into float plane (length of RGB in [0, 1] channels)
+void heightRows(const QImage &source, float *heights, int rowBegin, int rowEnd) {
+    int width = source.width();
+    for (int y = rowBegin; y < rowEnd; ++y) {
+        const uint32_t *in = reinterpret_cast<const uint32_t *>(source.constScanLine(y));
+        float *out = heights + static_cast<size_t>(y) * width;
+
+        int x = 0;
+#ifdef __SSE2__
+        const __m128i mask = _mm_set1_epi32(0xFF);
+        const __m128 scale = _mm_set1_ps(1.0f / (255.0f * 255.0f));
+        for (; x + 4 <= width; x += 4) {
+            __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + x));
+            __m128 b = _mm_cvtepi32_ps(_mm_and_si128(pixels, mask));
+            __m128 g = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(pixels, 8), mask));
+            __m128 r = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(pixels, 16), mask));
+            __m128 squared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r, r), _mm_mul_ps(g, g)), _mm_mul_ps(b, b));
+            _mm_storeu_ps(out + x, _mm_sqrt_ps(_mm_mul_ps(squared, scale)));
+        }
+#endif
+
+        for (; x < width; ++x) {
+            float r = static_cast<float>(qRed(in[x])), g = static_cast<float>(qGreen(in[x])), b = static_cast<float>(qBlue(in[x]));
+            out[x] = std::sqrt((r * r + g * g + b * b) / (255.0f * 255.0f));
+        }
+    }
+}
+
+uint32_t packNormal(float gx, float gy, float height, float strength) {
+    float nx = -strength * gx, ny = -strength * gy;
+    float inverseLength = 1.0f / std::sqrt(nx * nx + ny * ny + 1.0f);
+    uint32_t r = static_cast<uint32_t>(nx * inverseLength * 127.5f + 128.0f);
+    uint32_t g = static_cast<uint32_t>(ny * inverseLength * 127.5f + 128.0f);
+    uint32_t b = static_cast<uint32_t>(inverseLength * 127.5f + 128.0f);
+    uint32_t a = static_cast<uint32_t>(height * inverseSqrt3 * 255.0f + 0.5f);
+    return (a << 24) | (r << 16) | (g << 8) | b;
+}
+
+// Normals of rows [rowBegin, rowEnd) from Scharr slopes of height plane, written through raw pointer (see mipmap.cpp)
+void normalRows(const float *heights, int width, int height, float strength, uchar *destination, int destinationStride, int rowBegin, int rowEnd) {
+    // Kernel is [3 10 3] across, central difference along (2 texels), weights sum to 16
+    const float scale = 1.0f / 32.0f;
+    for (int y = rowBegin; y < rowEnd; ++y) {
+        const float *row0 = heights + static_cast<size_t>((y + height - 1) % height) * width;
+        const float *row1 = heights + static_cast<size_t>(y) * width;
+        const float *row2 = heights + static_cast<size_t>((y + 1) % height) * width;
+        uint32_t *out = reinterpret_cast<uint32_t *>(destination + static_cast<size_t>(y) * destinationStride);
+
+        auto pixel = [&](int x) {
+            int left = (x + width - 1) % width, right = (x + 1) % width;
+            float gx = 3.0f * (row0[right] - row0[left]) + 10.0f * (row1[right] - row1[left]) + 3.0f * (row2[right] - row2[left]);
+            float gy = 3.0f * (row2[left] - row0[left]) + 10.0f * (row2[x] - row0[x]) + 3.0f * (row2[right] - row0[right]);
+            out[x] = packNormal(gx * scale, gy * scale, row1[x], strength);
+        };
+
+        // First column wraps around, SIMD covers the interior
+        pixel(0);
+        int x = 1;
+#ifdef __SSE2__
+        const __m128 three = _mm_set1_ps(3.0f);
+        const __m128 ten = _mm_set1_ps(10.0f);
+        const __m128 slope = _mm_set1_ps(-strength * scale);
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 half = _mm_set1_ps(127.5f);
+        const __m128 offset = _mm_set1_ps(128.0f);
+        const __m128 alphaScale = _mm_set1_ps(inverseSqrt3 * 255.0f);
+        const __m128 rounding = _mm_set1_ps(0.5f);
+        for (; x + 5 <= width; x += 4) {
+            __m128 l0 = _mm_loadu_ps(row0 + x - 1), c0 = _mm_loadu_ps(row0 + x), r0 = _mm_loadu_ps(row0 + x + 1);
+            __m128 l1 = _mm_loadu_ps(row1 + x - 1), c1 = _mm_loadu_ps(row1 + x), r1 = _mm_loadu_ps(row1 + x + 1);
+            __m128 l2 = _mm_loadu_ps(row2 + x - 1), c2 = _mm_loadu_ps(row2 + x), r2 = _mm_loadu_ps(row2 + x + 1);
+
+            __m128 gx = _mm_add_ps(_mm_mul_ps(three, _mm_add_ps(_mm_sub_ps(r0, l0), _mm_sub_ps(r2, l2))), _mm_mul_ps(ten, _mm_sub_ps(r1, l1)));
+            __m128 gy = _mm_add_ps(_mm_mul_ps(three, _mm_add_ps(_mm_sub_ps(l2, l0), _mm_sub_ps(r2, r0))), _mm_mul_ps(ten, _mm_sub_ps(c2, c0)));
+
+            __m128 nx = _mm_mul_ps(gx, slope);
+            __m128 ny = _mm_mul_ps(gy, slope);
+            __m128 inverseLength = _mm_div_ps(one, _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, nx), _mm_mul_ps(ny, ny)), one)));
+
+            __m128i r = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(nx, inverseLength), half), offset));
+            __m128i g = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(ny, inverseLength), half), offset));
+            __m128i b = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(inverseLength, half), offset));
+            __m128i a = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(c1, alphaScale), rounding));
+
+            __m128i packed = _mm_or_si128(_mm_or_si128(_mm_slli_epi32(a, 24), _mm_slli_epi32(r, 16)), _mm_or_si128(_mm_slli_epi32(g, 8), b));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + x), packed);
+        }
+#endif
+
+        // Remaining pixels, last column wraps around
+        for (; x < width; ++x) {
+            pixel(x);
+        }
+    }
+}
+
+} // namespace
+
+QImage heightToNormalMap(const QImage &heightMap, float strength) {
+    QImage source = heightMap.convertToFormat(QImage::Format_ARGB32);
+    int width = source.width();
+    int height = source.height();
+    QImage normalMap(width, height, QImage::Format_ARGB32);
+    if (width == 0 || height == 0) {
+        return normalMap;
+    }
+
+    std::vector<float> heights(static_cast<size_t>(width) * height);
+    size_t bandRows = static_cast<size_t>(std::max(bandPixels / width, 1));
+    parallelFor(static_cast<size_t>(height), bandRows, [&](size_t begin, size_t end) {
+        heightRows(source, heights.data(), static_cast<int>(begin), static_cast<int>(end));
+    });
+
+    // Slopes need neighbouring rows, heights are complete before normals start
+    uchar *bits = normalMap.bits();
+    int stride = normalMap.bytesPerLine();
+    parallelFor(static_cast<size_t>(height), bandRows, [&](size_t begin, size_t end) {
+        normalRows(heights.data(), width, height, strength, bits, stride, static_cast<int>(begin), static_cast<int>(end));
+    });
+    return normalMap;
+}
+
+void computeTangents(std::vector<Vertex> &vertices, const std::vector<GLuint> &indices) {
+    // Area weighted sums of triangle UV directions (Lengyel's method)
+    std::vector<glm::vec3> tangents(vertices.size(), glm::vec3(0.0f));
+    std::vector<glm::vec3> bitangents(vertices.size(), glm::vec3(0.0f));
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        const Vertex &v0 = vertices[indices[i]];
+        const Vertex &v1 = vertices[indices[i + 1]];
+        const Vertex &v2 = vertices[indices[i + 2]];
+
+        glm::vec3 edge1 = v1.position - v0.position, edge2 = v2.position - v0.position;
+        glm::vec2 deltaUV1 = v1.uv - v0.uv, deltaUV2 = v2.uv - v0.uv;
+        float determinant = deltaUV1.x * deltaUV2.y - deltaUV2.x * deltaUV1.y;
+        if (std::abs(determinant) < 1e-12f) {
+            continue;
+        }
+
+        float r = 1.0f / determinant;
+        glm::vec3 tangent = (edge1 * deltaUV2.y - edge2 * deltaUV1.y) * r;
+        glm::vec3 bitangent = (edge2 * deltaUV1.x - edge1 * deltaUV2.x) * r;
+        for (size_t k = 0; k < 3; ++k) {
+            tangents[indices[i + k]] += tangent;
+            bitangents[indices[i + k]] += bitangent;
+        }
+    }
+
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        Vertex &vertex = vertices[i];
+        float normalLength = glm::length(vertex.normal);
+        glm::vec3 normal = normalLength > 0.0f ? vertex.normal / normalLength : glm::vec3(0.0f, 0.0f, 1.0f);
+
+        // Gram-Schmidt against normal, handedness from accumulated bitangent
+        glm::vec3 tangent = tangents[i] - normal * glm::dot(normal, tangents[i]);
+        float length = glm::length(tangent);
+        if (length < 1e-6f) {
+            glm::vec3 axis = std::abs(normal.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+            tangent = glm::normalize(glm::cross(axis, normal));
+        } else {
+            tangent /= length;
+        }
+        float sign = glm::dot(glm::cross(normal, tangent), bitangents[i]) < 0.0f ? -1.0f : 1.0f;
+        vertex.tangent = glm::vec4(tangent, sign);
+    }
+}
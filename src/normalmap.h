@@ -0,0 +1,17 @@
+#pragma once
+
+#include <vector>
+
+#include <QImage>
+#include <QOpenGLFunctions_3_3_Core>
+
+#include "mesh.h"
+
+// Convert an ARGB32 height map (height is length of RGB, as sampled by derivative bump mapping) to a tangent-space normal map
+// Slopes come from a 3x3 Scharr kernel (SSE2 when available, rows split into bands on the shared thread pool), edges wrap like repeated textures
+// Output is ARGB32: RGB - normal * 0.5 + 0.5 (green along increasing rows, texture V), A - height / sqrt(3)
+QImage heightToNormalMap(const QImage &heightMap, float strength);
+
+// Per-vertex tangents (direction of increasing U, bitangent sign in w) from triangle UVs, orthogonal to vertex normals
+// Vertices without usable UVs get an arbitrary tangent perpendicular to their normal
+void computeTangents(std::vector<Vertex> &vertices, const std::vector<GLuint> &indices);
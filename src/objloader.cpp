@@ -0,0 +1,475 @@
+#include "objloader.h"
+
+#include <iostream>
+#include <sstream>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#include <QFile>
+#include <QElapsedTimer>
+
+namespace {
+
+// Face corner, 0-based indices into parsed arrays (-1 if not present)
+struct Corner {
+    int32_t position;
+    int32_t uv;
+    int32_t normal;
+};
+
+const double powersOf10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+inline bool isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+inline bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+// End of token (blank, new line or end of data)
+inline bool isSeparator(const char *p, const char *end) {
+    return p >= end || isBlank(*p) || *p == '\n';
+}
+
+inline const char *skipBlanks(const char *p, const char *end) {
+    while (p < end && isBlank(*p)) ++p;
+    return p;
+}
+
+inline const char *nextLine(const char *p, const char *end) {
+    const void *newLine = memchr(p, '\n', static_cast<size_t>(end - p));
+    return newLine ? static_cast<const char *>(newLine) + 1 : end;
+}
+
+// Scan [+-]digits[.digits][(e|E)[+-]digits] without locale or stream overhead
+bool scanFloat(const char *&p, const char *end, float &out) {
+    const char *s = p;
+    bool negative = false;
+    if (s < end && (*s == '-' || *s == '+')) {
+        negative = *s == '-';
+        ++s;
+    }
+
+    // Accumulate up to 17 significant digits, the rest only shifts the exponent (integer part) or is dropped (fraction)
+    const uint64_t mantissaLimit = 10000000000000000ULL;
+    uint64_t mantissa = 0;
+    int exponent = 0;
+    bool digits = false;
+    for (; s < end && isDigit(*s); ++s) {
+        if (mantissa < mantissaLimit) {
+            mantissa = mantissa * 10 + static_cast<uint64_t>(*s - '0');
+        } else {
+            ++exponent;
+        }
+        digits = true;
+    }
+    if (s < end && *s == '.') {
+        for (++s; s < end && isDigit(*s); ++s) {
+            if (mantissa < mantissaLimit) {
+                mantissa = mantissa * 10 + static_cast<uint64_t>(*s - '0');
+                --exponent;
+            }
+            digits = true;
+        }
+    }
+    if (!digits) return false;
+
+    if (s < end && (*s == 'e' || *s == 'E')) {
+        const char *e = s + 1;
+        bool exponentNegative = false;
+        if (e < end && (*e == '-' || *e == '+')) {
+            exponentNegative = *e == '-';
+            ++e;
+        }
+        if (e < end && isDigit(*e)) {
+            int value = 0;
+            for (; e < end && isDigit(*e); ++e) {
+                if (value < 10000) value = value * 10 + (*e - '0');
+            }
+            exponent += exponentNegative ? -value : value;
+            s = e;
+        }
+    }
+
+    double value = static_cast<double>(mantissa);
+    if (exponent < 0) {
+        value = (exponent >= -22) ? value / powersOf10[-exponent] : value * std::pow(10.0, exponent);
+    } else if (exponent > 0) {
+        value = (exponent <= 22) ? value * powersOf10[exponent] : value * std::pow(10.0, exponent);
+    }
+
+    out = static_cast<float>(negative ? -value : value);
+    p = s;
+    return true;
+}
+
+bool scanInt(const char *&p, const char *end, int64_t &out) {
+    const char *s = p;
+    bool negative = false;
+    if (s < end && (*s == '-' || *s == '+')) {
+        negative = *s == '-';
+        ++s;
+    }
+    if (s >= end || !isDigit(*s)) return false;
+
+    int64_t value = 0;
+    for (; s < end && isDigit(*s); ++s) {
+        if (value < (int64_t(1) << 40)) value = value * 10 + (*s - '0');
+    }
+
+    out = negative ? -value : value;
+    p = s;
+    return true;
+}
+
+// Convert 1-based or negative (relative to the end) OBJ index to 0-based index
+inline bool resolveIndex(int64_t index, size_t count, int32_t &out) {
+    if (index > 0 && static_cast<size_t>(index) <= count) {
+        out = static_cast<int32_t>(index - 1);
+    } else if (index < 0 && static_cast<size_t>(-index) <= count) {
+        out = static_cast<int32_t>(static_cast<int64_t>(count) + index);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Open-addressing (linear probing) map of face corners to already emitted vertex indices
+class CornerMap {
+public:
+    explicit CornerMap(size_t expected) {
+        size_t capacity = 64;
+        while (capacity < expected * 2) capacity <<= 1;
+        entries.assign(capacity, {{-1, -1, -1}, 0});
+    }
+
+    // Return vertex index of an equal corner if it exists, otherwise insert given index
+    GLuint findOrInsert(const Corner &corner, GLuint index, bool &inserted) {
+        if ((count + 1) * 2 > entries.size()) grow();
+
+        size_t mask = entries.size() - 1;
+        for (size_t i = hash(corner) & mask; ; i = (i + 1) & mask) {
+            Entry &entry = entries[i];
+            if (entry.corner.position < 0) {
+                entry = {corner, index};
+                ++count;
+                inserted = true;
+                return index;
+            }
+            if (entry.corner.position == corner.position && entry.corner.uv == corner.uv && entry.corner.normal == corner.normal) {
+                inserted = false;
+                return entry.vertex;
+            }
+        }
+    }
+
+private:
+    struct Entry {
+        Corner corner; // position < 0 marks an empty slot
+        GLuint vertex;
+    };
+
+    std::vector<Entry> entries;
+    size_t count = 0;
+
+    static size_t hash(const Corner &corner) {
+        uint64_t h = static_cast<uint32_t>(corner.position) * 0x9E3779B97F4A7C15ULL;
+        h ^= static_cast<uint32_t>(corner.uv) * 0xC2B2AE3D27D4EB4FULL + (h >> 29);
+        h ^= static_cast<uint32_t>(corner.normal) * 0x165667B19E3779F9ULL + (h >> 32);
+        return static_cast<size_t>(h ^ (h >> 31));
+    }
+
+    void grow() {
+        std::vector<Entry> old(entries.size() * 2, {{-1, -1, -1}, 0});
+        old.swap(entries);
+        count = 0;
+
+        bool inserted;
+        for (const auto &entry : old) {
+            if (entry.corner.position >= 0) findOrInsert(entry.corner, entry.vertex, inserted);
+        }
+    }
+};
+
+// Scan whitespace separated floats up to the given count
+template <int N>
+bool scanFloats(const char *&p, const char *end, float (&out)[N]) {
+    for (int i = 0; i < N; ++i) {
+        p = skipBlanks(p, end);
+        if (!scanFloat(p, end, out[i]) || !isSeparator(p, end)) return false;
+    }
+    return true;
+}
+
+// Faces meeting at a sharper angle keep separate normals (hard edge), 60 degrees
+const float creaseCos = 0.5f;
+
+// Normals of vertices welded from corners without normals (generated marks them), area weighted sum of triangle normals
+// Corners of a vertex are grouped by triangle normal, a group past the crease angle gets own copy of the vertex (indices are updated)
+void generateNormals(std::vector<Vertex> &vertices, std::vector<GLuint> &indices, const std::vector<uint8_t> &generated) {
+    // Corners of each generated vertex (compressed rows)
+    size_t vertexCount = vertices.size();
+    std::vector<uint32_t> offsets(vertexCount + 1, 0);
+    for (GLuint index : indices) {
+        offsets[index + 1] += generated[index];
+    }
+    for (size_t v = 0; v < vertexCount; ++v) {
+        offsets[v + 1] += offsets[v];
+    }
+    std::vector<uint32_t> corners(offsets[vertexCount]);
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t c = 0; c < indices.size(); ++c) {
+        if (generated[indices[c]]) {
+            corners[fill[indices[c]]++] = static_cast<uint32_t>(c);
+        }
+    }
+
+    struct Group {
+        GLuint vertex;
+        glm::vec3 direction; // Unit normal of first triangle
+        glm::vec3 sum; // Area weighted
+    };
+    std::vector<Group> groups;
+    for (size_t v = 0; v < vertexCount; ++v) {
+        if (!generated[v]) {
+            continue;
+        }
+
+        groups.clear();
+        for (uint32_t k = offsets[v]; k < offsets[v + 1]; ++k) {
+            uint32_t c = corners[k];
+            size_t t = c - c % 3;
+            const glm::vec3 &a = vertices[indices[t]].position;
+            glm::vec3 cross = glm::cross(vertices[indices[t + 1]].position - a, vertices[indices[t + 2]].position - a);
+            float length = glm::length(cross);
+            glm::vec3 direction = length > 0.0f ? cross / length : glm::vec3(0.0f);
+
+            // Degenerate triangles join any group
+            Group *group = nullptr;
+            for (auto &candidate : groups) {
+                if (length == 0.0f || glm::dot(candidate.direction, direction) >= creaseCos) {
+                    group = &candidate;
+                    break;
+                }
+            }
+            if (group == nullptr) {
+                GLuint vertex = static_cast<GLuint>(v);
+                if (!groups.empty()) {
+                    vertex = static_cast<GLuint>(vertices.size());
+                    vertices.push_back(vertices[v]);
+                }
+                groups.push_back({vertex, direction, glm::vec3(0.0f)});
+                group = &groups.back();
+            }
+            group->sum += cross;
+            indices[c] = group->vertex;
+        }
+
+        for (const auto &group : groups) {
+            float length = glm::length(group.sum);
+            vertices[group.vertex].normal = length > 0.0f ? group.sum / length : glm::vec3(0.0f, 1.0f, 0.0f);
+        }
+    }
+}
+
+} // namespace
+
+bool parseOBJ(const char *begin, const char *end, std::vector<Vertex> &vertices, std::vector<GLuint> &indices, OBJStats *stats) {
+    // First pass - count elements, so arrays are allocated up front
+    size_t positionCount = 0, uvCount = 0, normalCount = 0, faceCount = 0, triangleCount = 0;
+    for (const char *p = begin; p < end; ) {
+        const char *s = skipBlanks(p, end);
+        if (end - s > 2 && s[0] == 'v') {
+            if (isBlank(s[1])) {
+                ++positionCount;
+            } else if (s[1] == 't' && isBlank(s[2])) {
+                ++uvCount;
+            } else if (s[1] == 'n' && isBlank(s[2])) {
+                ++normalCount;
+            }
+        } else if (end - s > 1 && s[0] == 'f' && isBlank(s[1])) {
+            // Count corners (groups of non-blank characters)
+            size_t corners = 0;
+            for (s += 1; ; ++corners) {
+                s = skipBlanks(s, end);
+                if (s >= end || *s == '\n' || *s == '#') break;
+                while (!isSeparator(s, end)) ++s;
+            }
+            ++faceCount;
+            if (corners >= 3) triangleCount += corners - 2;
+        }
+        p = nextLine(s, end);
+    }
+
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec2> uvs;
+    std::vector<glm::vec3> normals;
+    positions.reserve(positionCount);
+    uvs.reserve(uvCount);
+    normals.reserve(normalCount);
+
+    // Unique corners usually number close to the largest attribute array, so that is what we size for
+    size_t expectedVertices = std::min(triangleCount * 3, std::max(positionCount, std::max(uvCount, normalCount)) * 3 / 2);
+    CornerMap cornerMap(expectedVertices);
+
+    vertices.clear();
+    indices.clear();
+    vertices.reserve(expectedVertices);
+    indices.reserve(triangleCount * 3);
+
+    // Second pass - parse in place
+    std::vector<Corner> polygon;
+    std::vector<uint8_t> generated; // Of vertices, normal is generated after welding
+    generated.reserve(expectedVertices);
+    bool anyGenerated = false;
+    size_t line = 0;
+    bool error = false;
+    for (const char *p = begin; p < end && !error; p = nextLine(p, end)) {
+        ++line;
+        const char *s = skipBlanks(p, end);
+        if (end - s < 2) continue;
+
+        if (s[0] == 'v' && isBlank(s[1])) {
+            float v[3];
+            s += 1;
+            error = !scanFloats(s, end, v);
+            positions.push_back({v[0], v[1], v[2]});
+        } else if (s[0] == 'v' && s[1] == 't' && end - s > 2 && isBlank(s[2])) {
+            float vt[2];
+            s += 2;
+            error = !scanFloats(s, end, vt);
+            uvs.push_back({vt[0], vt[1]});
+        } else if (s[0] == 'v' && s[1] == 'n' && end - s > 2 && isBlank(s[2])) {
+            float vn[3];
+            s += 2;
+            error = !scanFloats(s, end, vn);
+            normals.push_back({vn[0], vn[1], vn[2]});
+        } else if (s[0] == 'f' && isBlank(s[1])) {
+            polygon.clear();
+            for (s += 1; !error; ) {
+                s = skipBlanks(s, end);
+                if (s >= end || *s == '\n' || *s == '#') break;
+
+                // Corner forms: v, v/vt, v//vn, v/vt/vn
+                Corner corner = {-1, -1, -1};
+                int64_t index = 0;
+                error = !scanInt(s, end, index) || !resolveIndex(index, positions.size(), corner.position);
+                if (!error && s < end && *s == '/') {
+                    ++s;
+                    if (s < end && *s != '/') {
+                        error = !scanInt(s, end, index) || !resolveIndex(index, uvs.size(), corner.uv);
+                    }
+                    if (!error && s < end && *s == '/') {
+                        ++s;
+                        error = !scanInt(s, end, index) || !resolveIndex(index, normals.size(), corner.normal);
+                    }
+                }
+                error = error || !isSeparator(s, end);
+                polygon.push_back(corner);
+            }
+            error = error || polygon.size() < 3;
+            if (error) break;
+
+            // Fan triangulation (exact for convex polygons, which OBJ exporters produce)
+            for (size_t i = 1; i + 1 < polygon.size(); ++i) {
+                const Corner *triangle[3] = {&polygon[0], &polygon[i], &polygon[i + 1]};
+                glm::vec3 corners[3] = {positions[static_cast<size_t>(triangle[0]->position)],
+                                        positions[static_cast<size_t>(triangle[1]->position)],
+                                        positions[static_cast<size_t>(triangle[2]->position)]};
+
+                for (uint32_t k = 0; k < 3; ++k) {
+                    const Corner &corner = *triangle[k];
+
+                    // Weld corners referencing the same (position, uv, normal) triple, corners without normal weld on (position, uv)
+                    bool inserted;
+                    GLuint index = cornerMap.findOrInsert(corner, static_cast<GLuint>(vertices.size()), inserted);
+
+                    if (inserted) {
+                        glm::vec2 uv = (corner.uv >= 0) ? uvs[static_cast<size_t>(corner.uv)] : glm::vec2(0.0f);
+                        glm::vec3 normal = (corner.normal >= 0) ? normals[static_cast<size_t>(corner.normal)] : glm::vec3(0.0f);
+                        vertices.push_back({corners[k], uv, normal, glm::vec4(0.0f)});
+                        generated.push_back(corner.normal < 0);
+                        anyGenerated |= corner.normal < 0;
+                    }
+                    indices.push_back(index);
+                }
+            }
+        }
+        // Anything else is a comment or something we don't support (groups, materials ...), skip the line
+    }
+
+    if (error) {
+        std::cerr << "Model OBJ parsing error at line " << line << std::endl;
+        return false;
+    }
+
+    // Smooth normals from welded neighbourhood, split only at creases
+    if (anyGenerated) {
+        generateNormals(vertices, indices, generated);
+    }
+
+    if (stats != nullptr) {
+        stats->bytes = end - begin;
+        stats->positions = positions.size();
+        stats->uvs = uvs.size();
+        stats->normals = normals.size();
+        stats->faces = faceCount;
+        stats->triangles = triangleCount;
+        stats->weldedVertices = indices.size() - vertices.size();
+        stats->savedBytes = static_cast<qint64>(stats->weldedVertices * sizeof(Vertex));
+    }
+
+    return true;
+}
+
+bool loadOBJ(const QString &path, std::vector<Vertex> &vertices, std::vector<GLuint> &indices, OBJStats *stats) {
+    QElapsedTimer timer;
+    timer.start();
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        std::cerr << "Model OBJ file opening failed! [" << path.toStdString() << "]" << std::endl;
+        return false;
+    }
+
+    // Map the whole file and parse it in place, read it only if mapping is not supported
+    qint64 size = file.size();
+    uchar *mapped = (size > 0) ? file.map(0, size) : nullptr;
+    QByteArray contents;
+    const char *data = reinterpret_cast<const char *>(mapped);
+    if (mapped == nullptr) {
+        contents = file.readAll();
+        data = contents.constData();
+        size = contents.size();
+    }
+
+    bool parsed = parseOBJ(data, data + size, vertices, indices, stats);
+
+    if (mapped != nullptr) {
+        file.unmap(mapped);
+    }
+    file.close();
+
+    if (stats != nullptr) {
+        stats->parseTime = static_cast<double>(timer.nsecsElapsed()) / 1e6;
+    }
+
+    return parsed;
+}
+
+void printOBJStats(const QString &path, const OBJStats &stats) {
+    double seconds = std::max(stats.parseTime / 1000.0, 1e-9);
+    size_t corners = stats.triangles * 3;
+
+    std::ostringstream out;
+    out << "Loaded model OBJ: " << stats.triangles << " triangles, " << stats.bytes / 1024 << " KiB in " << stats.parseTime << " ms ("
+        << stats.bytes / (1024.0 * 1024.0) / seconds << " MB/s, " << stats.triangles / seconds << " triangles/s) [" << path.toStdString() << "]\n";
+    out << "Welded model vertices: " << corners - stats.weldedVertices << " unique of " << corners << " corners, "
+        << stats.weldedVertices << " welded, " << stats.savedBytes / 1024 << " KiB saved [" << path.toStdString() << "]\n";
+    std::cout << out.str() << std::flush;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <vector>
+
+#include <QString>
+#include <QOpenGLFunctions_3_3_Core>
+
+#include "mesh.h"
+
+struct OBJStats {
+    qint64 bytes = 0; // Size of parsed text
+    size_t positions = 0;
+    size_t uvs = 0;
+    size_t normals = 0;
+    size_t faces = 0;
+    size_t triangles = 0; // After fan triangulation
+    size_t weldedVertices = 0; // Face corners merged into an existing vertex
+    qint64 savedBytes = 0; // Vertex buffer size saved by welding
+    double parseTime = 0.0; // Milliseconds, including mapping the file
+};
+
+// Parse OBJ text in [begin, end) into an indexed triangle mesh, face corners with equal indices share a vertex
+// Supports "v", "v/vt", "v//vn" and "v/vt/vn" face corners, negative (relative) indices and polygons (fan triangulated)
+// Missing UVs are zeroed, corners without normals are welded on (position, uv) and get generated normals
+// Generated normals are smooth (area weighted), vertices are split only where faces meet at a crease sharper than 60 degrees
+bool parseOBJ(const char *begin, const char *end, std::vector<Vertex> &vertices /* out */, std::vector<GLuint> &indices /* out */, OBJStats *stats = nullptr);
+
+// Memory-map OBJ file and parse it in place (falls back to reading the file if mapping is not possible)
+bool loadOBJ(const QString &path, std::vector<Vertex> &vertices /* out */, std::vector<GLuint> &indices /* out */, OBJStats *stats = nullptr);
+
+// Print load statistics with a single write (safe to call from worker threads)
+void printOBJStats(const QString &path, const OBJStats &stats);
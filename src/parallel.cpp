@@ -0,0 +1,53 @@
+#include "parallel.h"
+
+#include <algorithm>
+
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThreadPool>
+
+namespace {
+
+// Set on global pool workers while they run a band
+thread_local bool inBand = false;
+
+class BandTask : public QRunnable {
+public:
+    BandTask(const std::function<void(size_t, size_t)> &function_, size_t begin_, size_t end_, QSemaphore &done_)
+        : function(function_), begin(begin_), end(end_), done(done_) {}
+
+    void run() override {
+        inBand = true;
+        function(begin, end);
+        inBand = false;
+        done.release();
+    }
+
+private:
+    const std::function<void(size_t, size_t)> &function;
+    size_t begin;
+    size_t end;
+    QSemaphore &done;
+};
+
+} // namespace
+
+void parallelFor(size_t count, size_t minBandSize, const std::function<void(size_t, size_t)> &function) {
+    QThreadPool *pool = QThreadPool::globalInstance();
+    size_t bandCount = std::min(static_cast<size_t>(std::max(pool->maxThreadCount(), 1)), count / std::max<size_t>(minBandSize, 1));
+    if (inBand || bandCount <= 1) {
+        function(0, count);
+        return;
+    }
+
+    // Equal bands, this thread takes the last one
+    QSemaphore done;
+    size_t band = (count + bandCount - 1) / bandCount;
+    int tasks = 0;
+    for (size_t begin = 0; begin + band < count; begin += band) {
+        pool->start(new BandTask(function, begin, begin + band, done));
+        ++tasks;
+    }
+    function(static_cast<size_t>(tasks) * band, count);
+    done.acquire(tasks);
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+// Run function(begin, end) over equal bands of [0, count), each band has at least minBandSize items
+// Bands run on persistent workers of global thread pool (no threads are created per call), calling thread takes the last one
+// Calls from within a band (nested) run as a single band on the calling thread, so the pool is never oversubscribed
+void parallelFor(size_t count, size_t minBandSize, const std::function<void(size_t, size_t)> &function);
@@ -0,0 +1,129 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <iostream>
+
+void Profiler::initialize(QOpenGLFunctions_3_3_Core *gl_) {
+    gl = gl_;
+    timer.start();
+}
+
+void Profiler::destroy() {
+    if (gl == nullptr) {
+        return;
+    }
+
+    for (auto &frame : frames) {
+        if (!frame.queries.empty()) {
+            gl->glDeleteQueries(static_cast<GLsizei>(frame.queries.size()), frame.queries.data());
+        }
+        frame = Frame();
+    }
+    gl = nullptr;
+}
+
+size_t Profiler::timestamp() {
+    Frame &frame = current();
+    if (frame.usedQueries == frame.queries.size()) {
+        GLuint query;
+        gl->glGenQueries(1, &query);
+        frame.queries.push_back(query);
+    }
+    gl->glQueryCounter(frame.queries[frame.usedQueries], GL_TIMESTAMP);
+    return frame.usedQueries++;
+}
+
+bool Profiler::collect(Frame &frame) {
+    // Queries complete in order, last one being available means all are
+    GLuint available = 0;
+    gl->glGetQueryObjectuiv(frame.queries[frame.usedQueries - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) {
+        return false;
+    }
+
+    std::vector<GLuint64> timestamps(frame.usedQueries);
+    for (size_t i = 0; i < frame.usedQueries; ++i) {
+        gl->glGetQueryObjectui64v(frame.queries[i], GL_QUERY_RESULT, &timestamps[i]);
+    }
+
+    profile = frame.counters;
+    profile.frame = frame.number;
+    profile.scopes.clear();
+    for (const auto &scope : frame.scopes) {
+        double cpuTime = static_cast<double>(scope.cpuEnd - scope.cpuBegin) / 1e6;
+        double gpuTime = static_cast<double>(timestamps[scope.queryEnd] - timestamps[scope.queryBegin]) / 1e6;
+
+        // Same scope may be entered several times per frame (eg. draw groups split by sorting)
+        auto found = std::find_if(profile.scopes.begin(), profile.scopes.end(), [&scope](const ProfileScope &existing) {
+            return existing.name == scope.name && existing.depth == scope.depth;
+        });
+        if (found != profile.scopes.end()) {
+            found->cpuTime += cpuTime;
+            found->gpuTime += gpuTime;
+        } else {
+            profile.scopes.push_back({scope.name, scope.depth, cpuTime, gpuTime});
+        }
+    }
+    return true;
+}
+
+void Profiler::beginFrame() {
+    // Oldest frame in ring is overwritten, its results are dropped if GPU is still that far behind (never waited for)
+    Frame &frame = current();
+    if (frame.pending) {
+        collect(frame);
+        frame.pending = false;
+    }
+
+    // Newer frames may have completed meanwhile
+    for (size_t i = 1; i < frameLatency; ++i) {
+        Frame &newer = frames[(frameNumber + i) % frameLatency];
+        if (newer.pending && collect(newer)) {
+            newer.pending = false;
+        }
+    }
+
+    frame.number = frameNumber;
+    frame.usedQueries = 0;
+    frame.scopes.clear();
+    openScopes.clear();
+    beginScope("Frame");
+}
+
+void Profiler::endFrame(uint32_t drawCalls, uint64_t triangles, uint32_t stateChanges) {
+    endScope();
+
+    Frame &frame = current();
+    frame.counters.drawCalls = drawCalls;
+    frame.counters.triangles = triangles;
+    frame.counters.stateChanges = stateChanges;
+    frame.counters.uploadedBytes = uploadedBytes;
+    frame.pending = frame.usedQueries > 0;
+    uploadedBytes = 0;
+    ++frameNumber;
+}
+
+void Profiler::beginScope(const char *name) {
+    Frame &frame = current();
+    frame.scopes.push_back({name, static_cast<uint32_t>(openScopes.size()), timer.nsecsElapsed(), 0, timestamp(), 0});
+    openScopes.push_back(frame.scopes.size() - 1);
+}
+
+void Profiler::endScope() {
+    if (openScopes.empty()) {
+        return;
+    }
+
+    Scope &scope = current().scopes[openScopes.back()];
+    openScopes.pop_back();
+    scope.queryEnd = timestamp();
+    scope.cpuEnd = timer.nsecsElapsed();
+
+#ifdef QT_DEBUG
+    // Errors are reported per scope, not just once per frame
+    GLenum err = gl->glGetError();
+    if (err != GL_NO_ERROR) {
+        std::cerr << "OpenGL error in " << scope.name << ": " << err << std::endl;
+    }
+#endif
+}
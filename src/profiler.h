@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <QElapsedTimer>
+#include <QOpenGLFunctions_3_3_Core>
+
+// CPU and GPU time of one named scope of a frame (all scopes of the same name summed)
+struct ProfileScope {
+    const char *name;
+    uint32_t depth; // Nesting level, 0 - whole frame
+    double cpuTime; // Milliseconds
+    double gpuTime;
+};
+
+// Times and counters of one completed frame
+struct FrameProfile {
+    uint64_t frame = 0; // Frame number, older than current one by up to Profiler::frameLatency
+    std::vector<ProfileScope> scopes; // In order of first begin
+    uint32_t drawCalls = 0;
+    uint64_t triangles = 0;
+    uint32_t stateChanges = 0; // Binds issued
+    uint64_t uploadedBytes = 0; // Buffers and textures, including uploads between frames
+};
+
+// Scoped CPU timers and GPU timestamp query pairs (OpenGL thread only)
+// Queries of a frame are read frameLatency frames later, only once available, so reading them never stalls
+// Scopes may nest (frame scope encloses passes), so timestamps are used rather than GL_TIME_ELAPSED (which can't nest)
+class Profiler {
+public:
+    static const size_t frameLatency = 3; // Frames of queries in flight
+
+    void initialize(QOpenGLFunctions_3_3_Core *gl_);
+    void destroy();
+
+    void beginFrame(); // Opens frame scope
+    void endFrame(uint32_t drawCalls, uint64_t triangles, uint32_t stateChanges);
+
+    // Scope names must outlive profiler (string literals)
+    void beginScope(const char *name);
+    void endScope();
+
+    void addUploadedBytes(uint64_t bytes) { uploadedBytes += bytes; }
+
+    // Most recent frame whose queries completed
+    const FrameProfile &lastProfile() const { return profile; }
+
+private:
+    struct Scope {
+        const char *name;
+        uint32_t depth;
+        qint64 cpuBegin; // Nanoseconds
+        qint64 cpuEnd;
+        size_t queryBegin; // Index in frame's queries
+        size_t queryEnd;
+    };
+
+    struct Frame {
+        uint64_t number = 0;
+        bool pending = false; // Queries issued, not read yet
+        std::vector<GLuint> queries; // Timestamp queries, reused between frames
+        size_t usedQueries = 0;
+        std::vector<Scope> scopes;
+        FrameProfile counters;
+    };
+
+    QOpenGLFunctions_3_3_Core *gl = nullptr;
+    QElapsedTimer timer;
+    Frame frames[frameLatency];
+    uint64_t frameNumber = 0;
+    std::vector<size_t> openScopes; // Indices in current frame's scopes
+    uint64_t uploadedBytes = 0;
+    FrameProfile profile;
+
+    Frame &current() { return frames[frameNumber % frameLatency]; }
+    size_t timestamp(); // Issue timestamp query into current frame, returns its index
+    bool collect(Frame &frame); // Read frame's queries into profile, false if not available yet
+};
+
+// Profiler scope of enclosing block
+class ProfileScopeGuard {
+public:
+    ProfileScopeGuard(Profiler &profiler_, const char *name)
+        : profiler(profiler_) { profiler.beginScope(name); }
+    ~ProfileScopeGuard() { profiler.endScope(); }
+
+private:
+    Profiler &profiler;
+};
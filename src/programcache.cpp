@@ -0,0 +1,178 @@
+#include "programcache.h"
+
+#include <iostream>
+#include <cstring>
+#include <string>
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QOpenGLContext>
+#include <QSaveFile>
+
+#include "meshcache.h"
+
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+
+void ProgramCache::initialize(QOpenGLFunctions_3_3_Core *gl_, const QString &directory_) {
+    gl = gl_;
+    directory = directory_;
+    lastStats = ProgramCacheStats();
+
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+    QSurfaceFormat format = context->format();
+    bool core41 = format.majorVersion() > 4 || (format.majorVersion() == 4 && format.minorVersion() >= 1);
+    if (core41 || context->hasExtension("GL_ARB_get_program_binary")) {
+        getProgramBinary = reinterpret_cast<GetProgramBinaryFunction>(context->getProcAddress("glGetProgramBinary"));
+        programBinary = reinterpret_cast<ProgramBinaryFunction>(context->getProcAddress("glProgramBinary"));
+        programParameteri = reinterpret_cast<ProgramParameteriFunction>(context->getProcAddress("glProgramParameteri"));
+    }
+
+    // Drivers may expose the functions, but support no formats
+    GLint formats = 0;
+    if (getProgramBinary != nullptr && programBinary != nullptr && programParameteri != nullptr) {
+        gl->glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    }
+    supported = formats > 0;
+
+    // Binaries are only valid for the driver that produced them, executable build guards against changed attribute or sampler setup
+    QFileInfo executable(QCoreApplication::applicationFilePath());
+    std::string environment;
+    environment += reinterpret_cast<const char *>(gl->glGetString(GL_VENDOR));
+    environment += '\n';
+    environment += reinterpret_cast<const char *>(gl->glGetString(GL_RENDERER));
+    environment += '\n';
+    environment += reinterpret_cast<const char *>(gl->glGetString(GL_VERSION));
+    environment += '\n';
+    environment += std::to_string(executable.size()) + ":" + std::to_string(executable.lastModified().toMSecsSinceEpoch());
+    environmentHash = hashData(environment.data(), environment.size());
+}
+
+uint64_t ProgramCache::programKey(const std::vector<const GLchar *> &vertexSources, const std::vector<const GLchar *> &fragmentSources) const {
+    // Stages and sources are separated, so moving text between them changes the key
+    std::string text;
+    for (const GLchar *source : vertexSources) {
+        text += source;
+        text += '\0';
+    }
+    text += '\1';
+    for (const GLchar *source : fragmentSources) {
+        text += source;
+        text += '\0';
+    }
+    return hashData(text.data(), text.size()) ^ environmentHash;
+}
+
+QString ProgramCache::programPath(uint64_t key) const {
+    return QDir(directory).filePath(QString("%1.program").arg(key, 16, 16, QChar('0')));
+}
+
+GLuint ProgramCache::load(uint64_t key) {
+    if (!enabled()) {
+        return 0;
+    }
+
+    QFile file(programPath(key));
+    if (!file.open(QIODevice::ReadOnly)) {
+        ++lastStats.misses;
+        return 0;
+    }
+    QByteArray contents = file.readAll();
+    file.close();
+
+    // Validate format and size before handing binary to driver
+    ProgramCacheHeader header;
+    bool valid = static_cast<size_t>(contents.size()) >= sizeof(header);
+    if (valid) {
+        memcpy(&header, contents.constData(), sizeof(header));
+        const char *binary = contents.constData() + sizeof(header);
+        valid = memcmp(header.magic, programCacheMagic, sizeof(programCacheMagic)) == 0 &&
+                header.version == programCacheVersion && header.key == key &&
+                header.binarySize == static_cast<uint64_t>(contents.size()) - sizeof(header) &&
+                header.binaryHash == hashData(binary, static_cast<size_t>(header.binarySize));
+    }
+
+    GLuint program = 0;
+    if (valid) {
+        program = gl->glCreateProgram();
+        programBinary(program, header.binaryFormat, contents.constData() + sizeof(header), static_cast<GLsizei>(header.binarySize));
+
+        GLint linked = GL_FALSE;
+        gl->glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if (linked != GL_TRUE) {
+            gl->glDeleteProgram(program);
+            program = 0;
+        }
+    }
+
+    if (program == 0) {
+        // Corrupt or from an older driver, compiled again and replaced
+        ++lastStats.rejected;
+        QFile::remove(programPath(key));
+        return 0;
+    }
+
+    ++lastStats.hits;
+    return program;
+}
+
+void ProgramCache::prepare(GLuint program) {
+    if (enabled()) {
+        programParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+}
+
+bool ProgramCache::store(uint64_t key, GLuint program) {
+    if (!enabled()) {
+        return false;
+    }
+
+    GLint length = 0;
+    gl->glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return false;
+    }
+
+    std::vector<char> binary(static_cast<size_t>(length));
+    GLenum binaryFormat = 0;
+    getProgramBinary(program, length, &length, &binaryFormat, binary.data());
+    binary.resize(static_cast<size_t>(length));
+
+    ProgramCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, programCacheMagic, sizeof(programCacheMagic));
+    header.version = programCacheVersion;
+    header.key = key;
+    header.binaryFormat = binaryFormat;
+    header.binarySize = binary.size();
+    header.binaryHash = hashData(binary.data(), binary.size());
+
+    QString path = programPath(key);
+    if (!QDir().mkpath(directory)) {
+        std::cerr << "Program cache directory creation failed! [" << directory.toStdString() << "]" << std::endl;
+        return false;
+    }
+
+    QSaveFile file(path);
+    bool ok = file.open(QIODevice::WriteOnly) &&
+              file.write(reinterpret_cast<const char *>(&header), sizeof(header)) == sizeof(header) &&
+              file.write(binary.data(), static_cast<qint64>(binary.size())) == static_cast<qint64>(binary.size()) &&
+              file.commit();
+
+    if (!ok) {
+        std::cerr << "Program cache writing failed! [" << path.toStdString() << "]" << std::endl;
+        return false;
+    }
+    ++lastStats.written;
+    return true;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <QString>
+#include <QOpenGLFunctions_3_3_Core>
+
+// Linked program binary file (.program), written into cache directory under program key
+// Layout: ProgramCacheHeader, driver specific binary
+const char programCacheMagic[4] = {'F', 'P', 'R', 'G'};
+const uint32_t programCacheVersion = 1;
+
+struct ProgramCacheHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t key; // See ProgramCache::programKey()
+    uint32_t binaryFormat;
+    uint32_t padding;
+    uint64_t binarySize;
+    uint64_t binaryHash;
+};
+
+struct ProgramCacheStats {
+    uint32_t hits = 0;
+    uint32_t misses = 0;
+    uint32_t rejected = 0; // Binaries driver refused to load (eg. after driver update), compiled again
+    uint32_t written = 0;
+};
+
+// Program binaries on disk (ARB_get_program_binary, core in OpenGL 4.1), skipping GLSL compilation on later launches (OpenGL thread only)
+// Keys cover sources, defines, driver vendor, renderer and version strings and executable build, stale binaries are never loaded
+class ProgramCache {
+public:
+    // Disabled if driver can't retrieve program binaries or directory is empty
+    void initialize(QOpenGLFunctions_3_3_Core *gl_, const QString &directory_);
+    bool enabled() const { return supported && !directory.isEmpty(); }
+
+    uint64_t programKey(const std::vector<const GLchar *> &vertexSources, const std::vector<const GLchar *> &fragmentSources) const;
+
+    // New program linked from cached binary, 0 if there is none or driver rejects it (rejected binary is removed)
+    GLuint load(uint64_t key);
+
+    // Mark program before linking, so its binary can be retrieved
+    void prepare(GLuint program);
+
+    // Write binary of linked program (atomically)
+    bool store(uint64_t key, GLuint program);
+
+    const ProgramCacheStats &stats() const { return lastStats; }
+
+private:
+    // Not part of OpenGL 3.3 functions, resolved from context
+    typedef void (QOPENGLF_APIENTRYP GetProgramBinaryFunction)(GLuint program, GLsizei bufSize, GLsizei *length, GLenum *binaryFormat, void *binary);
+    typedef void (QOPENGLF_APIENTRYP ProgramBinaryFunction)(GLuint program, GLenum binaryFormat, const void *binary, GLsizei length);
+    typedef void (QOPENGLF_APIENTRYP ProgramParameteriFunction)(GLuint program, GLenum pname, GLint value);
+
+    QOpenGLFunctions_3_3_Core *gl = nullptr;
+    GetProgramBinaryFunction getProgramBinary = nullptr;
+    ProgramBinaryFunction programBinary = nullptr;
+    ProgramParameteriFunction programParameteri = nullptr;
+    bool supported = false;
+    QString directory;
+    uint64_t environmentHash = 0; // Driver strings and build
+    ProgramCacheStats lastStats;
+
+    QString programPath(uint64_t key) const;
+};
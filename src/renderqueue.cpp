@@ -0,0 +1,147 @@
+#include "renderqueue.h"
+
+#include <algorithm>
+
+#include "vertexformat.h"
+
+uint64_t makeSortKey(GLuint program, GLuint texture, GLuint bumpMap, GLuint VAO, float depth) {
+    // Names are small sequential integers, masking keeps them apart in practice (collisions only cost sorting quality)
+    uint64_t depthBits = static_cast<uint64_t>(std::min(std::max(depth, 0.0f), 1.0f) * 0xFFFF);
+    return (static_cast<uint64_t>(program & 0xFF) << 56) |
+           (static_cast<uint64_t>(texture & 0xFFF) << 44) |
+           (static_cast<uint64_t>(bumpMap & 0xFFF) << 32) |
+           (static_cast<uint64_t>(VAO & 0xFFFF) << 16) |
+           depthBits;
+}
+
+void StateTracker::reset(QOpenGLFunctions_3_3_Core *gl_, RenderStats *stats_) {
+    gl = gl_;
+    stats = stats_;
+    program = activeUnit = VAO = unknown;
+    textures[0] = textures[1] = unknown;
+}
+
+bool StateTracker::changed(GLuint &current, GLuint value) {
+    if (current == value) {
+        ++stats->redundantStateChanges;
+        return false;
+    }
+    current = value;
+    ++stats->stateChanges;
+    ++stats->glCalls;
+    return true;
+}
+
+void StateTracker::useProgram(GLuint program_) {
+    if (changed(program, program_)) {
+        gl->glUseProgram(program_);
+    }
+}
+
+void StateTracker::bindTexture(GLuint unit, GLuint texture) {
+    if (textures[unit] == texture) {
+        ++stats->redundantStateChanges;
+        return;
+    }
+    if (changed(activeUnit, unit)) {
+        gl->glActiveTexture(GL_TEXTURE0 + unit);
+    }
+    changed(textures[unit], texture);
+    gl->glBindTexture(GL_TEXTURE_2D, texture);
+}
+
+void StateTracker::bindVertexArray(GLuint VAO_) {
+    if (changed(VAO, VAO_)) {
+        gl->glBindVertexArray(VAO_);
+    }
+}
+
+void RenderQueue::clear() {
+    items.clear();
+}
+
+void RenderQueue::push(const DrawItem &item) {
+    items.push_back(item);
+}
+
+void RenderQueue::sort() {
+    // LSD radix sort of item indices by key, 8 bits per pass
+    size_t count = items.size();
+    order.resize(count);
+    scratch.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        order[i] = static_cast<uint32_t>(i);
+    }
+
+    for (int shift = 0; shift < 64; shift += 8) {
+        size_t histogram[256] = {};
+        for (size_t i = 0; i < count; ++i) {
+            ++histogram[(items[i].key >> shift) & 0xFF];
+        }
+
+        // All keys share this byte (common for high bits), pass would not change order
+        if (histogram[(items[0].key >> shift) & 0xFF] == count) {
+            continue;
+        }
+
+        size_t offset = 0;
+        for (auto &bucket : histogram) {
+            size_t size = bucket;
+            bucket = offset;
+            offset += size;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            uint32_t index = order[i];
+            scratch[histogram[(items[index].key >> shift) & 0xFF]++] = index;
+        }
+        order.swap(scratch);
+    }
+}
+
+void RenderQueue::submit(QOpenGLFunctions_3_3_Core *gl, UniformBuffers &uniformBuffers, Profiler *profiler) {
+    lastStats = RenderStats();
+    if (items.empty()) {
+        return;
+    }
+
+    sort();
+    state.reset(gl, &lastStats);
+    const char *group = nullptr;
+    for (uint32_t index : order) {
+        const DrawItem &item = items[index];
+
+        if (profiler != nullptr && item.group != group) {
+            if (group != nullptr) {
+                profiler->endScope();
+            }
+            group = item.group;
+            profiler->beginScope(group);
+        }
+
+        state.useProgram(item.program);
+        state.bindTexture(0, item.texture);
+        state.bindTexture(1, item.bumpMap);
+        state.bindVertexArray(item.VAO);
+
+        // Uniform range differs for every object
+        uniformBuffers.bindObject(item.uniformIndex);
+        // Meshes share buffers, indices are relative to mesh's base vertex
+        const void *indices = reinterpret_cast<const void *>(item.firstIndex * indexTypeSize(item.indexType));
+        if (item.instanceCount > 0) {
+            gl->glDrawElementsInstancedBaseVertex(GL_TRIANGLES, item.indexCount, item.indexType, indices, item.instanceCount, item.baseVertex);
+        } else {
+            gl->glDrawElementsBaseVertex(GL_TRIANGLES, item.indexCount, item.indexType, indices, item.baseVertex);
+        }
+        lastStats.glCalls += 2;
+        ++lastStats.drawCalls;
+        lastStats.triangles += static_cast<uint64_t>(item.indexCount / 3) * static_cast<uint64_t>(std::max(item.instanceCount, 1));
+    }
+    if (group != nullptr) {
+        profiler->endScope();
+    }
+
+#ifdef QT_DEBUG
+    // Unbind to avoid accidental modification
+    gl->glBindVertexArray(0);
+#endif
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <QOpenGLFunctions_3_3_Core>
+
+#include "uniforms.h"
+#include "profiler.h"
+
+// Single draw of a frame
+struct DrawItem {
+    uint64_t key; // See makeSortKey()
+    GLuint program;
+    GLuint texture;
+    GLuint bumpMap;
+    GLuint VAO;
+    GLuint firstIndex; // Mesh range in mesh buffer (indices of index type)
+    GLenum indexType;
+    GLint baseVertex;
+    GLsizei indexCount;
+    GLsizei instanceCount; // 0 - not instanced
+    uint32_t uniformIndex; // Object uniforms index in uniform buffers
+    const char *group; // Profiler scope of draw (string literal)
+};
+
+// GL calls issued by render queue in last frame
+struct RenderStats {
+    uint32_t drawCalls = 0;
+    uint64_t triangles = 0; // Submitted, all instances
+    uint32_t glCalls = 0; // All calls, including draw calls
+    uint32_t stateChanges = 0; // Binds issued
+    uint32_t redundantStateChanges = 0; // Binds skipped, state was already in effect
+};
+
+// Sort key, most significant first: program (8 bits), texture (12), bump map (12), VAO (16), depth (16)
+// Items sharing the most expensive state end up next to each other, equal state is drawn front to back
+uint64_t makeSortKey(GLuint program, GLuint texture, GLuint bumpMap, GLuint VAO, float depth /* 0 - 1 */);
+
+// Caches bound OpenGL state and skips binds that are already in effect (OpenGL thread only)
+class StateTracker {
+public:
+    // Forget cached state, anything may have been bound outside tracker
+    void reset(QOpenGLFunctions_3_3_Core *gl_, RenderStats *stats_);
+
+    void useProgram(GLuint program);
+    void bindTexture(GLuint unit, GLuint texture); // GL_TEXTURE_2D on texture unit (0 or 1)
+    void bindVertexArray(GLuint VAO);
+
+private:
+    static const GLuint unknown = ~0u;
+
+    QOpenGLFunctions_3_3_Core *gl = nullptr;
+    RenderStats *stats = nullptr;
+
+    GLuint program = unknown;
+    GLuint activeUnit = unknown;
+    GLuint textures[2] = {unknown, unknown};
+    GLuint VAO = unknown;
+
+    bool changed(GLuint &current, GLuint value);
+};
+
+// Collects draws of a frame, sorts them by state and submits them with redundant state changes removed
+class RenderQueue {
+public:
+    void clear();
+    void push(const DrawItem &item);
+
+    // Sort and draw all items, per-object uniforms must already be uploaded
+    // Consecutive items of the same group are timed as one profiler scope (if profiler is given)
+    void submit(QOpenGLFunctions_3_3_Core *gl, UniformBuffers &uniformBuffers, Profiler *profiler = nullptr);
+
+    const RenderStats &stats() const { return lastStats; }
+
+private:
+    std::vector<DrawItem> items;
+    std::vector<uint32_t> order; // Sorted item indices
+    std::vector<uint32_t> scratch;
+    StateTracker state;
+    RenderStats lastStats;
+
+    void sort();
+};
@@ -0,0 +1,192 @@
+#include "scene.h"
+
+#include <glm/ext.hpp>
+
+const size_t Scene::npos;
+const uint32_t Scene::noSlot;
+
+glm::mat4 modelMatrix(const glm::vec3 &translation, const glm::vec3 &rotation, const glm::vec3 &scale) {
+    glm::mat4 M = glm::mat4(1);
+    M = glm::translate(M, translation);
+    M = glm::rotate(M, rotation.x, glm::vec3(1, 0, 0));
+    M = glm::rotate(M, rotation.y, glm::vec3(0, 0, 1));
+    M = glm::rotate(M, rotation.z, glm::vec3(0, 1, 0));
+    M = glm::scale(M, scale);
+    return M;
+}
+
+ObjectHandle Scene::add(MeshObject object, const Transform &transform, const Material &material) {
+    // Reuse a free slot (its generation was advanced on removal)
+    uint32_t slot = freeSlot;
+    if (slot != noSlot) {
+        freeSlot = slots[slot].index;
+    } else {
+        slot = static_cast<uint32_t>(slots.size());
+        slots.emplace_back();
+    }
+    slots[slot].index = static_cast<uint32_t>(objects.size());
+    ObjectHandle handle(slot, slots[slot].generation);
+
+    transforms.translation.push_back(transform.translation);
+    transforms.rotation.push_back(transform.rotation);
+    transforms.scale.push_back(transform.scale);
+    transforms.changed.push_back(1);
+    transforms.boundsMin.push_back(glm::vec3(0.0f));
+    transforms.boundsMax.push_back(glm::vec3(0.0f));
+    transforms.M.push_back(glm::mat4(1));
+    transforms.normalMatrix.push_back(glm::mat4(1));
+    transforms.worldBounds.push(glm::vec3(0.0f), glm::vec3(0.0f));
+    materials.push_back(material);
+    render.textureMappingType.push_back(0);
+    render.textureMappingAxis.push_back(0);
+    render.boundingBoxMin.push_back(glm::vec3(0.0f));
+    render.boundingBoxMax.push_back(glm::vec3(0.0f));
+    render.VAO.push_back(0);
+    render.texture.push_back(0);
+    render.bumpMap.push_back(0);
+    render.range.push_back(MeshRange());
+    render.levels.push_back(nullptr);
+    render.level.push_back(0);
+    render.instanceCount.push_back(0);
+    objects.push_back(std::move(object));
+    handles.push_back(handle);
+    return handle;
+}
+
+bool Scene::remove(ObjectHandle handle) {
+    size_t removed = index(handle);
+    if (removed == npos) {
+        return false;
+    }
+
+    // Last object moves into the hole, its slot follows it
+    size_t last = objects.size() - 1;
+    if (removed != last) {
+        transforms.translation[removed] = transforms.translation[last];
+        transforms.rotation[removed] = transforms.rotation[last];
+        transforms.scale[removed] = transforms.scale[last];
+        transforms.changed[removed] = transforms.changed[last];
+        transforms.boundsMin[removed] = transforms.boundsMin[last];
+        transforms.boundsMax[removed] = transforms.boundsMax[last];
+        transforms.M[removed] = transforms.M[last];
+        transforms.normalMatrix[removed] = transforms.normalMatrix[last];
+        materials[removed] = materials[last];
+        render.textureMappingType[removed] = render.textureMappingType[last];
+        render.textureMappingAxis[removed] = render.textureMappingAxis[last];
+        render.boundingBoxMin[removed] = render.boundingBoxMin[last];
+        render.boundingBoxMax[removed] = render.boundingBoxMax[last];
+        render.VAO[removed] = render.VAO[last];
+        render.texture[removed] = render.texture[last];
+        render.bumpMap[removed] = render.bumpMap[last];
+        render.range[removed] = render.range[last];
+        render.levels[removed] = render.levels[last];
+        render.level[removed] = render.level[last];
+        render.instanceCount[removed] = render.instanceCount[last];
+        objects[removed] = std::move(objects[last]);
+        handles[removed] = handles[last];
+        slots[handles[removed].index].index = static_cast<uint32_t>(removed);
+    }
+    transforms.worldBounds.swapRemove(removed);
+
+    transforms.translation.pop_back();
+    transforms.rotation.pop_back();
+    transforms.scale.pop_back();
+    transforms.changed.pop_back();
+    transforms.boundsMin.pop_back();
+    transforms.boundsMax.pop_back();
+    transforms.M.pop_back();
+    transforms.normalMatrix.pop_back();
+    materials.pop_back();
+    render.textureMappingType.pop_back();
+    render.textureMappingAxis.pop_back();
+    render.boundingBoxMin.pop_back();
+    render.boundingBoxMax.pop_back();
+    render.VAO.pop_back();
+    render.texture.pop_back();
+    render.bumpMap.pop_back();
+    render.range.pop_back();
+    render.levels.pop_back();
+    render.level.pop_back();
+    render.instanceCount.pop_back();
+    objects.pop_back();
+    handles.pop_back();
+
+    // Stale handles of this slot never match again (generation 0 is skipped, it marks null handles)
+    Slot &slot = slots[handle.index];
+    if (++slot.generation == 0) {
+        slot.generation = 1;
+    }
+    slot.index = freeSlot;
+    freeSlot = handle.index;
+    return true;
+}
+
+void Scene::clear() {
+    // Slots are kept with advanced generations, so old handles stay stale
+    while (!handles.empty()) {
+        remove(handles.back());
+    }
+}
+
+size_t Scene::index(ObjectHandle handle) const {
+    if (handle.index >= slots.size() || slots[handle.index].generation != handle.generation) {
+        return npos;
+    }
+    // Free slots have an advanced generation, only live slots match
+    return slots[handle.index].index;
+}
+
+MeshObject *Scene::find(ObjectHandle handle) {
+    size_t i = index(handle);
+    return i != npos ? &objects[i] : nullptr;
+}
+
+Material *Scene::material(ObjectHandle handle) {
+    size_t i = index(handle);
+    return i != npos ? &materials[i] : nullptr;
+}
+
+Transform Scene::transform(ObjectHandle handle) const {
+    Transform transform;
+    size_t i = index(handle);
+    if (i != npos) {
+        transform.translation = transforms.translation[i];
+        transform.rotation = transforms.rotation[i];
+        transform.scale = transforms.scale[i];
+    }
+    return transform;
+}
+
+void Scene::setTransform(ObjectHandle handle, const Transform &transform) {
+    size_t i = index(handle);
+    if (i != npos) {
+        transforms.translation[i] = transform.translation;
+        transforms.rotation[i] = transform.rotation;
+        transforms.scale[i] = transform.scale;
+        transforms.changed[i] = 1;
+    }
+}
+
+void Scene::setBounds(ObjectHandle handle, const glm::vec3 &boundsMin, const glm::vec3 &boundsMax) {
+    size_t i = index(handle);
+    if (i != npos) {
+        transforms.boundsMin[i] = boundsMin;
+        transforms.boundsMax[i] = boundsMax;
+        transforms.changed[i] = 1;
+    }
+}
+
+void Scene::updateTransforms() {
+    for (size_t i = 0; i < transforms.changed.size(); ++i) {
+        if (!transforms.changed[i]) {
+            continue;
+        }
+
+        transforms.M[i] = modelMatrix(transforms.translation[i], transforms.rotation[i], transforms.scale[i]);
+        transforms.normalMatrix[i] = glm::mat4(glm::transpose(glm::inverse(glm::mat3(transforms.M[i])))); // Shaders only use upper 3x3
+        glm::vec3 center, extent;
+        transformBounds(transforms.M[i], transforms.boundsMin[i], transforms.boundsMax[i], center, extent);
+        transforms.worldBounds.set(i, center, extent);
+        transforms.changed[i] = 0;
+    }
+}
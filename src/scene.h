@@ -0,0 +1,197 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <QString>
+#include <QImage>
+#include <QOpenGLFunctions_3_3_Core>
+
+#include <glm/glm.hpp>
+
+#include "mesh.h"
+#include "lod.h"
+#include "meshcache.h"
+#include "meshbuffer.h"
+#include "assetcache.h"
+#include "culling.h"
+
+struct Material {
+    glm::vec3 ambientColor = glm::vec3(0.1f);
+    glm::vec3 diffuseColor = glm::vec3(0.5f);
+    glm::vec3 specularColor = glm::vec3(1.0f);
+    float specularPower = 10.0f; // Shininess factor
+};
+
+// Model matrix (object movement)
+glm::mat4 modelMatrix(const glm::vec3 &translation, const glm::vec3 &rotation, const glm::vec3 &scale);
+
+struct Transform {
+    glm::vec3 translation = glm::vec3(0.0f);
+    glm::vec3 rotation = glm::vec3(0.0f);
+    glm::vec3 scale = glm::vec3(1.0f);
+
+    glm::mat4 modelMatrix() const { return ::modelMatrix(translation, rotation, scale); }
+};
+
+struct Object : Transform {
+    QString name;
+    bool transformChanged = true; // Set when translation, rotation or scale changes
+
+    Object(QString name_)
+        : name(name_) {}
+};
+
+// Mesh and textures of an object with what loading and changes need, per-frame render data, transform and material are kept by scene in own arrays (see Scene)
+struct MeshObject {
+    QString name;
+
+    std::vector<Vertex> vertices;
+    std::vector<GLuint> indices;
+    std::shared_ptr<MappedMesh> mappedMesh; // Mesh cache mapped in place of vertices and indices
+    std::vector<GLuint> levelIndices; // Levels of detail beyond original, empty if mesh has none
+    std::vector<MeshLevel> levels;
+
+    // Chosen texture mapping (drawn one is in RenderArrays)
+    GLuint textureMappingType = 0; // 0 - Simple, 1 - Planar, 2 - Cylindrical, 3 - Spherical
+    GLuint textureMappingAxis = 0; // 0 - X, 1 - Y, 2 - Z
+
+    // Buffers (shared through asset cache, placeholder textures are used until uploaded)
+    QString meshKey; // Asset keys, empty - not shared
+    QString textureKey;
+    QString bumpMapKey;
+    std::shared_ptr<GpuMesh> mesh;
+    std::shared_ptr<GpuMesh> sourceMesh; // Mesh without baked mapping UVs while mesh has them (nullptr otherwise)
+    std::shared_ptr<GpuTexture> texture;
+    std::shared_ptr<GpuTexture> bumpMap;
+    GLuint instanceVAO = 0; // Own Vertex Array Object of mesh buffer and instance buffer (instanced only)
+    GLuint instanceVBO = 0; // Per-instance attributes (instanced only)
+    uint32_t instanceVAOGeneration = 0; // Mesh buffer generation own VAO was set up with
+
+    // Instancing (mesh is drawn once per instance if not empty)
+    std::vector<InstanceData> instances;
+
+    // Helpers
+    QImage textureImage;
+    QImage bumpMapImage;
+    std::vector<QImage> textureMipmaps; // Levels from 1 down, released once uploaded
+    std::vector<QImage> bumpMapMipmaps;
+
+    MeshObject(QString name_)
+        : name(name_), vertices({}), indices({}) {}
+    MeshObject(QString name_, std::vector<Vertex> vertices_, std::vector<GLuint> indices_)
+        : name(name_), vertices(vertices_), indices(indices_) {}
+
+    // Mesh data from vectors or mapped mesh cache (released once uploaded)
+    const Vertex *vertexData() const { return mappedMesh ? mappedMesh->vertices() : vertices.data(); }
+    size_t vertexCount() const { return mappedMesh ? mappedMesh->vertexCount() : vertices.size(); }
+    const GLuint *indexData() const { return mappedMesh ? mappedMesh->indices() : indices.data(); }
+    size_t indexCount() const { return mappedMesh ? mappedMesh->indexCount() : indices.size(); }
+};
+
+struct LightObject : Object {
+    // position = MeshObject.translation
+    // power = MeshObject.scale
+    glm::vec3 color = glm::vec3(1.0f);
+
+    LightObject()
+        : Object("") {}
+
+    LightObject(QString name_)
+        : Object(name_) {}
+
+    LightObject(QString name_, glm::vec3 position_ = {0.0f, 0.0f, 0.0f}, float power_ = 40.0f)
+        : Object(name_) {
+        translation = position_;
+        scale = glm::vec3(power_);
+    }
+};
+
+// Generational handle of a scene object (slot and its generation), generation 0 is never used (null handle)
+// Handle stays valid until its object is removed, later objects in the same slot get a new generation
+struct ObjectHandle {
+    uint32_t index = 0;
+    uint32_t generation = 0;
+
+    ObjectHandle() {}
+    ObjectHandle(uint32_t index_, uint32_t generation_)
+        : index(index_), generation(generation_) {}
+
+    bool isNull() const { return generation == 0; }
+    bool operator==(const ObjectHandle &other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const ObjectHandle &other) const { return !(*this == other); }
+
+    // Single value for UI item data and decode requests
+    uint64_t packed() const { return (static_cast<uint64_t>(generation) << 32) | index; }
+    static ObjectHandle unpack(uint64_t packed) { return ObjectHandle(static_cast<uint32_t>(packed), static_cast<uint32_t>(packed >> 32)); }
+};
+
+// Transforms of all objects in structure of arrays layout, passes stream over only the arrays they need
+struct TransformArrays {
+    std::vector<glm::vec3> translation;
+    std::vector<glm::vec3> rotation;
+    std::vector<glm::vec3> scale;
+    std::vector<uint8_t> changed; // Set when translation, rotation, scale or bounds change
+    std::vector<glm::vec3> boundsMin; // Local space, all instances
+    std::vector<glm::vec3> boundsMax;
+    std::vector<glm::mat4> M; // Model matrix (updated when transform changes)
+    std::vector<glm::mat4> normalMatrix; // Inverse transpose of model matrix (updated with it)
+    CullingBounds worldBounds; // World space (updated with model matrix)
+};
+
+// What drawing reads every frame in structure of arrays layout, taken from objects on changes (see WidgetOpenGLDraw::updateRenderData())
+struct RenderArrays {
+    std::vector<GLuint> textureMappingType; // Drawn mapping, simple if mesh has baked mapping UVs
+    std::vector<GLuint> textureMappingAxis;
+    std::vector<glm::vec3> boundingBoxMin; // Local space, of mesh (not instances)
+    std::vector<glm::vec3> boundingBoxMax;
+    std::vector<GLuint> VAO; // Mesh buffer's or object's own if instanced
+    std::vector<GLuint> texture; // 0 - not uploaded yet (placeholder is drawn)
+    std::vector<GLuint> bumpMap;
+    std::vector<MeshRange> range; // Of drawn mesh in mesh buffer (taken again when mesh buffer is replaced)
+    std::vector<const std::vector<MeshLevel> *> levels; // Of drawn mesh (kept alive by object), nullptr until buffers are generated
+    std::vector<uint32_t> level; // Level of detail drawn in last frame
+    std::vector<GLsizei> instanceCount; // 0 - not instanced
+};
+
+// Scene objects in dense arrays indexed alike: transforms, materials, render data and objects
+// Removal moves last object into the hole, so adding and removing are O(1) and arrays stay contiguous
+// Handles (slot map) stay valid through both, dense indices only until next add or remove
+class Scene {
+public:
+    TransformArrays transforms;
+    std::vector<Material> materials;
+    RenderArrays render;
+    std::vector<MeshObject> objects;
+
+    ObjectHandle add(MeshObject object, const Transform &transform = Transform(), const Material &material = Material()); // Appended (last dense index)
+    bool remove(ObjectHandle handle); // False if handle is stale
+    void clear(); // All handles become stale
+    size_t size() const { return objects.size(); }
+
+    bool contains(ObjectHandle handle) const { return index(handle) != npos; }
+    size_t index(ObjectHandle handle) const; // Dense index, npos if handle is stale
+    ObjectHandle handle(size_t index) const { return handles[index]; }
+    MeshObject *find(ObjectHandle handle); // Nullptr if handle is stale
+    Material *material(ObjectHandle handle);
+
+    Transform transform(ObjectHandle handle) const;
+    void setTransform(ObjectHandle handle, const Transform &transform);
+    void setBounds(ObjectHandle handle, const glm::vec3 &boundsMin, const glm::vec3 &boundsMax);
+
+    // Model and normal matrices and world bounds of objects whose transform or bounds changed
+    void updateTransforms();
+
+    static const size_t npos = ~static_cast<size_t>(0);
+
+private:
+    struct Slot {
+        uint32_t generation = 1;
+        uint32_t index = 0; // Dense index while live, next free slot while free
+    };
+    std::vector<Slot> slots;
+    std::vector<ObjectHandle> handles; // Of dense index
+    uint32_t freeSlot = noSlot; // Head of free slot list
+    static const uint32_t noSlot = ~0u;
+};
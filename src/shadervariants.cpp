@@ -0,0 +1,67 @@
+#include "shadervariants.h"
+
+#include <QElapsedTimer>
+
+uint32_t ShaderVariant::key() const {
+    return (textureMappingType & 0x3) |
+           ((textureMappingAxis & 0x3) << 2) |
+           (static_cast<uint32_t>(texture) << 4) |
+           (static_cast<uint32_t>(bumpMap) << 5) |
+           (static_cast<uint32_t>(deferred) << 6) |
+           (static_cast<uint32_t>(bumpFromHeight) << 7);
+}
+
+std::string ShaderVariant::defines() const {
+    // Constants fold mapping branches away, texture coordinates are not computed if nothing samples them
+    return "#define MAPPING_TYPE uint(" + std::to_string(textureMappingType) + ")\n" +
+           "#define MAPPING_AXIS uint(" + std::to_string(textureMappingAxis) + ")\n" +
+           "#define HAS_TEXTURE " + (texture ? "1" : "0") + "\n" +
+           "#define HAS_BUMP_MAP " + (bumpMap ? "1" : "0") + "\n" +
+           "#define BUMP_FROM_HEIGHT " + (bumpFromHeight ? "1" : "0") + "\n";
+}
+
+void ShaderVariants::initialize(QOpenGLFunctions_3_3_Core *gl_, CompileFunction compile_) {
+    gl = gl_;
+    compile = compile_;
+}
+
+void ShaderVariants::destroy() {
+    if (gl == nullptr) {
+        return;
+    }
+    for (const auto &program : programs) {
+        gl->glDeleteProgram(program.second);
+    }
+    programs.clear();
+    frameUse.clear();
+    lastStats = ShaderVariantStats();
+    gl = nullptr;
+}
+
+GLuint ShaderVariants::program(const ShaderVariant &variant) {
+    uint32_t key = variant.key();
+    uint32_t &lastUse = frameUse[key];
+    if (lastUse != frame) {
+        lastUse = frame;
+        ++lastStats.used;
+    }
+
+    auto found = programs.find(key);
+    if (found != programs.end()) {
+        return found->second;
+    }
+
+    // Failed compilations are cached too (program 0), not retried every frame
+    QElapsedTimer timer;
+    timer.start();
+    GLuint program = compile(variant);
+    lastStats.compileTime += timer.nsecsElapsed() / 1e6;
+    programs[key] = program;
+    lastStats.live += program != 0;
+    return program;
+}
+
+void ShaderVariants::beginFrame() {
+    ++frame;
+    lastStats.used = 0;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+
+#include <QOpenGLFunctions_3_3_Core>
+
+// Mesh shader specialization, compiled with #defines in place of uniform branches and unused texture work
+struct ShaderVariant {
+    GLuint textureMappingType = 0; // See MeshObject
+    GLuint textureMappingAxis = 0;
+    bool texture = true; // Texture is sampled (otherwise white)
+    bool bumpMap = true; // Bump mapped normal (otherwise interpolated normal)
+    bool bumpFromHeight = false; // Bump mapping from height derivatives of each fragment (otherwise normal map)
+    bool deferred = false; // Geometry pass of deferred shading (otherwise forward shading)
+
+    uint32_t key() const;
+    std::string defines() const; // Inserted after #version, see vertexShaderSource and surfaceShaderSource
+};
+
+struct ShaderVariantStats {
+    uint32_t live = 0; // Compiled programs
+    uint32_t used = 0; // Distinct programs drawn with in last frame
+    double compileTime = 0.0; // CPU milliseconds, all variants
+};
+
+// Lazily compiled and cached variants of mesh programs (OpenGL thread only)
+class ShaderVariants {
+public:
+    // Compiles and links program of variant, 0 on failure
+    typedef std::function<GLuint(const ShaderVariant &variant)> CompileFunction;
+
+    void initialize(QOpenGLFunctions_3_3_Core *gl_, CompileFunction compile_);
+    void destroy();
+
+    // Program of variant, compiled on first use
+    GLuint program(const ShaderVariant &variant);
+
+    // Count distinct variants drawn with from beginFrame() on
+    void beginFrame();
+
+    const ShaderVariantStats &stats() const { return lastStats; }
+
+private:
+    QOpenGLFunctions_3_3_Core *gl = nullptr;
+    CompileFunction compile;
+    std::unordered_map<uint32_t, GLuint> programs; // By key
+    std::unordered_map<uint32_t, uint32_t> frameUse; // Key - frame last used in
+    uint32_t frame = 1;
+    ShaderVariantStats lastStats;
+};
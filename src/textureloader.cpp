@@ -0,0 +1,138 @@
+#include "textureloader.h"
+
+#include <iostream>
+#include <iterator>
+#include <cstring>
+
+#include <QRunnable>
+
+#include "mipmap.h"
+#include "normalmap.h"
+
+class TextureDecodeTask : public QRunnable {
+public:
+    TextureDecodeTask(TextureLoader *loader_, DecodedTexture texture_, bool mipmaps_, float bumpStrength_)
+        : loader(loader_), texture(texture_), mipmaps(mipmaps_), bumpStrength(bumpStrength_) {}
+
+    void run() override {
+        std::vector<QImage> *levels = mipmaps ? &texture.mipmaps : nullptr;
+        bool decoded = texture.slot == TEXTURE_SLOT_BUMP_MAP ? TextureLoader::decodeBumpMap(texture.path, bumpStrength, texture.image, levels)
+                                                             : TextureLoader::decode(texture.path, texture.image, levels);
+        if (decoded) {
+            loader->taskDone(texture);
+        }
+    }
+
+private:
+    TextureLoader *loader;
+    DecodedTexture texture;
+    bool mipmaps;
+    float bumpStrength;
+};
+
+TextureLoader::TextureLoader(QObject *parent) : QObject(parent) {}
+
+TextureLoader::~TextureLoader() {
+    pool.waitForDone();
+}
+
+void TextureLoader::load(const QString &path, const QString &key, uint64_t objectHandle, TextureSlot slot, GLuint mappingType, GLuint mappingAxis) {
+    DecodedTexture texture;
+    texture.path = path;
+    texture.key = key;
+    texture.objectHandle = objectHandle;
+    texture.slot = slot;
+    texture.mappingType = mappingType;
+    texture.mappingAxis = mappingAxis;
+
+    pool.start(new TextureDecodeTask(this, texture, cpuMipmaps, bumpStrength));
+}
+
+std::vector<DecodedTexture> TextureLoader::takeDecoded() {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<DecodedTexture> textures(std::make_move_iterator(decoded.begin()), std::make_move_iterator(decoded.end()));
+    decoded.clear();
+    return textures;
+}
+
+bool TextureLoader::decode(const QString &path, QImage &image, std::vector<QImage> *mipmaps) {
+    QImage img;
+    if (!img.load(path)) {
+        std::cerr << "Texture image loading failed! [" << path.toStdString() << "]" << std::endl;
+        return false;
+    }
+
+    image = img.convertToFormat(QImage::Format_ARGB32);
+    if (mipmaps != nullptr) {
+        *mipmaps = generateMipmaps(image);
+    }
+    return true;
+}
+
+bool TextureLoader::decodeBumpMap(const QString &path, float strength, QImage &image, std::vector<QImage> *mipmaps) {
+    QImage heightMap;
+    if (!decode(path, heightMap)) {
+        return false;
+    }
+
+    // Converted once here, fragments fetch the normal instead of differentiating heights
+    image = heightToNormalMap(heightMap, strength);
+    if (mipmaps != nullptr) {
+        *mipmaps = generateMipmaps(image);
+    }
+    return true;
+}
+
+void TextureLoader::taskDone(DecodedTexture &texture) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        decoded.push_back(std::move(texture));
+    }
+
+    // Emitted from worker thread, delivered queued to receivers on the GUI thread
+    emit texturesReady();
+}
+
+void PixelUploadRing::initialize(QOpenGLFunctions_3_3_Core *gl_, uint32_t count) {
+    gl = gl_;
+    buffers.resize(count);
+    for (auto &buffer : buffers) {
+        gl->glGenBuffers(1, &buffer.PBO);
+    }
+}
+
+void PixelUploadRing::destroy() {
+    for (auto &buffer : buffers) {
+        gl->glDeleteBuffers(1, &buffer.PBO);
+    }
+    buffers.clear();
+}
+
+void PixelUploadRing::upload(GLint level, GLsizei width, GLsizei height, const void *pixels) {
+    Buffer &buffer = buffers[next];
+    next = (next + 1) % buffers.size();
+
+    GLsizeiptr size = static_cast<GLsizeiptr>(width) * height * 4;
+    gl->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer.PBO);
+    if (size > buffer.size) {
+        gl->glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+        buffer.size = size;
+    }
+
+    // Invalidating orphans storage of a pending transfer (no wait, mip chains are longer than the ring)
+    void *mapped = gl->glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (mapped != nullptr) {
+        memcpy(mapped, pixels, static_cast<size_t>(size));
+        gl->glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+        // Source is the bound pixel unpack buffer, pixels pointer is an offset into it
+        gl->glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, width, height, GL_BGRA, GL_UNSIGNED_BYTE, nullptr);
+    } else {
+        // Mapping failed, fall back to upload from client memory
+        std::cerr << "Pixel buffer mapping failed, uploading texture directly" << std::endl;
+        gl->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        gl->glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, width, height, GL_BGRA, GL_UNSIGNED_BYTE, pixels);
+    }
+
+    gl->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include <QObject>
+#include <QThreadPool>
+#include <QImage>
+#include <QOpenGLFunctions_3_3_Core>
+
+// GL_EXT_texture_filter_anisotropic (core only since OpenGL 4.6)
+#ifndef GL_TEXTURE_MAX_ANISOTROPY_EXT
+#define GL_TEXTURE_MAX_ANISOTROPY_EXT 0x84FE
+#endif
+#ifndef GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT
+#define GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT 0x84FF
+#endif
+
+enum TextureSlot : uint32_t {
+    TEXTURE_SLOT_TEXTURE = 0,
+    TEXTURE_SLOT_BUMP_MAP = 1
+};
+
+struct DecodedTexture {
+    QString path;
+    QString key; // Asset key (shared once uploaded)
+    uint64_t objectHandle; // ObjectHandle::packed() of mesh object
+    TextureSlot slot;
+    GLuint mappingType; // Texture slot only
+    GLuint mappingAxis;
+    QImage image; // Format_ARGB32 (bump maps converted to normal maps, see heightToNormalMap())
+    std::vector<QImage> mipmaps; // Levels from 1 down, empty if not generated on CPU
+};
+
+// Decodes (and converts) texture images on a worker thread pool
+// Decoded images are queued for the GUI (OpenGL) thread, which takes them when texturesReady() is emitted
+class TextureLoader : public QObject {
+    Q_OBJECT
+public:
+    explicit TextureLoader(QObject *parent = nullptr);
+    ~TextureLoader() override;
+
+    bool cpuMipmaps = true; // Generate mip chains on decoding threads (glGenerateMipmap is used on upload otherwise)
+    float bumpStrength = 1.0f; // Slope scale of bump map heights converted to normal maps (1 - as derivative bump mapping at a texel per pixel)
+
+    void load(const QString &path, const QString &key, uint64_t objectHandle, TextureSlot slot, GLuint mappingType = 0, GLuint mappingAxis = 0);
+
+    // Take all textures decoded so far
+    std::vector<DecodedTexture> takeDecoded();
+
+    // Decode synchronously (used by workers and preloading), mip chain is generated if mipmaps is given
+    static bool decode(const QString &path, QImage &image /* out */, std::vector<QImage> *mipmaps = nullptr /* out */);
+    // Decode height map and convert it to normal map of given strength, mip chain is of normal map
+    static bool decodeBumpMap(const QString &path, float strength, QImage &image /* out */, std::vector<QImage> *mipmaps = nullptr /* out */);
+
+signals:
+    void texturesReady();
+
+private:
+    friend class TextureDecodeTask;
+
+    QThreadPool pool;
+
+    std::mutex mutex;
+    std::deque<DecodedTexture> decoded;
+
+    void taskDone(DecodedTexture &texture);
+};
+
+// Ring of pixel buffer objects for streaming texture uploads (OpenGL thread only)
+// Pixels are copied into the next buffer in ring, texture is then filled from the buffer without a client memory copy
+// Buffers are orphaned on map (invalidated), a buffer still being transferred from gets new storage instead of stalling upload
+class PixelUploadRing {
+public:
+    void initialize(QOpenGLFunctions_3_3_Core *gl_, uint32_t count = 3);
+    void destroy();
+
+    // Upload BGRA pixels into a level of the currently bound GL_TEXTURE_2D (storage must already be allocated)
+    void upload(GLint level, GLsizei width, GLsizei height, const void *pixels);
+
+private:
+    struct Buffer {
+        GLuint PBO = 0;
+        GLsizeiptr size = 0;
+    };
+
+    QOpenGLFunctions_3_3_Core *gl = nullptr;
+    std::vector<Buffer> buffers;
+    uint32_t next = 0;
+};
@@ -0,0 +1,199 @@
+#include "texturemapping.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "parallel.h"
+
+namespace {
+
+// Fewer vertices per band are not worth a pool task
+const size_t bandVertices = 64 * 1024;
+
+const float pi = 3.14159265f;
+const float halfPi = 1.57079633f;
+const float inverseTwoPi = 0.15915494f;
+const float inversePi = 0.31830989f;
+
+// Arctangent polynomial on [0, 1] (Abramowitz and Stegun 4.4.49), error below 1e-5
+const float atanA1 = 0.9998660f;
+const float atanA3 = -0.3302995f;
+const float atanA5 = 0.1801410f;
+const float atanA7 = -0.0851330f;
+const float atanA9 = 0.0208351f;
+
+// Mapping parameters of mesh, components of positions to read per axis
+struct MappingSetup {
+    GLuint type;
+    glm::vec3 boundingBoxMin;
+    glm::vec3 center;
+    glm::vec3 scale; // 1 / size, 0 on flat axes
+    int u, v; // Planar: components mapped to U and V
+    int p, q, r; // Angular: angle is atan(p, q), r runs along axis
+};
+
+MappingSetup mappingSetup(GLuint type, GLuint axis, glm::vec3 boundingBoxMin, glm::vec3 boundingBoxMax) {
+    MappingSetup setup;
+    setup.type = type;
+    setup.boundingBoxMin = boundingBoxMin;
+    glm::vec3 size = boundingBoxMax - boundingBoxMin;
+    setup.center = boundingBoxMin + size / 2.0f;
+    setup.scale = glm::vec3(size.x > 0.0f ? 1.0f / size.x : 0.0f, size.y > 0.0f ? 1.0f / size.y : 0.0f, size.z > 0.0f ? 1.0f / size.z : 0.0f);
+
+    // Same axes as vertex shader
+    const int planar[3][2] = {{2, 1}, {0, 2}, {0, 1}};
+    const int angular[3][3] = {{1, 2, 0}, {2, 0, 1}, {1, 0, 2}};
+    axis = std::min<GLuint>(axis, 2);
+    setup.u = planar[axis][0];
+    setup.v = planar[axis][1];
+    setup.p = angular[axis][0];
+    setup.q = angular[axis][1];
+    setup.r = angular[axis][2];
+    return setup;
+}
+
+float atan2Approx(float y, float x) {
+    float ax = std::abs(x), ay = std::abs(y);
+    float mx = std::max(ax, ay), mn = std::min(ax, ay);
+    float t = mn / std::max(mx, FLT_MIN);
+    float s = t * t;
+    float angle = t * (atanA1 + s * (atanA3 + s * (atanA5 + s * (atanA7 + s * atanA9))));
+    if (ay > ax) angle = halfPi - angle;
+    if (x < 0.0f) angle = pi - angle;
+    return y < 0.0f ? -angle : angle;
+}
+
+glm::vec2 mapPosition(const MappingSetup &setup, const glm::vec3 &position) {
+    if (setup.type == textureMappingPlanar) {
+        glm::vec3 normalized = (position - setup.boundingBoxMin) * setup.scale;
+        return glm::vec2(normalized[setup.u], normalized[setup.v]);
+    }
+
+    glm::vec3 d = position - setup.center;
+    float u = atan2Approx(d[setup.p], d[setup.q]) * inverseTwoPi + 0.5f;
+    if (setup.type == textureMappingCylindrical) {
+        return glm::vec2(u, d[setup.r] * setup.scale[setup.r] + 0.5f);
+    }
+
+    // Arcsine through arctangent, asin(z) = atan(z, sqrt(1 - z^2))
+    float z = d[setup.r] / std::max(glm::length(d), FLT_MIN);
+    return glm::vec2(u, atan2Approx(z, std::sqrt(std::max(1.0f - z * z, 0.0f))) * inversePi + 0.5f);
+}
+
+#ifdef __SSE2__
+inline __m128 select(__m128 mask, __m128 a, __m128 b) {
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+__m128 atan2Approx(__m128 y, __m128 x) {
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    __m128 ax = _mm_andnot_ps(sign, x), ay = _mm_andnot_ps(sign, y);
+    __m128 mx = _mm_max_ps(ax, ay), mn = _mm_min_ps(ax, ay);
+    __m128 t = _mm_div_ps(mn, _mm_max_ps(mx, _mm_set1_ps(FLT_MIN)));
+    __m128 s = _mm_mul_ps(t, t);
+    __m128 angle = _mm_add_ps(_mm_set1_ps(atanA7), _mm_mul_ps(s, _mm_set1_ps(atanA9)));
+    angle = _mm_add_ps(_mm_set1_ps(atanA5), _mm_mul_ps(s, angle));
+    angle = _mm_add_ps(_mm_set1_ps(atanA3), _mm_mul_ps(s, angle));
+    angle = _mm_mul_ps(t, _mm_add_ps(_mm_set1_ps(atanA1), _mm_mul_ps(s, angle)));
+    angle = select(_mm_cmpgt_ps(ay, ax), _mm_sub_ps(_mm_set1_ps(halfPi), angle), angle);
+    angle = select(_mm_cmplt_ps(x, _mm_setzero_ps()), _mm_sub_ps(_mm_set1_ps(pi), angle), angle);
+    return _mm_or_ps(angle, _mm_and_ps(_mm_cmplt_ps(y, _mm_setzero_ps()), sign)); // Angle is not negative yet
+}
+
+// One component of 4 consecutive vertices
+inline __m128 loadComponent(const Vertex *vertices, int component) {
+    return _mm_setr_ps(vertices[0].position[component], vertices[1].position[component], vertices[2].position[component], vertices[3].position[component]);
+}
+#endif
+
+void mapVertices(const MappingSetup &setup, Vertex *vertices, size_t begin, size_t end) {
+    size_t i = begin;
+#ifdef __SSE2__
+    // Interleaved vertices are gathered into registers, the arithmetic is vectorized
+    const __m128 half = _mm_set1_ps(0.5f);
+    for (; i + 4 <= end; i += 4) {
+        __m128 u, v;
+        if (setup.type == textureMappingPlanar) {
+            u = _mm_mul_ps(_mm_sub_ps(loadComponent(vertices + i, setup.u), _mm_set1_ps(setup.boundingBoxMin[setup.u])), _mm_set1_ps(setup.scale[setup.u]));
+            v = _mm_mul_ps(_mm_sub_ps(loadComponent(vertices + i, setup.v), _mm_set1_ps(setup.boundingBoxMin[setup.v])), _mm_set1_ps(setup.scale[setup.v]));
+        } else {
+            __m128 dp = _mm_sub_ps(loadComponent(vertices + i, setup.p), _mm_set1_ps(setup.center[setup.p]));
+            __m128 dq = _mm_sub_ps(loadComponent(vertices + i, setup.q), _mm_set1_ps(setup.center[setup.q]));
+            __m128 dr = _mm_sub_ps(loadComponent(vertices + i, setup.r), _mm_set1_ps(setup.center[setup.r]));
+            u = _mm_add_ps(_mm_mul_ps(atan2Approx(dp, dq), _mm_set1_ps(inverseTwoPi)), half);
+            if (setup.type == textureMappingCylindrical) {
+                v = _mm_add_ps(_mm_mul_ps(dr, _mm_set1_ps(setup.scale[setup.r])), half);
+            } else {
+                __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dp, dp), _mm_mul_ps(dq, dq)), _mm_mul_ps(dr, dr)));
+                __m128 z = _mm_div_ps(dr, _mm_max_ps(length, _mm_set1_ps(FLT_MIN)));
+                __m128 cosine = _mm_sqrt_ps(_mm_max_ps(_mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(z, z)), _mm_setzero_ps()));
+                v = _mm_add_ps(_mm_mul_ps(atan2Approx(z, cosine), _mm_set1_ps(inversePi)), half);
+            }
+        }
+
+        float us[4], vs[4];
+        _mm_storeu_ps(us, u);
+        _mm_storeu_ps(vs, v);
+        for (size_t k = 0; k < 4; ++k) {
+            vertices[i + k].uv = glm::vec2(us[k], vs[k]);
+        }
+    }
+#endif
+
+    for (; i < end; ++i) {
+        vertices[i].uv = mapPosition(setup, vertices[i].position);
+    }
+}
+
+} // namespace
+
+void bakeTextureMapping(Vertex *vertices, size_t vertexCount, GLuint mappingType, GLuint mappingAxis, glm::vec3 boundingBoxMin, glm::vec3 boundingBoxMax) {
+    if (!isProceduralMapping(mappingType)) {
+        return;
+    }
+    MappingSetup setup = mappingSetup(mappingType, mappingAxis, boundingBoxMin, boundingBoxMax);
+
+    parallelFor(vertexCount, bandVertices, [&](size_t begin, size_t end) {
+        mapVertices(setup, vertices, begin, end);
+    });
+}
+
+size_t splitMappingSeams(std::vector<Vertex> &vertices, std::vector<GLuint> &indices) {
+    const GLuint none = ~0u;
+    size_t originalCount = vertices.size();
+    std::vector<GLuint> duplicates; // Of original vertices, allocated at first seam
+
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        float u[3] = {vertices[indices[i]].uv.x, vertices[indices[i + 1]].uv.x, vertices[indices[i + 2]].uv.x};
+        float minU = std::min(u[0], std::min(u[1], u[2]));
+        float maxU = std::max(u[0], std::max(u[1], u[2]));
+        if (maxU - minU <= 0.5f) {
+            continue;
+        }
+
+        // Triangle spans the seam, its corners near U 0 move past 1 (shared by other seam triangles)
+        if (duplicates.empty()) {
+            duplicates.assign(originalCount, none);
+        }
+        for (size_t k = 0; k < 3; ++k) {
+            GLuint index = indices[i + k];
+            if (u[k] >= 0.5f) {
+                continue;
+            }
+            if (duplicates[index] == none) {
+                Vertex duplicate = vertices[index];
+                duplicate.uv.x += 1.0f;
+                duplicates[index] = static_cast<GLuint>(vertices.size());
+                vertices.push_back(duplicate);
+            }
+            indices[i + k] = duplicates[index];
+        }
+    }
+
+    return vertices.size() - originalCount;
+}
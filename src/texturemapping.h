@@ -0,0 +1,27 @@
+#pragma once
+
+#include <vector>
+
+#include <QOpenGLFunctions_3_3_Core>
+
+#include <glm/glm.hpp>
+
+#include "mesh.h"
+
+// Texture mapping types and axes (see MeshObject)
+const GLuint textureMappingSimple = 0; // Mesh UVs (Y axis swaps U and V)
+const GLuint textureMappingPlanar = 1;
+const GLuint textureMappingCylindrical = 2;
+const GLuint textureMappingSpherical = 3;
+
+// Procedural mappings are computed from positions in mesh bounding box, angular ones wrap around in U
+inline bool isProceduralMapping(GLuint mappingType) { return mappingType != textureMappingSimple; }
+inline bool isAngularMapping(GLuint mappingType) { return mappingType == textureMappingCylindrical || mappingType == textureMappingSpherical; }
+
+// Write UVs of procedural mapping along axis into vertices, same as vertex shader's textureMapping()
+// Angles use a polynomial arctangent (error below 1e-5 radians), 4 vertices per iteration with SSE2, vertices are split into bands on the shared thread pool
+void bakeTextureMapping(Vertex *vertices, size_t vertexCount, GLuint mappingType, GLuint mappingAxis, glm::vec3 boundingBoxMin, glm::vec3 boundingBoxMax);
+
+// Duplicate vertices of triangles crossing U seam of angular mappings (U jumps from 1 to 0), duplicates get U + 1 (repeated texture)
+// Indices of all triangles are given (levels of detail too), returns number of added vertices
+size_t splitMappingSeams(std::vector<Vertex> &vertices, std::vector<GLuint> &indices);
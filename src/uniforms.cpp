@@ -0,0 +1,148 @@
+#include "uniforms.h"
+
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+
+const GLchar *uniformBlocksSource = R"glsl(
+    layout(std140) uniform Frame {
+        mat4 P;
+        mat4 V;
+        mat4 InversePV;
+        vec2 ViewportSize;
+        float ClusterDepthScale;
+        float ClusterDepthBias;
+        uint ClusterLogDepth;
+    };
+
+    layout(std140) uniform Object {
+        mat4 MVP;
+        mat4 M;
+        mat4 NormalMatrix;
+        vec3 AmbientColor;
+        vec3 DiffuseColor;
+        vec3 SpecularColor;
+        float SpecularPower; // Shininess factor
+        vec3 BoundingBoxMin;
+        uint TextureMappingType;
+        vec3 BoundingBoxMax;
+        uint TextureMappingAxis;
+        uint PositionQuantized;
+    };
+
+    struct MaterialData {
+        vec3 AmbientColor;
+        vec3 DiffuseColor;
+        vec3 SpecularColor;
+        float SpecularPower;
+    };
+
+    layout(std140) uniform Materials {
+        MaterialData Palette[16];
+    };
+)glsl";
+
+void UniformBuffers::initialize(QOpenGLFunctions_3_3_Core *gl_) {
+    gl = gl_;
+
+    gl->glGenBuffers(1, &frameUBO);
+    gl->glBindBuffer(GL_UNIFORM_BUFFER, frameUBO);
+    gl->glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), nullptr, GL_DYNAMIC_DRAW);
+    gl->glBindBufferBase(GL_UNIFORM_BUFFER, UNIFORM_BINDING_FRAME, frameUBO);
+
+    gl->glGenBuffers(1, &materialsUBO);
+    gl->glBindBuffer(GL_UNIFORM_BUFFER, materialsUBO);
+    gl->glBufferData(GL_UNIFORM_BUFFER, sizeof(MaterialUniforms) * maxPaletteMaterials, nullptr, GL_DYNAMIC_DRAW);
+    gl->glBindBufferBase(GL_UNIFORM_BUFFER, UNIFORM_BINDING_MATERIALS, materialsUBO);
+
+    // Bound ranges must start at multiples of offset alignment
+    GLint alignment = 256;
+    gl->glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    objectStride = (static_cast<GLsizeiptr>(sizeof(ObjectUniforms)) + alignment - 1) / alignment * alignment;
+    gl->glGenBuffers(1, &objectUBO);
+
+    gl->glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void UniformBuffers::destroy() {
+    gl->glDeleteBuffers(1, &frameUBO);
+    gl->glDeleteBuffers(1, &objectUBO);
+    gl->glDeleteBuffers(1, &materialsUBO);
+}
+
+bool UniformBuffers::bindProgram(GLuint program) {
+    struct Block {
+        const char *name;
+        GLuint binding;
+        GLint size;
+    };
+    const Block blocks[] = {
+        {"Frame", UNIFORM_BINDING_FRAME, static_cast<GLint>(sizeof(FrameUniforms))},
+        {"Object", UNIFORM_BINDING_OBJECT, static_cast<GLint>(sizeof(ObjectUniforms))},
+        {"Materials", UNIFORM_BINDING_MATERIALS, static_cast<GLint>(sizeof(MaterialUniforms) * maxPaletteMaterials)}
+    };
+
+    bool ok = true;
+    for (const auto &block : blocks) {
+        GLuint index = gl->glGetUniformBlockIndex(program, block.name);
+        if (index == GL_INVALID_INDEX) {
+            continue; // Not used by program (optimized out)
+        }
+
+        GLint size = 0;
+        gl->glGetActiveUniformBlockiv(program, index, GL_UNIFORM_BLOCK_DATA_SIZE, &size);
+        if (size > block.size) {
+            std::cerr << "Uniform block layout mismatch! [" << block.name << ": " << size << " > " << block.size << "]" << std::endl;
+            ok = false;
+        }
+        gl->glUniformBlockBinding(program, index, block.binding);
+    }
+    return ok;
+}
+
+size_t UniformBuffers::updateFrame(const FrameUniforms &frame) {
+    gl->glBindBuffer(GL_UNIFORM_BUFFER, frameUBO);
+    gl->glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameUniforms), &frame);
+    gl->glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    return sizeof(FrameUniforms);
+}
+
+size_t UniformBuffers::updateMaterials(const std::vector<MaterialUniforms> &materials) {
+    size_t count = std::min(materials.size(), maxPaletteMaterials);
+    if (count == 0) {
+        return 0;
+    }
+
+    gl->glBindBuffer(GL_UNIFORM_BUFFER, materialsUBO);
+    gl->glBufferSubData(GL_UNIFORM_BUFFER, 0, static_cast<GLsizeiptr>(count * sizeof(MaterialUniforms)), materials.data());
+    gl->glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    return count * sizeof(MaterialUniforms);
+}
+
+size_t UniformBuffers::updateObjects(const std::vector<ObjectUniforms> &objects) {
+    // Lay out objects at aligned offsets and upload them in one call
+    GLsizeiptr size = objectStride * static_cast<GLsizeiptr>(objects.size());
+    if (size == 0) {
+        return 0;
+    }
+    staging.resize(static_cast<size_t>(size));
+    for (size_t i = 0; i < objects.size(); ++i) {
+        memcpy(staging.data() + i * objectStride, &objects[i], sizeof(ObjectUniforms));
+    }
+
+    // Reallocating each frame orphans the previous storage, so there is no wait on draws still reading it
+    gl->glBindBuffer(GL_UNIFORM_BUFFER, objectUBO);
+    gl->glBufferData(GL_UNIFORM_BUFFER, size, staging.data(), GL_STREAM_DRAW);
+    gl->glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    objectCapacity = size;
+    return static_cast<size_t>(size);
+}
+
+void UniformBuffers::bindObject(size_t index) {
+    GLintptr offset = objectStride * static_cast<GLintptr>(index);
+    if (offset + objectStride > objectCapacity) {
+        std::cerr << "Binding object uniforms failed! Index out of range! [" << index << "]" << std::endl;
+        return;
+    }
+    gl->glBindBufferRange(GL_UNIFORM_BUFFER, UNIFORM_BINDING_OBJECT, objectUBO, offset, sizeof(ObjectUniforms));
+}
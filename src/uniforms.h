@@ -0,0 +1,92 @@
+#pragma once
+
+#include <vector>
+
+#include <QOpenGLFunctions_3_3_Core>
+
+#include <glm/glm.hpp>
+
+// Uniform block binding points
+enum UniformBinding : GLuint {
+    UNIFORM_BINDING_FRAME = 0,
+    UNIFORM_BINDING_OBJECT = 1,
+    UNIFORM_BINDING_MATERIALS = 2
+};
+
+// Material palette size of "Materials" block
+const size_t maxPaletteMaterials = 16;
+
+// Per-frame uniforms, "Frame" std140 block (a scalar after vec3 shares its 16 bytes, vec3 alone is padded)
+struct FrameUniforms {
+    glm::mat4 P;
+    glm::mat4 V;
+    glm::mat4 inversePV; // World position from clip position (deferred shading)
+    glm::vec2 viewportSize; // Pixels
+    float clusterDepthScale; // See ClusterDepth
+    float clusterDepthBias;
+    GLuint clusterLogDepth;
+    GLuint padding[3];
+};
+
+// Per-object uniforms, "Object" std140 block (matrices are computed on CPU, shaders only multiply)
+struct ObjectUniforms {
+    glm::mat4 MVP;
+    glm::mat4 M;
+    glm::mat4 normalMatrix; // transpose(inverse(M)), used as mat3
+    glm::vec3 ambientColor;
+    float padding0;
+    glm::vec3 diffuseColor;
+    float padding1;
+    glm::vec3 specularColor;
+    float specularPower;
+    glm::vec3 boundingBoxMin;
+    GLuint textureMappingType;
+    glm::vec3 boundingBoxMax;
+    GLuint textureMappingAxis;
+    GLuint positionQuantized; // 1 - packed vertex formats (positions unorm16 in bounding box, octahedral normals and tangents)
+    GLuint padding2[3];
+};
+
+// Palette material, element of "Materials" std140 block array
+struct MaterialUniforms {
+    glm::vec3 ambientColor;
+    float padding0;
+    glm::vec3 diffuseColor;
+    float padding1;
+    glm::vec3 specularColor;
+    float specularPower;
+};
+
+static_assert(sizeof(FrameUniforms) == 224 && sizeof(ObjectUniforms) == 288 && sizeof(MaterialUniforms) == 48,
+              "Uniform structs must match std140 layout");
+
+// GLSL declarations of above blocks, shared by all shaders
+extern const GLchar *uniformBlocksSource;
+
+// Uniform buffers for per-frame and per-object blocks (OpenGL thread only)
+// Per-object data of the whole frame is uploaded at once, each draw then binds its own range (dynamic offset)
+class UniformBuffers {
+public:
+    void initialize(QOpenGLFunctions_3_3_Core *gl_);
+    void destroy();
+
+    // Reflect program once after linking, binds its blocks to binding points and checks their layout
+    bool bindProgram(GLuint program);
+
+    // Return uploaded bytes
+    size_t updateFrame(const FrameUniforms &frame);
+    size_t updateObjects(const std::vector<ObjectUniforms> &objects);
+    size_t updateMaterials(const std::vector<MaterialUniforms> &materials); // Up to maxPaletteMaterials
+
+    // Bind uniforms of object at index of last updateObjects()
+    void bindObject(size_t index);
+
+private:
+    QOpenGLFunctions_3_3_Core *gl = nullptr;
+    GLuint frameUBO = 0;
+    GLuint objectUBO = 0;
+    GLuint materialsUBO = 0;
+    GLsizeiptr objectStride = 0; // Size of ObjectUniforms rounded up to offset alignment
+    GLsizeiptr objectCapacity = 0; // Size of object data uploaded last
+    std::vector<char> staging;
+};
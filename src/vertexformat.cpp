@@ -0,0 +1,173 @@
+#include "vertexformat.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <glm/ext.hpp>
+
+namespace {
+
+// Octahedral mapping of unit vector to [-1, 1] square (same as G-buffer normals, see geometryFragmentShaderSource)
+glm::vec2 octahedralEncode(glm::vec3 v) {
+    v /= std::abs(v.x) + std::abs(v.y) + std::abs(v.z);
+    if (v.z < 0.0f) {
+        return (1.0f - glm::abs(glm::vec2(v.y, v.x))) * glm::vec2(v.x >= 0.0f ? 1.0f : -1.0f, v.y >= 0.0f ? 1.0f : -1.0f);
+    }
+    return glm::vec2(v.x, v.y);
+}
+
+glm::vec3 octahedralDecode(glm::vec2 e) {
+    glm::vec3 v(e.x, e.y, 1.0f - std::abs(e.x) - std::abs(e.y));
+    float t = std::max(-v.z, 0.0f);
+    v.x += v.x >= 0.0f ? -t : t;
+    v.y += v.y >= 0.0f ? -t : t;
+    return glm::normalize(v);
+}
+
+glm::vec3 unpackOctahedral(const uint8_t *in) {
+    return octahedralDecode(glm::vec2(in[0], in[1]) / 255.0f * 2.0f - 1.0f);
+}
+
+// Unorm8 octahedral direction, rounded towards the nearest decoded direction
+void packOctahedral(glm::vec3 direction, uint8_t *out /* out */) {
+    float length = glm::length(direction);
+    direction = length > 0.0f ? direction / length : glm::vec3(0.0f, 0.0f, 1.0f); // Degenerate directions decode to any unit vector anyway
+
+    glm::vec2 e = (octahedralEncode(direction) * 0.5f + 0.5f) * 255.0f;
+    float bestCosine = -2.0f;
+    for (int x = 0; x < 2; ++x) {
+        for (int y = 0; y < 2; ++y) {
+            uint8_t candidate[2] = {
+                static_cast<uint8_t>(std::min(std::floor(e.x) + x, 255.0f)),
+                static_cast<uint8_t>(std::min(std::floor(e.y) + y, 255.0f))
+            };
+            float cosine = glm::dot(unpackOctahedral(candidate), direction);
+            if (cosine > bestCosine) {
+                bestCosine = cosine;
+                out[0] = candidate[0];
+                out[1] = candidate[1];
+            }
+        }
+    }
+}
+
+}
+
+size_t vertexFormatSize(VertexFormat format) {
+    return format == VERTEX_FORMAT_FLOAT ? sizeof(Vertex) : sizeof(PackedVertex);
+}
+
+size_t indexTypeSize(GLenum type) {
+    return type == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(GLuint);
+}
+
+void setupVertexAttributes(QOpenGLFunctions_3_3_Core *gl, VertexFormat format) {
+    // Setup vertex attributes (specify layout of vertex data)
+    gl->glEnableVertexAttribArray(0);  // We use: layout(location=0) and vec4 position;
+    gl->glEnableVertexAttribArray(1);  // We use: layout(location=1) and vec2 uv;
+    gl->glEnableVertexAttribArray(2);  // We use: layout(location=2) and vec4 normal;
+
+    if (format == VERTEX_FORMAT_FLOAT) {
+        gl->glEnableVertexAttribArray(8);  // We use: layout(location=8) and vec4 tangent; (3-7 are instance attributes)
+        gl->glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<void *>(offsetof(Vertex, position)));
+        gl->glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<void *>(offsetof(Vertex, uv)));
+        gl->glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<void *>(offsetof(Vertex, normal)));
+        gl->glVertexAttribPointer(8, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<void *>(offsetof(Vertex, tangent)));
+        return;
+    }
+
+    // Bitangent sign rides in position w, tangent in normal zw (attribute 8 is unused)
+    GLenum uvType = format == VERTEX_FORMAT_PACKED_UNORM_UV ? GL_UNSIGNED_SHORT : GL_HALF_FLOAT;
+    gl->glDisableVertexAttribArray(8);
+    gl->glVertexAttribPointer(0, 4, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedVertex), reinterpret_cast<void *>(offsetof(PackedVertex, position)));
+    gl->glVertexAttribPointer(1, 2, uvType, uvType == GL_UNSIGNED_SHORT, sizeof(PackedVertex), reinterpret_cast<void *>(offsetof(PackedVertex, uv)));
+    gl->glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(PackedVertex), reinterpret_cast<void *>(offsetof(PackedVertex, normal)));
+}
+
+VertexFormat packVertices(const Vertex *vertices, size_t vertexCount, glm::vec3 boundingBoxMin, glm::vec3 boundingBoxMax,
+                          std::vector<PackedVertex> &packed) {
+    // Flat axes (eg. ground plane height) all quantize to bounding box minimum
+    glm::vec3 size = boundingBoxMax - boundingBoxMin;
+    glm::vec3 scale(size.x > 0.0f ? 1.0f / size.x : 0.0f, size.y > 0.0f ? 1.0f / size.y : 0.0f, size.z > 0.0f ? 1.0f / size.z : 0.0f);
+
+    bool unormUV = true;
+    for (size_t i = 0; i < vertexCount && unormUV; ++i) {
+        const glm::vec2 &uv = vertices[i].uv;
+        unormUV = uv.x >= 0.0f && uv.x <= 1.0f && uv.y >= 0.0f && uv.y <= 1.0f;
+    }
+
+    packed.resize(vertexCount);
+    for (size_t i = 0; i < vertexCount; ++i) {
+        const Vertex &vertex = vertices[i];
+        PackedVertex &out = packed[i];
+
+        glm::vec3 position = (vertex.position - boundingBoxMin) * scale;
+        out.position[0] = glm::packUnorm1x16(position.x);
+        out.position[1] = glm::packUnorm1x16(position.y);
+        out.position[2] = glm::packUnorm1x16(position.z);
+        out.position[3] = vertex.tangent.w < 0.0f ? 0 : 65535;
+
+        for (int c = 0; c < 2; ++c) {
+            out.uv[c] = unormUV ? glm::packUnorm1x16(vertex.uv[c]) : glm::packHalf1x16(vertex.uv[c]);
+        }
+
+        // Directions only, shading normalizes interpolated normals and orthogonalizes tangents anyway
+        packOctahedral(vertex.normal, out.normal);
+        packOctahedral(glm::vec3(vertex.tangent), out.normal + 2);
+    }
+
+    return unormUV ? VERTEX_FORMAT_PACKED_UNORM_UV : VERTEX_FORMAT_PACKED;
+}
+
+Vertex unpackVertex(const PackedVertex &packed, VertexFormat format, glm::vec3 boundingBoxMin, glm::vec3 boundingBoxMax) {
+    Vertex vertex;
+    glm::vec3 position(glm::unpackUnorm1x16(packed.position[0]), glm::unpackUnorm1x16(packed.position[1]), glm::unpackUnorm1x16(packed.position[2]));
+    vertex.position = boundingBoxMin + position * (boundingBoxMax - boundingBoxMin);
+    for (int c = 0; c < 2; ++c) {
+        vertex.uv[c] = format == VERTEX_FORMAT_PACKED_UNORM_UV ? glm::unpackUnorm1x16(packed.uv[c]) : glm::unpackHalf1x16(packed.uv[c]);
+    }
+    vertex.normal = unpackOctahedral(packed.normal);
+    vertex.tangent = glm::vec4(unpackOctahedral(packed.normal + 2), packed.position[3] != 0 ? 1.0f : -1.0f);
+    return vertex;
+}
+
+void packIndices(const GLuint *indices, size_t indexCount, std::vector<uint16_t> &packed) {
+    packed.resize(indexCount);
+    for (size_t i = 0; i < indexCount; ++i) {
+        packed[i] = static_cast<uint16_t>(indices[i]);
+    }
+}
+
+QuantizationError measureQuantizationError(const Vertex *vertices, size_t vertexCount, const PackedVertex *packed, VertexFormat format,
+                                           glm::vec3 boundingBoxMin, glm::vec3 boundingBoxMax) {
+    QuantizationError error;
+    size_t normals = 0;
+    for (size_t i = 0; i < vertexCount; ++i) {
+        Vertex unpacked = unpackVertex(packed[i], format, boundingBoxMin, boundingBoxMax);
+
+        float position = glm::length(unpacked.position - vertices[i].position);
+        error.maxPosition = std::max(error.maxPosition, position);
+        error.meanPosition += position;
+
+        glm::vec2 uv = glm::abs(unpacked.uv - vertices[i].uv);
+        error.maxUV = std::max(error.maxUV, std::max(uv.x, uv.y));
+
+        // Degenerate normals have no direction to compare
+        float length = glm::length(vertices[i].normal) * glm::length(unpacked.normal);
+        if (length > 0.0f) {
+            float cosine = glm::clamp(glm::dot(vertices[i].normal, unpacked.normal) / length, -1.0f, 1.0f);
+            float angle = glm::degrees(std::acos(cosine));
+            error.maxNormalAngle = std::max(error.maxNormalAngle, angle);
+            error.meanNormalAngle += angle;
+            ++normals;
+        }
+    }
+
+    if (vertexCount > 0) {
+        error.meanPosition /= vertexCount;
+    }
+    if (normals > 0) {
+        error.meanNormalAngle /= normals;
+    }
+    return error;
+}
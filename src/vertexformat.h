@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <QOpenGLFunctions_3_3_Core>
+
+#include <glm/glm.hpp>
+
+#include "mesh.h"
+
+// Bytes per vertex of format and per index of type (GL_UNSIGNED_SHORT or GL_UNSIGNED_INT)
+size_t vertexFormatSize(VertexFormat format);
+size_t indexTypeSize(GLenum type);
+
+// Setup vertex attributes 0-2 and 8 (tangent) of bound vertex buffer (layout of given format), into bound VAO
+// Packed positions are normalized to [0, 1] in mesh bounding box and tangents share normal attribute, shaders decode them (see ObjectUniforms::positionQuantized)
+void setupVertexAttributes(QOpenGLFunctions_3_3_Core *gl, VertexFormat format);
+
+// Quantize vertices: positions to unorm16 in given bounding box, normals and tangents to octahedral unorm8, UVs to unorm16 if all are in [0, 1], half floats otherwise
+// Returns format of packed vertices (VERTEX_FORMAT_PACKED or VERTEX_FORMAT_PACKED_UNORM_UV)
+VertexFormat packVertices(const Vertex *vertices, size_t vertexCount, glm::vec3 boundingBoxMin, glm::vec3 boundingBoxMax,
+                          std::vector<PackedVertex> &packed /* out */);
+Vertex unpackVertex(const PackedVertex &packed, VertexFormat format, glm::vec3 boundingBoxMin, glm::vec3 boundingBoxMax);
+
+// Indices of meshes with at most this many vertices fit GL_UNSIGNED_SHORT
+const size_t maxShortIndexVertices = 1 << 16;
+void packIndices(const GLuint *indices, size_t indexCount, std::vector<uint16_t> &packed /* out */);
+
+// Difference of packed vertices from original ones
+struct QuantizationError {
+    float maxPosition = 0.0f; // Local units
+    float meanPosition = 0.0f;
+    float maxUV = 0.0f;
+    float maxNormalAngle = 0.0f; // Degrees
+    float meanNormalAngle = 0.0f;
+};
+
+QuantizationError measureQuantizationError(const Vertex *vertices, size_t vertexCount, const PackedVertex *packed, VertexFormat format,
+                                           glm::vec3 boundingBoxMin, glm::vec3 boundingBoxMax);
@@ -0,0 +1,128 @@
+#include "voxelmesh.h"
+
+#include <algorithm>
+
+namespace {
+
+// Merged rectangle of faces in plane slice along axis, starting at cell (i, j) in plane axes
+struct VoxelQuad {
+    int axis;
+    int slice;
+    int i, j;
+    int width, height;
+    bool positive; // Facing increasing axis (occupied cell behind plane)
+};
+
+// Faces of one plane between cells slice - 1 and slice, greedily merged (mask is cleared)
+void mergeFaces(std::vector<int8_t> &mask, int sizeU, int sizeV, int axis, int slice, std::vector<VoxelQuad> &quads) {
+    for (int j = 0; j < sizeV; ++j) {
+        int8_t *row = mask.data() + static_cast<size_t>(j) * sizeU;
+        for (int i = 0; i < sizeU;) {
+            int8_t face = row[i];
+            if (face == 0) {
+                ++i;
+                continue;
+            }
+
+            // Widest run along U, then as many rows along V as are covered by the same run
+            int width = 1;
+            while (i + width < sizeU && row[i + width] == face) {
+                ++width;
+            }
+            int height = 1;
+            for (; j + height < sizeV; ++height) {
+                const int8_t *next = row + static_cast<size_t>(height) * sizeU + i;
+                if (std::any_of(next, next + width, [face](int8_t other) { return other != face; })) {
+                    break;
+                }
+            }
+
+            for (int k = 0; k < height; ++k) {
+                std::fill_n(row + static_cast<size_t>(k) * sizeU + i, width, 0);
+            }
+            quads.push_back({axis, slice, i, j, width, height, face > 0});
+            i += width;
+        }
+    }
+}
+
+} // namespace
+
+void VoxelGrid::fill(glm::ivec3 min, glm::ivec3 max) {
+    min = glm::max(min, glm::ivec3(0));
+    max = glm::min(max, size);
+    for (int z = min.z; z < max.z; ++z) {
+        for (int y = min.y; y < max.y; ++y) {
+            std::fill_n(cells.begin() + static_cast<std::ptrdiff_t>(index(min.x, y, z)), std::max(max.x - min.x, 0), 1);
+        }
+    }
+}
+
+void meshVoxels(const VoxelGrid &grid, std::vector<Vertex> &vertices, std::vector<GLuint> &indices) {
+    // Quads of all planes first, output is then written once into buffers of final size
+    std::vector<VoxelQuad> quads;
+    std::vector<int8_t> mask;
+    const size_t strides[3] = {1, static_cast<size_t>(grid.size.x), static_cast<size_t>(grid.size.x) * grid.size.y};
+    for (int axis = 0; axis < 3; ++axis) {
+        // Plane axes follow axis cyclically, so U x V points along axis
+        int u = (axis + 1) % 3, v = (axis + 2) % 3;
+        int sizeU = grid.size[u], sizeV = grid.size[v];
+        mask.assign(static_cast<size_t>(sizeU) * sizeV, 0);
+
+        for (int slice = 0; slice <= grid.size[axis]; ++slice) {
+            // Face where exactly one of the cells around plane is occupied (1 - cell behind, -1 - cell in front)
+            bool hasBehind = slice > 0, hasFront = slice < grid.size[axis];
+            bool anyFace = false;
+            for (int j = 0; j < sizeV; ++j) {
+                for (int i = 0; i < sizeU; ++i) {
+                    size_t front = static_cast<size_t>(slice) * strides[axis] + i * strides[u] + j * strides[v];
+                    bool behindCell = hasBehind && grid.cells[front - strides[axis]] != 0;
+                    bool frontCell = hasFront && grid.cells[front] != 0;
+                    int8_t face = behindCell == frontCell ? 0 : (behindCell ? 1 : -1);
+                    mask[static_cast<size_t>(j) * sizeU + i] = face;
+                    anyFace |= face != 0;
+                }
+            }
+
+            if (anyFace) {
+                mergeFaces(mask, sizeU, sizeV, axis, slice, quads);
+            }
+        }
+    }
+
+    vertices.resize(quads.size() * 4);
+    indices.resize(quads.size() * 6);
+    for (size_t q = 0; q < quads.size(); ++q) {
+        const VoxelQuad &quad = quads[q];
+        int u = (quad.axis + 1) % 3, v = (quad.axis + 2) % 3;
+
+        glm::vec3 base = grid.origin;
+        base[quad.axis] += quad.slice * grid.cellSize[quad.axis];
+        base[u] += quad.i * grid.cellSize[u];
+        base[v] += quad.j * grid.cellSize[v];
+        glm::vec3 edgeU(0.0f), edgeV(0.0f);
+        edgeU[u] = quad.width * grid.cellSize[u];
+        edgeV[v] = quad.height * grid.cellSize[v];
+
+        // Negative faces run U backwards, so textures are not mirrored when looked at from outside
+        float direction = quad.positive ? 1.0f : -1.0f;
+        glm::vec3 normal(0.0f), tangent(0.0f);
+        normal[quad.axis] = direction;
+        tangent[u] = direction;
+
+        glm::vec3 corners[4] = {base, base + edgeU, base + edgeU + edgeV, base + edgeV};
+        Vertex *out = vertices.data() + q * 4;
+        for (size_t k = 0; k < 4; ++k) {
+            out[k] = {corners[k], glm::vec2(corners[k][u] * direction, corners[k][v]), normal, glm::vec4(tangent, 1.0f)};
+        }
+
+        // Counter-clockwise when looked at from the side normal points to
+        const GLuint positiveOrder[6] = {0, 1, 2, 0, 2, 3};
+        const GLuint negativeOrder[6] = {0, 2, 1, 0, 3, 2};
+        const GLuint *order = quad.positive ? positiveOrder : negativeOrder;
+        GLuint first = static_cast<GLuint>(q * 4);
+        for (size_t k = 0; k < 6; ++k) {
+            indices[q * 6 + k] = first + order[k];
+        }
+    }
+}
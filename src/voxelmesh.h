@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "mesh.h"
+
+// Occupancy grid of equally sized boxes (blocks of generators), cell (0, 0, 0) starts at origin
+// Cells may be smaller than blocks (eg. half-cells for blocks offset by half a block), a block then fills several cells
+struct VoxelGrid {
+    glm::ivec3 size;
+    glm::vec3 origin;
+    glm::vec3 cellSize;
+    std::vector<uint8_t> cells; // X fastest, then Y, then Z (0 - empty)
+
+    VoxelGrid(glm::ivec3 size_, glm::vec3 origin_ = glm::vec3(0.0f), glm::vec3 cellSize_ = glm::vec3(1.0f))
+        : size(size_), origin(origin_), cellSize(cellSize_), cells(static_cast<size_t>(size_.x) * size_.y * size_.z, 0) {}
+
+    size_t index(int x, int y, int z) const { return static_cast<size_t>(x) + static_cast<size_t>(size.x) * (static_cast<size_t>(y) + static_cast<size_t>(size.y) * z); }
+    void fill(glm::ivec3 min, glm::ivec3 max); // Cells in [min, max) are occupied
+};
+
+// Faces between occupied and empty cells (or grid edge), coplanar neighbouring faces merged into rectangles (greedy meshing)
+// Faces have own vertices with face normals and tangents, UVs are world units along face (texture repeats per unit)
+// Merged rectangles meet in T-junctions, fine for exact integer positions of generated blocks
+void meshVoxels(const VoxelGrid &grid, std::vector<Vertex> &vertices /* out */, std::vector<GLuint> &indices /* out */);
@@ -6,20 +6,38 @@ WidgetOpenGLDraw::WidgetOpenGLDraw(QWidget *parent) : QOpenGLWidget(parent) {
 
     std::random_device rd;
     rng = std::mt19937(rd());
+
+    // Models are parsed on worker threads and buffered to GPU here as they arrive
+    QObject::connect(&modelLoader, SIGNAL(modelsReady()), this, SLOT(addLoadedModels()));
+    QObject::connect(&modelLoader, SIGNAL(finished()), this, SLOT(modelLoadFinished()));
+
+    // Textures are decoded on worker threads and uploaded here as they arrive
+    QObject::connect(&textureLoader, SIGNAL(texturesReady()), this, SLOT(addDecodedTextures()));
 }
 
 WidgetOpenGLDraw::~WidgetOpenGLDraw() {
     // Clean state
     gl.glDeleteProgram(programShaderID);
-    gl.glDeleteShader(vertexShaderID);
-    gl.glDeleteShader(fragmentShaderID);
-
-    for (const auto &object : objects) {
-        gl.glDeleteVertexArrays(1, &object.VAO);
-        gl.glDeleteBuffers(1, &object.VBO);
-        gl.glDeleteBuffers(1, &object.IBO);
-        gl.glDeleteBuffers(2, object.TBO);
+    gl.glDeleteProgram(geometryProgramID);
+    gl.glDeleteProgram(deferredProgramID);
+    meshPrograms.destroy();
+    gl.glDeleteVertexArrays(1, &fullscreenVAO);
+    gBuffer.destroy();
+
+    for (const auto &object : scene.objects) {
+        if (!object.instances.empty()) {
+            gl.glDeleteVertexArrays(1, &object.instanceVAO);
+            gl.glDeleteBuffers(1, &object.instanceVBO);
+        }
     }
+    scene.clear(); // Releases shared meshes and textures, before asset cache is gone
+    meshBuffer.destroy();
+
+    gl.glDeleteTextures(2, placeholderTBO);
+    pixelUploadRing.destroy();
+    uniformBuffers.destroy();
+    lightClusters.destroy();
+    profiler.destroy();
 }
 
 void WidgetOpenGLDraw::printProgramInfoLog(GLuint obj) {
@@ -44,8 +62,22 @@ void WidgetOpenGLDraw::printShaderInfoLog(GLuint obj) {
     }
 }
 
+// Prepended to shaders, followed by variant defines and uniform block declarations (uniforms.cpp)
+const GLchar* WidgetOpenGLDraw::shaderVersionSource = R"glsl(#version 330 core
+)glsl";
+
+// Defaults of shader variant defines (see ShaderVariant), one program branching on object uniforms
+const GLchar* WidgetOpenGLDraw::variantDefaultsSource = R"glsl(
+    #ifndef MAPPING_TYPE
+    #define MAPPING_TYPE TextureMappingType
+    #define MAPPING_AXIS TextureMappingAxis
+    #define HAS_TEXTURE 1
+    #define HAS_BUMP_MAP 1
+    #define BUMP_FROM_HEIGHT 0
+    #endif
+)glsl";
+
 const GLchar* WidgetOpenGLDraw::vertexShaderSource = R"glsl(
-    #version 330 core
     const uint MAPPING_TYPE_SIMPLE = uint(0);
     const uint MAPPING_TYPE_PLANAR = uint(1);
     const uint MAPPING_TYPE_CYLINDRICAL = uint(2);
@@ -54,69 +86,66 @@ const GLchar* WidgetOpenGLDraw::vertexShaderSource = R"glsl(
     const uint MAPPING_AXIS_Y = uint(1);
     const uint MAPPING_AXIS_Z = uint(2);
 
-    layout(location=0) in vec3 position;
+    layout(location=0) in vec4 position; // Packed vertices: w - bitangent sign (0 - negative, 1 - positive)
     layout(location=1) in vec2 uv;
-    layout(location=2) in vec3 normal;
-
-    uniform mat4 P;
-    uniform mat4 V;
-    uniform mat4 M;
-    uniform uint TextureMappingType;
-    uniform uint TextureMappingAxis;
-    uniform vec3 BoundingBoxMin;
-    uniform vec3 BoundingBoxMax;
+    layout(location=2) in vec4 normal; // Packed vertices: octahedral normal in xy, octahedral tangent in zw
+    layout(location=3) in mat4 InstanceM; // Locations 3-6, identity if not instanced
+    layout(location=7) in uint InstanceMaterialIndex; // 0 if not instanced
+    layout(location=8) in vec4 tangent; // Float vertices only
 
     out vec2 TextureUV;
     out vec3 VertexPosition;
     out vec3 NormalInterpolated;
+    out vec4 TangentInterpolated; // Direction of increasing U, w - bitangent sign
+    flat out uint MaterialIndex;
 
-    vec2 textureMapping(vec2 uv) {
+    vec2 textureMapping(vec3 objectPosition, vec2 uv) {
         vec3 objectSize = BoundingBoxMax - BoundingBoxMin; // Distance from one edge of bounding box to another
         vec3 objectCenter = BoundingBoxMin + objectSize / 2; // Bounding box center
-        vec3 objectCenterToVertex = position - objectCenter; // Vector from vertex to bounding box center
+        vec3 objectCenterToVertex = objectPosition - objectCenter; // Vector from vertex to bounding box center
         // GLSL atan(y, x): x and y parameters inversed!
 
-        if (TextureMappingType == MAPPING_TYPE_SIMPLE) {
-            if (TextureMappingAxis == MAPPING_AXIS_Y) {
+        if (MAPPING_TYPE == MAPPING_TYPE_SIMPLE) {
+            if (MAPPING_AXIS == MAPPING_AXIS_Y) {
                 uv = vec2(uv.y, uv.x);
             }
-        } else if (TextureMappingType == MAPPING_TYPE_PLANAR) {
-            if (TextureMappingAxis == MAPPING_AXIS_X) {
-                uv.x = (position.z - BoundingBoxMin.z) / objectSize.z;
-                uv.y = (position.y - BoundingBoxMin.y) / objectSize.y;
-            } else if (TextureMappingAxis == MAPPING_AXIS_Y) {
-                uv.x = (position.x - BoundingBoxMin.x) / objectSize.x;
-                uv.y = (position.z - BoundingBoxMin.z) / objectSize.z;
-            } else if (TextureMappingAxis == MAPPING_AXIS_Z) {
-                uv.x = (position.x - BoundingBoxMin.x) / objectSize.x;
-                uv.y = (position.y - BoundingBoxMin.y) / objectSize.y;
+        } else if (MAPPING_TYPE == MAPPING_TYPE_PLANAR) {
+            if (MAPPING_AXIS == MAPPING_AXIS_X) {
+                uv.x = (objectPosition.z - BoundingBoxMin.z) / objectSize.z;
+                uv.y = (objectPosition.y - BoundingBoxMin.y) / objectSize.y;
+            } else if (MAPPING_AXIS == MAPPING_AXIS_Y) {
+                uv.x = (objectPosition.x - BoundingBoxMin.x) / objectSize.x;
+                uv.y = (objectPosition.z - BoundingBoxMin.z) / objectSize.z;
+            } else if (MAPPING_AXIS == MAPPING_AXIS_Z) {
+                uv.x = (objectPosition.x - BoundingBoxMin.x) / objectSize.x;
+                uv.y = (objectPosition.y - BoundingBoxMin.y) / objectSize.y;
             }
-        } else if (TextureMappingType == MAPPING_TYPE_CYLINDRICAL) {
+        } else if (MAPPING_TYPE == MAPPING_TYPE_CYLINDRICAL) {
             float angle = 0.0f;
 
-            if (TextureMappingAxis == MAPPING_AXIS_X) {
-                angle = atan(objectCenterToVertex.y, objectCenterToVertex.z) + 180.0f;
+            if (MAPPING_AXIS == MAPPING_AXIS_X) {
+                angle = degrees(atan(objectCenterToVertex.y, objectCenterToVertex.z)) + 180.0f;
                 uv.y = objectCenterToVertex.x / objectSize.x + 0.5f;
-            } else if (TextureMappingAxis == MAPPING_AXIS_Y) {
-                angle = atan(objectCenterToVertex.z, objectCenterToVertex.x) + 180.0f;
+            } else if (MAPPING_AXIS == MAPPING_AXIS_Y) {
+                angle = degrees(atan(objectCenterToVertex.z, objectCenterToVertex.x)) + 180.0f;
                 uv.y = objectCenterToVertex.y / objectSize.y + 0.5f;
-            } else if (TextureMappingAxis == MAPPING_AXIS_Z) {
-                angle = atan(objectCenterToVertex.y, objectCenterToVertex.x) + 180.0f;
+            } else if (MAPPING_AXIS == MAPPING_AXIS_Z) {
+                angle = degrees(atan(objectCenterToVertex.y, objectCenterToVertex.x)) + 180.0f;
                 uv.y = objectCenterToVertex.z / objectSize.z + 0.5f;
             }
 
             uv.x = angle / 360.0f;
-        } else if (TextureMappingType == MAPPING_TYPE_SPHERICAL) {
+        } else if (MAPPING_TYPE == MAPPING_TYPE_SPHERICAL) {
             float angle1 = 0.0f;
             float angle2 = 0.0f;
 
-            if (TextureMappingAxis == MAPPING_AXIS_X) {
+            if (MAPPING_AXIS == MAPPING_AXIS_X) {
                 angle1 = degrees(atan(objectCenterToVertex.y, objectCenterToVertex.z)) + 180.0f;
                 angle2 = degrees(asin(objectCenterToVertex.x / length(objectCenterToVertex)));
-            } else if (TextureMappingAxis == MAPPING_AXIS_Y) {
+            } else if (MAPPING_AXIS == MAPPING_AXIS_Y) {
                 angle1 = degrees(atan(objectCenterToVertex.z, objectCenterToVertex.x)) + 180.0f;
                 angle2 = degrees(asin(objectCenterToVertex.y / length(objectCenterToVertex)));
-            } else if (TextureMappingAxis == MAPPING_AXIS_Z) {
+            } else if (MAPPING_AXIS == MAPPING_AXIS_Z) {
                 angle1 = degrees(atan(objectCenterToVertex.y, objectCenterToVertex.x)) + 180.0f;
                 angle2 = degrees(asin(objectCenterToVertex.z / length(objectCenterToVertex)));
             }
@@ -128,47 +157,98 @@ const GLchar* WidgetOpenGLDraw::vertexShaderSource = R"glsl(
         return uv;
     }
 
+    // Tangent of mapped texture coordinates in object space (direction of increasing U, w - bitangent sign)
+    vec4 mappingTangent(vec3 objectPosition, vec3 objectNormal, vec4 vertexTangent, vec2 uv) {
+        if (MAPPING_TYPE == MAPPING_TYPE_SIMPLE) {
+            // Swapped U and V turn bitangent into tangent and flip handedness
+            if (MAPPING_AXIS == MAPPING_AXIS_Y) {
+                return vec4(vertexTangent.w * cross(objectNormal, vertexTangent.xyz), -vertexTangent.w);
+            }
+            return vertexTangent;
+        }
+
+        // Vertex tangents follow mesh UVs, procedural mappings are differentiated per vertex instead (central differences)
+        vec3 objectSize = BoundingBoxMax - BoundingBoxMin;
+        float h = 1e-3 * max(objectSize.x, max(objectSize.y, objectSize.z));
+        vec3 gradientU = vec3(0.0);
+        vec3 gradientV = vec3(0.0);
+        for (int axis = 0; axis < 3; ++axis) {
+            vec3 offset = vec3(0.0);
+            offset[axis] = h;
+            vec2 difference = textureMapping(objectPosition + offset, uv) - textureMapping(objectPosition - offset, uv);
+            gradientU[axis] = difference.x - round(difference.x); // U wraps around at seam of angular mappings
+            gradientV[axis] = difference.y;
+        }
+
+        vec3 t = gradientU - objectNormal * dot(objectNormal, gradientU);
+        if (dot(t, t) <= 1e-8 * (dot(gradientU, gradientU) + dot(gradientV, gradientV))) {
+            // U doesn't change along surface (eg. planar mapping of side faces), any direction along it
+            t = cross(abs(objectNormal.x) < 0.9 ? vec3(1.0, 0.0, 0.0) : vec3(0.0, 1.0, 0.0), objectNormal);
+        }
+        return vec4(normalize(t), dot(cross(objectNormal, t), gradientV) < 0.0 ? -1.0 : 1.0);
+    }
+
+    // Octahedral direction from [-1, 1] square (see packVertices())
+    vec3 decodeOctahedral(vec2 e) {
+        vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+        float t = max(-n.z, 0.0);
+        n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+        return normalize(n);
+    }
+
     void main() {
-        // Calculate final render matrix (PVM)
-        gl_Position = P * V * M * vec4(position, 1.0);
+        // Packed vertex formats store positions normalized in bounding box, normal and tangent octahedral
+        vec3 objectPosition = position.xyz;
+        vec3 objectNormal = normal.xyz;
+        vec4 vertexTangent = tangent;
+        if (PositionQuantized != uint(0)) {
+            objectPosition = mix(BoundingBoxMin, BoundingBoxMax, position.xyz);
+            objectNormal = decodeOctahedral(normal.xy * 2.0 - 1.0);
+            vertexTangent = vec4(decodeOctahedral(normal.zw * 2.0 - 1.0), position.w * 2.0 - 1.0);
+        }
 
-        // Map texture by given type and axis
-        TextureUV = textureMapping(uv);
+        // Final render matrix (PVM) is calculated on CPU, instance matrix is applied in object space
+        vec4 instancePosition = InstanceM * vec4(objectPosition, 1.0);
+        gl_Position = MVP * instancePosition;
+
+        // Map texture by given type and axis (only if texture or bump map is sampled)
+    #if HAS_TEXTURE || HAS_BUMP_MAP
+        TextureUV = textureMapping(objectPosition, uv);
+    #else
+        TextureUV = vec2(0.0);
+    #endif
 
         // Calculate vertex position in global space
-        vec4 vertPos4 = M * vec4(position, 1.0);
+        vec4 vertPos4 = M * instancePosition;
         VertexPosition = vec3(vertPos4) / vertPos4.w;
 
-        // Calculate normal interpolated around vertices
-        mat4 normalMatrix = transpose(inverse(M));
-        NormalInterpolated = vec3(normalMatrix * vec4(normal, 0.0));
+        // Calculate normal interpolated around vertices (normal matrix is calculated on CPU, instances are not scaled non-uniformly)
+        NormalInterpolated = mat3(NormalMatrix) * mat3(InstanceM) * objectNormal;
+
+        // Tangent frame for normal mapping, tangents transform with model matrix
+    #if HAS_BUMP_MAP && !BUMP_FROM_HEIGHT
+        vec4 objectTangent = mappingTangent(objectPosition, normalize(objectNormal), vertexTangent, uv);
+        TangentInterpolated = vec4(mat3(M) * mat3(InstanceM) * objectTangent.xyz, objectTangent.w);
+    #else
+        TangentInterpolated = vec4(0.0);
+    #endif
+
+        MaterialIndex = InstanceMaterialIndex;
     }
 )glsl";
 
-const GLchar* WidgetOpenGLDraw::fragmentShaderSource = R"glsl(
-    #version 330 core
-    // Mesh
+// Mesh surface (bump mapped normal and material), shared by forward and geometry pass
+const GLchar* WidgetOpenGLDraw::surfaceShaderSource = R"glsl(
     uniform sampler2D Texture;
-    uniform sampler2D BumpMap;
-    // Light
-    uniform vec3 LightPos;
-    uniform float LightPower;
-    uniform vec3 LightColor;
-    // Material
-    uniform vec3 AmbientColor;
-    uniform vec3 DiffuseColor;
-    uniform vec3 SpecularColor;
-    uniform float SpecularPower; // Shininess factor
+    uniform sampler2D NormalMap; // Tangent-space normals converted from bump map heights, heights in alpha (see heightToNormalMap())
 
     in vec2 TextureUV;
     in vec3 VertexPosition;
     in vec3 NormalInterpolated;
+    in vec4 TangentInterpolated;
+    flat in uint MaterialIndex;
 
-    out vec4 outColor;
-
-    const float screenGamma = 2.2; // Assume the monitor is calibrated to the sRGB color space
-
-    // Bump mapping
+    // Bump mapping from screen-space derivatives of height (previous path, kept for comparison)
     vec3 bumpMappingFromHeight(vec3 normal, float height) {
         float bumpU = dFdx(height);
         float bumpV = dFdy(height);
@@ -180,77 +260,282 @@ const GLchar* WidgetOpenGLDraw::fragmentShaderSource = R"glsl(
         return normalize(normal + d);
     }
 
-    // Blinn-Phon shading model, gamma corrected
-    vec3 shading(vec3 normal) {
-        vec3 lightDir = LightPos - VertexPosition;
-        float distance = length(lightDir);
-        distance = distance * distance;
-        lightDir = normalize(lightDir);
-
-        float lambertian = max(dot(lightDir, normal), 0.0);
-        float specular = 0.0;
+    vec3 surfaceNormal() {
+    #if HAS_BUMP_MAP && BUMP_FROM_HEIGHT
+        float height = texture(NormalMap, TextureUV).a * sqrt(3.0);
+        return bumpMappingFromHeight(NormalInterpolated, height);
+    #elif HAS_BUMP_MAP
+        // Interpolation shortens and skews the tangent frame, tangent is orthogonalized again
+        vec3 normal = normalize(NormalInterpolated);
+        vec3 tangent = normalize(TangentInterpolated.xyz - normal * dot(normal, TangentInterpolated.xyz));
+        vec3 bitangent = (TangentInterpolated.w < 0.0 ? -1.0 : 1.0) * cross(normal, tangent);
+        vec3 tangentNormal = texture(NormalMap, TextureUV).xyz * 2.0 - 1.0;
+        return normalize(mat3(tangent, bitangent, normal) * tangentNormal);
+    #else
+        return normalize(NormalInterpolated);
+    #endif
+    }
 
-        if (lambertian > 0.0) {
-            vec3 viewDir = normalize(-VertexPosition);
+    vec4 surfaceColor() {
+    #if HAS_TEXTURE
+        return texture(Texture, TextureUV);
+    #else
+        return vec4(1.0);
+    #endif
+    }
 
-            // Blinn-Phong
-            vec3 halfDir = normalize(lightDir + viewDir);
-            float specAngle = max(dot(halfDir, normal), 0.0);
-            specular = pow(specAngle, SpecularPower);
+    // Object material or instance material from palette
+    MaterialData surfaceMaterial() {
+        MaterialData material = MaterialData(AmbientColor, DiffuseColor, SpecularColor, SpecularPower);
+        if (MaterialIndex > uint(0)) {
+            material = Palette[MaterialIndex - uint(1)];
         }
+        return material;
+    }
+)glsl";
 
-        vec3 colorLinear = AmbientColor +
-                           DiffuseColor * lambertian * LightColor * LightPower / distance +
-                           SpecularColor * specular * LightColor * LightPower / distance;
+// Clustered point lights, shared by forward and deferred lighting pass
+const GLchar* WidgetOpenGLDraw::lightingShaderSource = R"glsl(
+    // Lights of fragment's cluster (screen tile and depth slice), see LightClusters
+    uniform samplerBuffer Lights; // Position and radius, color * power
+    uniform usamplerBuffer ClusterRanges; // Offset and count into cluster lights
+    uniform usamplerBuffer ClusterLights;
+
+    const uvec3 ClusterGrid = uvec3(16, 9, 24); // clusterGridX, Y, Z
+    const float screenGamma = 2.2; // Assume the monitor is calibrated to the sRGB color space
+
+    uvec2 clusterLightRange(vec3 position) {
+        float depth = -(V * vec4(position, 1.0)).z;
+        float slice = (ClusterLogDepth != uint(0) ? log(max(depth, 1e-6)) : depth) * ClusterDepthScale + ClusterDepthBias;
+        ivec3 cell = ivec3(ivec2(gl_FragCoord.xy / ViewportSize * vec2(ClusterGrid.xy)), int(slice));
+        cell = clamp(cell, ivec3(0), ivec3(ClusterGrid) - 1);
+        int cluster = (cell.z * int(ClusterGrid.y) + cell.y) * int(ClusterGrid.x) + cell.x;
+        return texelFetch(ClusterRanges, cluster).xy;
+    }
+
+    // Blinn-Phon shading model over cluster's point lights at world position, gamma corrected
+    vec3 shading(vec3 position, vec3 normal, MaterialData material) {
+        vec3 colorLinear = material.AmbientColor;
+        vec3 viewDir = normalize(-position);
+
+        uvec2 range = clusterLightRange(position);
+        for (uint i = uint(0); i < range.y; ++i) {
+            int light = int(texelFetch(ClusterLights, int(range.x + i)).x);
+            vec4 positionRadius = texelFetch(Lights, light * 2);
+            vec3 lightColor = texelFetch(Lights, light * 2 + 1).rgb;
+
+            vec3 lightDir = positionRadius.xyz - position;
+            float distance = dot(lightDir, lightDir);
+            lightDir = normalize(lightDir);
+
+            // Inverse square falloff, smoothly windowed to zero at light radius
+            float window = clamp(1.0 - pow(distance / (positionRadius.w * positionRadius.w), 2.0), 0.0, 1.0);
+            float attenuation = window * window / distance;
+
+            float lambertian = max(dot(lightDir, normal), 0.0);
+            float specular = 0.0;
+
+            if (lambertian > 0.0) {
+                // Blinn-Phong
+                vec3 halfDir = normalize(lightDir + viewDir);
+                float specAngle = max(dot(halfDir, normal), 0.0);
+                specular = pow(specAngle, material.SpecularPower);
+            }
+
+            colorLinear += (material.DiffuseColor * lambertian + material.SpecularColor * specular) * lightColor * attenuation;
+        }
 
         // Apply gamma correction (assume AmbientColor, DiffuseColor and SpecularColor
         // have been linearized, i.e. have no gamma correction in them)
         return pow(colorLinear, vec3(1.0 / screenGamma));
     }
+)glsl";
+
+// Forward shading, lit as drawn
+const GLchar* WidgetOpenGLDraw::fragmentShaderSource = R"glsl(
+    out vec4 outColor;
 
     void main() {
         // Apply bump mapping
-        float height = length(texture2D(BumpMap, TextureUV.st).xyz);
-        vec3 normal = bumpMappingFromHeight(NormalInterpolated, height);
+        vec3 normal = surfaceNormal();
+        MaterialData material = surfaceMaterial();
 
         // Apply lighting/shading/reflection
-        vec3 colorGammaCorrected = shading(normal);
+        vec3 colorGammaCorrected = shading(VertexPosition, normal, material);
 
         // Apply texture and use the gamma corrected color in the fragment
-        outColor = texture(Texture, TextureUV) * vec4(colorGammaCorrected, 1.0);
+        outColor = surfaceColor() * vec4(colorGammaCorrected, 1.0);
+    }
+)glsl";
+
+// Deferred shading geometry pass, surface attributes into G-buffer (see GBufferAttachment)
+const GLchar* WidgetOpenGLDraw::geometryFragmentShaderSource = R"glsl(
+    layout(location=0) out vec4 outAlbedo;
+    layout(location=1) out vec4 outDiffuse;
+    layout(location=2) out vec4 outSpecular;
+    layout(location=3) out vec4 outNormal;
+
+    // Octahedral normal encoding, 2 components in [-1, 1]
+    vec2 encodeNormal(vec3 n) {
+        n /= abs(n.x) + abs(n.y) + abs(n.z);
+        if (n.z < 0.0) {
+            n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+        }
+        return n.xy;
+    }
+
+    void main() {
+        MaterialData material = surfaceMaterial();
+        outAlbedo = vec4(surfaceColor().rgb, material.AmbientColor.r);
+        outDiffuse = vec4(material.DiffuseColor, material.AmbientColor.g);
+        outSpecular = vec4(material.SpecularColor, material.AmbientColor.b);
+        outNormal = vec4(encodeNormal(surfaceNormal()) * 0.5 + 0.5, material.SpecularPower / 1023.0, 0.0);
+    }
+)glsl";
+
+// Deferred shading lighting pass, triangle covering the screen without vertex attributes
+const GLchar* WidgetOpenGLDraw::fullscreenVertexShaderSource = R"glsl(
+    void main() {
+        gl_Position = vec4(gl_VertexID == 1 ? 3.0 : -1.0, gl_VertexID == 2 ? 3.0 : -1.0, 0.0, 1.0);
     }
 )glsl";
 
+// Deferred shading lighting pass, each pixel is shaded once
+const GLchar* WidgetOpenGLDraw::deferredFragmentShaderSource = R"glsl(
+    uniform sampler2D GBufferAlbedo;
+    uniform sampler2D GBufferDiffuse;
+    uniform sampler2D GBufferSpecular;
+    uniform sampler2D GBufferNormal;
+    uniform sampler2D GBufferDepth;
+
+    out vec4 outColor;
+
+    vec3 decodeNormal(vec2 e) {
+        vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+        float t = max(-n.z, 0.0);
+        n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+        return normalize(n);
+    }
+
+    void main() {
+        ivec2 pixel = ivec2(gl_FragCoord.xy);
+        float depth = texelFetch(GBufferDepth, pixel, 0).r;
+        if (depth == 1.0) {
+            discard; // Nothing drawn, keep clear color
+        }
+
+        // World position from depth
+        vec4 clipPosition = vec4(gl_FragCoord.xy / ViewportSize * 2.0 - 1.0, depth * 2.0 - 1.0, 1.0);
+        vec4 position = InversePV * clipPosition;
+
+        vec4 albedo = texelFetch(GBufferAlbedo, pixel, 0);
+        vec4 diffuse = texelFetch(GBufferDiffuse, pixel, 0);
+        vec4 specular = texelFetch(GBufferSpecular, pixel, 0);
+        vec4 normal = texelFetch(GBufferNormal, pixel, 0);
+        MaterialData material = MaterialData(vec3(albedo.a, diffuse.a, specular.a), diffuse.rgb, specular.rgb, normal.z * 1023.0);
+
+        vec3 colorGammaCorrected = shading(position.xyz / position.w, decodeNormal(normal.xy * 2.0 - 1.0), material);
+        outColor = vec4(albedo.rgb * colorGammaCorrected, 1.0);
+    }
+)glsl";
+
+GLuint WidgetOpenGLDraw::compileProgram(const std::vector<const GLchar *> &vertexSources, const std::vector<const GLchar *> &fragmentSources, const GLchar *defines) {
+    // Shaders are prepended with version, defines and uniform blocks
+    std::vector<const GLchar *> shaderSources[2];
+    const std::vector<const GLchar *> *sources[2] = {&vertexSources, &fragmentSources};
+    for (int i = 0; i < 2; ++i) {
+        shaderSources[i] = {shaderVersionSource, defines, variantDefaultsSource, uniformBlocksSource};
+        shaderSources[i].insert(shaderSources[i].end(), sources[i]->begin(), sources[i]->end());
+    }
+
+    // Binary linked on an earlier launch skips compilation, bindings and sampler units are not part of it
+    uint64_t key = programCache.programKey(shaderSources[0], shaderSources[1]);
+    GLuint program = programCache.load(key);
+    if (program != 0) {
+        uniformBuffers.bindProgram(program);
+        setProgramTextureUnits(program);
+        return program;
+    }
+
+    program = gl.glCreateProgram();
+    programCache.prepare(program);
+
+    // Create and compile shaders
+    GLuint shaders[2];
+    const GLenum types[2] = {GL_VERTEX_SHADER, GL_FRAGMENT_SHADER};
+    for (int i = 0; i < 2; ++i) {
+        shaders[i] = gl.glCreateShader(types[i]);
+        gl.glShaderSource(shaders[i], static_cast<GLsizei>(shaderSources[i].size()), shaderSources[i].data(), nullptr);
+        gl.glCompileShader(shaders[i]);
+        gl.glAttachShader(program, shaders[i]);
+    }
+
+    // Link created shader program, shaders are not needed afterwards
+    gl.glLinkProgram(program);
+
+    // Info logs are printed only on failure
+    for (GLuint shader : shaders) {
+        GLint compiled = GL_FALSE;
+        gl.glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+        if (compiled != GL_TRUE) {
+            printShaderInfoLog(shader);
+        }
+        gl.glDetachShader(program, shader);
+        gl.glDeleteShader(shader);
+    }
+
+    GLint linked = GL_FALSE;
+    gl.glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (linked != GL_TRUE) {
+        printProgramInfoLog(program);
+        std::cerr << "Shader program linking failed! [" << defines << "]" << std::endl;
+        gl.glDeleteProgram(program);
+        return 0;
+    }
+    programCache.store(key, program);
+
+    // Uniforms are set up once, per-frame and per-object data comes from uniform buffers
+    uniformBuffers.bindProgram(program);
+    setProgramTextureUnits(program);
+    return program;
+}
+
+GLuint WidgetOpenGLDraw::compileMeshProgram(bool deferred, const GLchar *defines) {
+    if (deferred) {
+        return compileProgram({vertexShaderSource}, {surfaceShaderSource, geometryFragmentShaderSource}, defines);
+    }
+    return compileProgram({vertexShaderSource}, {surfaceShaderSource, lightingShaderSource, fragmentShaderSource}, defines);
+}
+
+void WidgetOpenGLDraw::setProgramTextureUnits(GLuint program) {
+    // Texture units: 0-1 mesh, 2-4 lights, 5-9 G-buffer (samplers a program doesn't use have no location and are skipped)
+    const char *samplers[] = {"Texture", "NormalMap", "Lights", "ClusterRanges", "ClusterLights",
+                              "GBufferAlbedo", "GBufferDiffuse", "GBufferSpecular", "GBufferNormal", "GBufferDepth"};
+    gl.glUseProgram(program);
+    for (GLint unit = 0; unit < static_cast<GLint>(sizeof(samplers) / sizeof(samplers[0])); ++unit) {
+        GLint location = gl.glGetUniformLocation(program, samplers[unit]);
+        if (location >= 0) {
+            gl.glUniform1i(location, unit);
+        }
+    }
+}
+
 void WidgetOpenGLDraw::compileShaders() {
-    programShaderID = gl.glCreateProgram();
-
-    // Create and compile the vertex shader
-    vertexShaderID = gl.glCreateShader(GL_VERTEX_SHADER);
-    std::cout << vertexShaderSource;
-    gl.glShaderSource(vertexShaderID, 1, &vertexShaderSource, nullptr);
-    gl.glCompileShader(vertexShaderID);
-    gl.glAttachShader(programShaderID, vertexShaderID);
-
-    // Create and compile the fragment shader
-    fragmentShaderID = gl.glCreateShader(GL_FRAGMENT_SHADER);
-    std::cout << fragmentShaderSource;
-    gl.glShaderSource(fragmentShaderID, 1, &fragmentShaderSource, nullptr);
-    gl.glCompileShader(fragmentShaderID);
-    gl.glAttachShader(programShaderID, fragmentShaderID);
-
-    // Link and use created shader program
-    gl.glLinkProgram(programShaderID);
+    // Forward shading and deferred shading passes, mesh programs branch on object uniforms (specialized variants are compiled on demand)
+    programShaderID = compileMeshProgram(false);
+    geometryProgramID = compileMeshProgram(true);
+    deferredProgramID = compileProgram({fullscreenVertexShaderSource}, {lightingShaderSource, deferredFragmentShaderSource});
     gl.glUseProgram(programShaderID);
 
-    // Print compiled shaders and program
-    printShaderInfoLog(vertexShaderID);
-    printShaderInfoLog(fragmentShaderID);
-    printProgramInfoLog(programShaderID);
+    meshPrograms.initialize(&gl, [this](const ShaderVariant &variant) {
+        return compileMeshProgram(variant.deferred, variant.defines().c_str());
+    });
 }
 
 void WidgetOpenGLDraw::initializeGL() {
-    // Load OpenGL functions
-    std::cout << "OpenGL context version: " << context()->format().majorVersion() << "." << context()->format().minorVersion() << std::endl;
+    // Load OpenGL functions (widget's own context, or the one made current for headless rendering)
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+    std::cout << "OpenGL context version: " << context->format().majorVersion() << "." << context->format().minorVersion() << std::endl;
 
     if (!gl.initializeOpenGLFunctions()) {
         std::cerr << "Required openGL not supported" << std::endl;
@@ -261,67 +546,99 @@ void WidgetOpenGLDraw::initializeGL() {
     std::cout << gl.glGetString(GL_VERSION) << std::endl;
     std::cout << gl.glGetString(GL_RENDERER) << std::endl;
 
+    profiler.initialize(&gl);
+    uniformBuffers.initialize(&gl);
+    lightClusters.initialize(&gl);
+    gBuffer.initialize(&gl);
+    gl.glGenVertexArrays(1, &fullscreenVAO);
+    meshBuffer.initialize(&gl);
+    assetCache.initialize(&gl, &meshBuffer);
+    programCache.initialize(&gl, programCacheDirectory);
     compileShaders();
 
+    // Instance attributes of VAOs without instancing come from generic attribute values (identity, object material)
+    for (GLuint column = 0; column < 4; ++column) {
+        glm::vec4 value(0.0f);
+        value[static_cast<int>(column)] = 1.0f;
+        gl.glVertexAttrib4f(3 + column, value.x, value.y, value.z, value.w);
+    }
+    gl.glVertexAttribI4ui(7, 0, 0, 0, 0);
+
     // In case we drive more overlapping triangles, we want front to cover the ones in the back
     glEnable(GL_DEPTH_TEST);
 
     // Draw only one side of triangles
     glEnable(GL_CULL_FACE);
 
+    // Anisotropic filtering is an extension in OpenGL 3.3
+    if (context->hasExtension("GL_EXT_texture_filter_anisotropic") || context->hasExtension("GL_ARB_texture_filter_anisotropic")) {
+        gl.glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &maxAnisotropy);
+    }
+
+    // Texture uploads go through pixel buffers, objects use placeholders until their textures are uploaded
+    pixelUploadRing.initialize(&gl);
+    gl.glGenTextures(2, placeholderTBO);
+    QImage placeholder(1, 1, QImage::Format_ARGB32);
+    std::vector<QImage> placeholderMipmaps; // Single level
+    placeholder.fill(Qt::white);
+    uploadTextureImage(placeholderTBO[0], placeholder, placeholderMipmaps);
+    placeholder.fill(qRgba(128, 128, 255, 0)); // Normal along surface normal, constant height
+    uploadTextureImage(placeholderTBO[1], placeholder, placeholderMipmaps);
+
     // Define data (test objects)
-    light = {
-        "Light", {0.0f, 2.0f, 0.0f}, 40.0f
+    lights = {
+        LightObject("Light", {0.0f, 2.0f, 0.0f}, 40.0f)
     };
 
-    objects = {
+    MeshObject ground(
+        "Ground",
         {
-            "Ground",
-            {
-                // Lighting will only work from top (ground doesn't go upside down usually)
-                {glm::vec3(-5.0f, 0.0f, 5.0f),  glm::vec2(0.0f, 1.0f), glm::vec3(0.0f, 1.0f, 0.0f)},
-                {glm::vec3(5.0f,  0.0f, 5.0f),  glm::vec2(0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f)},
-                {glm::vec3(5.0f,  0.0f, -5.0f), glm::vec2(1.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f)},
-                {glm::vec3(-5.0f, 0.0f, -5.0f), glm::vec2(1.0f, 1.0f), glm::vec3(0.0f, 1.0f, 0.0f)},
-            },
-            {0, 1, 2, 2, 3, 0}
-        }
-    };
-    applyTextureFromFile("../test/textures/bricks.jpg", 0, 0, &objects.back(), true);
-    applyBumpMapFromFile("../test/bumpMaps/bricks.jpg", &objects.back(), true);
-
-    objects.push_back(makePyramid(3, "Pyramid"));
-    objects.back().translation.x = -5.0f;
-    objects.back().translation.z = -5.0f;
-    applyBumpMapFromFile("../test/bumpMaps/leather.jpg", &objects.back(), true);
-
-    objects.push_back(makeCube("Cube"));
-    objects.back().translation.y += 2.0f;
-    objects.back().translation.z += 5.0f;
+            // Lighting will only work from top (ground doesn't go upside down usually)
+            {glm::vec3(-5.0f, 0.0f, 5.0f),  glm::vec2(0.0f, 1.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec4(0.0f)},
+            {glm::vec3(5.0f,  0.0f, 5.0f),  glm::vec2(0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec4(0.0f)},
+            {glm::vec3(5.0f,  0.0f, -5.0f), glm::vec2(1.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec4(0.0f)},
+            {glm::vec3(-5.0f, 0.0f, -5.0f), glm::vec2(1.0f, 1.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec4(0.0f)},
+        },
+        {0, 1, 2, 2, 3, 0}
+    );
+    computeTangents(ground.vertices, ground.indices);
+    ObjectHandle object = scene.add(std::move(ground));
+    applyTextureFromFile("../test/textures/bricks.jpg", 0, 0, object, true);
+    applyBumpMapFromFile("../test/bumpMaps/bricks.jpg", object, true);
+
+    Transform transform;
+    transform.translation = glm::vec3(-5.0f, 0.0f, -5.0f);
+    object = scene.add(makePyramidInstanced(3, "Pyramid"), transform);
+    applyBumpMapFromFile("../test/bumpMaps/leather.jpg", object, true);
+
+    transform.translation = glm::vec3(0.0f, 2.0f, 5.0f);
+    object = scene.add(makeCube("Cube"), transform);
     QImage cubeTex(512, 512, QImage::Format_RGB32);
     cubeTex.fill(Qt::red);
-    objects.back().textureImage = cubeTex;
-    applyBumpMapFromFile("../test/bumpMaps/dots.jpg", &objects.back(), true);
+    scene.find(object)->textureImage = cubeTex;
+    applyBumpMapFromFile("../test/bumpMaps/dots.jpg", object, true);
 
     QStringList paths = {"../test/models/icoSphere.obj"};
     loadModelsFromFile(paths, true);
-    objects.back().name = "IcoSphere";
-    objects.back().translation.x = -1.0f;
-    applyTextureFromFile("../test/textures/steelMesh.jpg", 0, 0, &objects.back(), true);
-    applyBumpMapFromFile("../test/bumpMaps/metalScales.jpg", &objects.back(), true);
+    object = scene.handle(scene.size() - 1);
+    scene.find(object)->name = "IcoSphere";
+    transform.translation = glm::vec3(-1.0f, 0.0f, 0.0f);
+    scene.setTransform(object, transform);
+    applyTextureFromFile("../test/textures/steelMesh.jpg", 0, 0, object, true);
+    applyBumpMapFromFile("../test/bumpMaps/metalScales.jpg", object, true);
 
     // Connect object selection ComboBox and fill it
     QObject::connect(objectSelection, SIGNAL(currentIndexChanged(int)), this, SLOT(selectObject(int)));
 
     // Add light to object selection dropdown and make it first selected object (same as ComboBox)
-    objectSelection->addItem(light.name);
-    selectedObject = &light;
+    objectSelection->addItem(lights.front().name);
+    selectedObject = ObjectHandle();
 
     // Buffer data to GPU
-    for (auto &object : objects) {
-        generateObjectBuffers(object);
-        loadObjectTexture(object);
-        loadObjectBumpMap(object);
+    for (size_t i = 0; i < scene.size(); ++i) {
+        loadObjectTexture(scene.objects[i]);
+        loadObjectBumpMap(scene.objects[i]);
+        generateObjectBuffers(scene.handle(i));
     }
 
     // Set background color
@@ -333,31 +650,184 @@ void WidgetOpenGLDraw::initializeGL() {
     }
 }
 
-void WidgetOpenGLDraw::generateObjectBuffers(MeshObject &object) {
-    // Create Vertex Array Object, carrying properties related with buffer (eg. state of glEnableVertexAttribArray etc.)
-    gl.glGenVertexArrays(1, &object.VAO);
-    gl.glBindVertexArray(object.VAO);
+void WidgetOpenGLDraw::generateObjectBuffers(ObjectHandle handle) {
+    MeshObject &object = *scene.find(handle);
+
+    // Same mesh (model file or generator) is stored on GPU only once, all meshes share mesh buffer
+    object.mesh = assetCache.findMesh(object.meshKey);
+    if (!object.mesh) {
+        GpuMesh mesh;
+        mesh.vertexCount = object.vertexCount();
+        mesh.indexCount = object.indexCount();
+        mesh.levels = object.levels;
+        if (mesh.levels.empty()) {
+            mesh.levels.push_back({0, static_cast<uint32_t>(mesh.indexCount), 0.0f});
+        }
+
+        // Levels of detail follow original indices, sharing vertices
+        const GLuint *indices = object.indexData();
+        size_t indexCount = mesh.indexCount + object.levelIndices.size();
+        std::vector<GLuint> allIndices;
+        if (!object.levelIndices.empty()) {
+            allIndices.reserve(indexCount);
+            allIndices.insert(allIndices.end(), indices, indices + mesh.indexCount);
+            allIndices.insert(allIndices.end(), object.levelIndices.begin(), object.levelIndices.end());
+            indices = allIndices.data();
+        }
+
+        // Bounds for culling, texture mapping and position quantization
+        computeBoundingBox(object, mesh);
+        object.mesh = uploadMesh(object.meshKey, mesh, object.vertexData(), indices, indexCount);
+    }
+
+    // Uploaded (or already resident), release memory
+    std::vector<Vertex>().swap(object.vertices);
+    std::vector<GLuint>().swap(object.indices);
+    std::vector<GLuint>().swap(object.levelIndices);
+    object.mappedMesh.reset();
+
+    // Create Instance Buffer and load per-instance attributes into it (advanced once per instance)
+    if (!object.instances.empty()) {
+        gl.glGenBuffers(1, &object.instanceVBO);
+        gl.glBindBuffer(GL_ARRAY_BUFFER, object.instanceVBO);
+        gl.glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(object.instances.size() * sizeof(InstanceData)), object.instances.data(), GL_STATIC_DRAW);
+        profiler.addUploadedBytes(object.instances.size() * sizeof(InstanceData));
+
+        gl.glGenVertexArrays(1, &object.instanceVAO);
+        setupInstanceVertexArray(object);
+    }
+
+    // Mesh bounds placed at each instance
+    glm::vec3 instancesBoundingBoxMin = object.mesh->boundingBoxMin;
+    glm::vec3 instancesBoundingBoxMax = object.mesh->boundingBoxMax;
+    if (!object.instances.empty()) {
+        instancesBoundingBoxMin = {INFINITY, INFINITY, INFINITY};
+        instancesBoundingBoxMax = {-INFINITY, -INFINITY, -INFINITY};
+        for (auto &instance : object.instances) {
+            glm::vec3 center, extent;
+            transformBounds(instance.M, object.mesh->boundingBoxMin, object.mesh->boundingBoxMax, center, extent);
+            instancesBoundingBoxMin = glm::min(instancesBoundingBoxMin, center - extent);
+            instancesBoundingBoxMax = glm::max(instancesBoundingBoxMax, center + extent);
+        }
+    }
+    scene.setBounds(handle, instancesBoundingBoxMin, instancesBoundingBoxMax);
+
+    // Procedural mapping chosen before upload (eg. preloaded texture)
+    if (isProceduralMapping(object.textureMappingType)) {
+        updateTextureMapping(object);
+    }
+    updateRenderData(handle);
+
+    // Add to object selection dropdown, item keeps handle (dense index changes as objects are removed)
+    objectSelection->addItem(object.name, QVariant(static_cast<qulonglong>(handle.packed())));
+}
+
+std::shared_ptr<GpuMesh> WidgetOpenGLDraw::uploadMesh(const QString &key, GpuMesh mesh, const Vertex *vertices, const GLuint *indices, size_t indexCount) {
+    // Optionally packed vertices and 16-bit indices where vertex count allows them, otherwise data (eg. mapped cache) goes to buffer as is
+    VertexFormat vertexFormat = VERTEX_FORMAT_FLOAT;
+    const void *vertexData = vertices;
+    std::vector<PackedVertex> packedVertices;
+    if (quantizeVertices) {
+        vertexFormat = packVertices(vertices, mesh.vertexCount, mesh.boundingBoxMin, mesh.boundingBoxMax, packedVertices);
+        vertexData = packedVertices.data();
+    }
+    GLenum indexType = GL_UNSIGNED_INT;
+    const void *indexData = indices;
+    std::vector<uint16_t> shortIndices;
+    if (quantizeVertices && mesh.vertexCount <= maxShortIndexVertices) {
+        packIndices(indices, indexCount, shortIndices);
+        indexType = GL_UNSIGNED_SHORT;
+        indexData = shortIndices.data();
+    }
+
+    mesh.bytes = mesh.vertexCount * vertexFormatSize(vertexFormat) + indexCount * indexTypeSize(indexType);
+    mesh.handle = meshBuffer.add(vertexFormat, vertexData, mesh.vertexCount, indexType, indexData, indexCount);
+    profiler.addUploadedBytes(mesh.bytes);
+
+    return assetCache.addMesh(key, mesh);
+}
+
+void WidgetOpenGLDraw::updateTextureMapping(MeshObject &object) {
+    if (!object.mesh) {
+        return; // Baked when buffers are generated
+    }
+
+    // Original mesh is kept while a baked one is drawn, mapping may change again
+    std::shared_ptr<GpuMesh> source = object.sourceMesh ? object.sourceMesh : object.mesh;
+    std::shared_ptr<GpuMesh> mesh = source;
+    if (bakeTextureMappings && isProceduralMapping(object.textureMappingType)) {
+        QString key;
+        if (!object.meshKey.isEmpty()) {
+            key = object.meshKey + QString("#mapping%1,%2").arg(object.textureMappingType).arg(object.textureMappingAxis);
+        }
+        mesh = assetCache.findMesh(key);
+        if (!mesh) {
+            mesh = bakeMeshMapping(*source, object.textureMappingType, object.textureMappingAxis, key);
+        }
+    }
+
+    object.sourceMesh = mesh != source ? source : nullptr;
+    if (mesh == object.mesh) {
+        return;
+    }
+    object.mesh = mesh;
+
+    // Baked mesh may have another vertex format (mesh buffer's VAO is taken by updateRenderData())
+    if (!object.instances.empty()) {
+        setupInstanceVertexArray(object);
+    }
+}
 
-    // Create and bind Vertex Buffer and load vertices into it
-    gl.glGenBuffers(1, &object.VBO);
-    gl.glBindBuffer(GL_ARRAY_BUFFER, object.VBO);
-    gl.glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(object.vertices.size() * sizeof(Vertex)), &object.vertices.front(), GL_STATIC_DRAW);
+std::shared_ptr<GpuMesh> WidgetOpenGLDraw::bakeMeshMapping(const GpuMesh &source, GLuint mappingType, GLuint mappingAxis, const QString &key) {
+    // Source vertices were released after upload, read them back once (including levels of detail, they share vertices)
+    std::vector<uint8_t> vertexData;
+    std::vector<GLuint> indices;
+    meshBuffer.read(source.handle, vertexData, indices);
 
-    // Create and bind Index Buffer and load vertex indices into it
-    gl.glGenBuffers(1, &object.IBO);
-    gl.glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, object.IBO);
-    gl.glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(object.indices.size() * sizeof(GLuint)), &object.indices.front(), GL_STATIC_DRAW);
+    const MeshRange &range = meshBuffer.range(source.handle);
+    std::vector<Vertex> vertices(source.vertexCount);
+    if (range.vertexFormat == VERTEX_FORMAT_FLOAT) {
+        memcpy(vertices.data(), vertexData.data(), vertices.size() * sizeof(Vertex));
+    } else {
+        const PackedVertex *packed = reinterpret_cast<const PackedVertex *>(vertexData.data());
+        for (size_t i = 0; i < vertices.size(); ++i) {
+            vertices[i] = unpackVertex(packed[i], range.vertexFormat, source.boundingBoxMin, source.boundingBoxMax);
+        }
+    }
 
-    // Setup vertex attributes (specify layout of vertex data)
-    gl.glEnableVertexAttribArray(0);  // We use: layout(location=0) and vec3 position;
-    gl.glEnableVertexAttribArray(1);  // We use: layout(location=1) and vec2 uv;
-    gl.glEnableVertexAttribArray(2);  // We use: layout(location=2) and vec3 normal;
-    gl.glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<void *>(offsetof(Vertex, position)));
-    gl.glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<void *>(offsetof(Vertex, uv)));
-    gl.glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<void *>(offsetof(Vertex, normal)));
+    // Positions (and bounds) are unchanged, triangles across U seam get own vertices, tangents follow new UVs
+    bakeTextureMapping(vertices.data(), vertices.size(), mappingType, mappingAxis, source.boundingBoxMin, source.boundingBoxMax);
+    if (isAngularMapping(mappingType)) {
+        splitMappingSeams(vertices, indices);
+    }
+    computeTangents(vertices, indices);
+
+    GpuMesh mesh;
+    mesh.vertexCount = vertices.size();
+    mesh.indexCount = source.indexCount;
+    mesh.levels = source.levels;
+    mesh.boundingBoxMin = source.boundingBoxMin;
+    mesh.boundingBoxMax = source.boundingBoxMax;
+    return uploadMesh(key, mesh, vertices.data(), indices.data(), indices.size());
+}
 
-    // Create Texture Buffer
-    gl.glGenTextures(2, object.TBO);
+void WidgetOpenGLDraw::setupInstanceVertexArray(MeshObject &object) {
+    // Vertex Array Object, carrying properties related with buffer (eg. state of glEnableVertexAttribArray etc.)
+    gl.glBindVertexArray(object.instanceVAO);
+    gl.glBindBuffer(GL_ARRAY_BUFFER, meshBuffer.vertexBuffer());
+    gl.glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, meshBuffer.indexBuffer());
+    setupVertexAttributes(&gl, meshBuffer.range(object.mesh->handle).vertexFormat);
+
+    gl.glBindBuffer(GL_ARRAY_BUFFER, object.instanceVBO);
+    for (GLuint column = 0; column < 4; ++column) {
+        gl.glEnableVertexAttribArray(3 + column); // We use: layout(location=3) and mat4 InstanceM;
+        gl.glVertexAttribPointer(3 + column, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), reinterpret_cast<void *>(offsetof(InstanceData, M) + column * sizeof(glm::vec4)));
+        gl.glVertexAttribDivisor(3 + column, 1);
+    }
+    gl.glEnableVertexAttribArray(7); // We use: layout(location=7) and uint InstanceMaterialIndex;
+    gl.glVertexAttribIPointer(7, 1, GL_UNSIGNED_INT, sizeof(InstanceData), reinterpret_cast<void *>(offsetof(InstanceData, materialIndex)));
+    gl.glVertexAttribDivisor(7, 1);
+    object.instanceVAOGeneration = meshBuffer.generation();
 
 #ifdef QT_DEBUG
     // Unbind to avoid accidental modification
@@ -365,138 +835,398 @@ void WidgetOpenGLDraw::generateObjectBuffers(MeshObject &object) {
     gl.glBindBuffer(GL_ARRAY_BUFFER, 0);
     gl.glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 #endif
+}
 
-    // Add to object selection dropdown
-    objectSelection->addItem(object.name);
+void WidgetOpenGLDraw::updateRenderData(ObjectHandle handle) {
+    size_t i = scene.index(handle);
+    if (i == Scene::npos || !scene.objects[i].mesh) {
+        return; // Taken when buffers are generated
+    }
+    const MeshObject &object = scene.objects[i];
+    RenderArrays &render = scene.render;
+
+    render.textureMappingType[i] = object.sourceMesh ? textureMappingSimple : object.textureMappingType; // Baked UVs are passed through
+    render.textureMappingAxis[i] = object.sourceMesh ? 0 : object.textureMappingAxis;
+    render.boundingBoxMin[i] = object.mesh->boundingBoxMin;
+    render.boundingBoxMax[i] = object.mesh->boundingBoxMax;
+    render.range[i] = meshBuffer.range(object.mesh->handle);
+    render.VAO[i] = object.instances.empty() ? meshBuffer.VAO(render.range[i].vertexFormat) : object.instanceVAO;
+    render.texture[i] = object.texture ? object.texture->texture : 0;
+    render.bumpMap[i] = object.bumpMap ? object.bumpMap->texture : 0;
+    render.instanceCount[i] = static_cast<GLsizei>(object.instances.size());
+
+    // Another mesh starts from its original level
+    if (render.levels[i] != &object.mesh->levels) {
+        render.levels[i] = &object.mesh->levels;
+        render.level[i] = 0;
+    }
+}
+
+void WidgetOpenGLDraw::computeBoundingBox(MeshObject &object, GpuMesh &mesh) {
+    if (object.mappedMesh) {
+        // Stored in mesh cache
+        mesh.boundingBoxMin = object.mappedMesh->boundingBoxMin();
+        mesh.boundingBoxMax = object.mappedMesh->boundingBoxMax();
+    } else {
+        mesh.boundingBoxMin = {INFINITY, INFINITY, INFINITY};
+        mesh.boundingBoxMax = {-INFINITY, -INFINITY, -INFINITY};
+        for (auto &vertex : object.vertices) {
+            mesh.boundingBoxMin = {std::min(vertex.position.x, mesh.boundingBoxMin.x),
+                                   std::min(vertex.position.y, mesh.boundingBoxMin.y),
+                                   std::min(vertex.position.z, mesh.boundingBoxMin.z)};
+
+            mesh.boundingBoxMax = {std::max(vertex.position.x, mesh.boundingBoxMax.x),
+                                   std::max(vertex.position.y, mesh.boundingBoxMax.y),
+                                   std::max(vertex.position.z, mesh.boundingBoxMax.z)};
+        }
+    }
 }
 
 void WidgetOpenGLDraw::loadObjectTexture(MeshObject &object) {
+    // Same image already uploaded since it was applied
+    std::shared_ptr<GpuTexture> texture = assetCache.findTexture(object.textureKey, false);
+    if (texture) {
+        object.texture = texture;
+        object.textureImage = QImage();
+        std::vector<QImage>().swap(object.textureMipmaps);
+        return;
+    }
+
     if (object.textureImage.isNull()) {
-        std::cerr << "Loading object texture failed! No texture image loaded for object! [" << object.name.toStdString() << "]" << std::endl;
+        if (!object.texture) {
+            std::cerr << "Loading object texture failed! No texture image loaded for object! [" << object.name.toStdString() << "]" << std::endl;
+        }
         return;
     }
 
     // Bind Texture Buffer and load texture into it
-    gl.glBindTexture(GL_TEXTURE_2D, object.TBO[0]);
-    gl.glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, object.textureImage.width(), object.textureImage.height(), 0, GL_BGRA, GL_UNSIGNED_BYTE, object.textureImage.bits());
-
-    gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR); // Use linear filtering for upscaled textures
-    gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST); // Use nearest neighbour filtering for downscaled textures
-
-#ifdef QT_DEBUG
-    // Unbind to avoid accidental modification
-    gl.glBindTexture(GL_TEXTURE_2D, 0);
-#endif
-
-    // Calculate bounding box
-    object.boundingBoxMin = {INFINITY, INFINITY, INFINITY};
-    object.boundingBoxMax = {-INFINITY, -INFINITY, -INFINITY};
-    for (auto &vertex : object.vertices) {
-        object.boundingBoxMin = {std::min(vertex.position.x, object.boundingBoxMin.x),
-                                 std::min(vertex.position.y, object.boundingBoxMin.y),
-                                 std::min(vertex.position.z, object.boundingBoxMin.z)};
-
-        object.boundingBoxMax = {std::max(vertex.position.x, object.boundingBoxMax.x),
-                                 std::max(vertex.position.y, object.boundingBoxMax.y),
-                                 std::max(vertex.position.z, object.boundingBoxMax.z)};
-    }
+    object.texture = uploadTexture(object.textureKey, object.textureImage, object.textureMipmaps);
 }
 
 void WidgetOpenGLDraw::loadObjectBumpMap(MeshObject &object) {
+    std::shared_ptr<GpuTexture> bumpMap = assetCache.findTexture(object.bumpMapKey, false);
+    if (bumpMap) {
+        object.bumpMap = bumpMap;
+        object.bumpMapImage = QImage();
+        std::vector<QImage>().swap(object.bumpMapMipmaps);
+        return;
+    }
+
     if (object.bumpMapImage.isNull()) {
-        std::cerr << "Loading object bump map failed! No bump map image loaded for object! [" << object.name.toStdString() << "]" << std::endl;
+        if (!object.bumpMap) {
+            std::cerr << "Loading object bump map failed! No bump map image loaded for object! [" << object.name.toStdString() << "]" << std::endl;
+        }
         return;
     }
 
     // Bind Texture Buffer and load bump map into it
-    gl.glBindTexture(GL_TEXTURE_2D, object.TBO[1]);
-    gl.glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, object.bumpMapImage.width(), object.bumpMapImage.height(), 0, GL_BGRA, GL_UNSIGNED_BYTE, object.bumpMapImage.bits());
+    object.bumpMap = uploadTexture(object.bumpMapKey, object.bumpMapImage, object.bumpMapMipmaps);
+}
+
+std::shared_ptr<GpuTexture> WidgetOpenGLDraw::uploadTexture(const QString &key, QImage &image, std::vector<QImage> &mipmaps) {
+    GpuTexture texture;
+    gl.glGenTextures(1, &texture.texture);
+    texture.bytes = uploadTextureImage(texture.texture, image, mipmaps);
+    profiler.addUploadedBytes(texture.bytes);
+    image = QImage(); // Uploaded, release memory
+
+    return assetCache.addTexture(key, texture);
+}
+
+size_t WidgetOpenGLDraw::uploadTextureImage(GLuint texture, const QImage &image, std::vector<QImage> &mipmaps) {
+    // Images not decoded by texture loader (eg. generated) don't have their mip chain yet
+    if (textureLoader.cpuMipmaps && mipmaps.empty()) {
+        mipmaps = generateMipmaps(image);
+    }
+
+    // Allocate storage and stream pixels in through pixel buffer ring
+    gl.glBindTexture(GL_TEXTURE_2D, texture);
+    gl.glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image.width(), image.height(), 0, GL_BGRA, GL_UNSIGNED_BYTE, nullptr);
+    pixelUploadRing.upload(0, image.width(), image.height(), image.constBits());
+    size_t bytes = static_cast<size_t>(image.width()) * static_cast<size_t>(image.height()) * 4;
+
+    if (textureLoader.cpuMipmaps) {
+        for (size_t i = 0; i < mipmaps.size(); ++i) {
+            GLint level = static_cast<GLint>(i) + 1;
+            gl.glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, mipmaps[i].width(), mipmaps[i].height(), 0, GL_BGRA, GL_UNSIGNED_BYTE, nullptr);
+            pixelUploadRing.upload(level, mipmaps[i].width(), mipmaps[i].height(), mipmaps[i].constBits());
+            bytes += static_cast<size_t>(mipmaps[i].width()) * static_cast<size_t>(mipmaps[i].height()) * 4;
+        }
+        gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(mipmaps.size()));
+        std::vector<QImage>().swap(mipmaps); // Uploaded, release memory
+    } else {
+        gl.glGenerateMipmap(GL_TEXTURE_2D);
+        bytes += bytes / 3; // Full chain adds a third
+    }
 
-    gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    // Trilinear filtering, minified textures sample from the 2 nearest mip levels
+    gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR); // Use linear filtering for upscaled textures
+    gl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    if (maxAnisotropy > 0.0f) {
+        gl.glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, std::max(1.0f, std::min(anisotropy, maxAnisotropy)));
+    }
 
 #ifdef QT_DEBUG
     // Unbind to avoid accidental modification
     gl.glBindTexture(GL_TEXTURE_2D, 0);
 #endif
+
+    return bytes;
 }
 
 void WidgetOpenGLDraw::resizeGL(int w, int h) {
     gl.glViewport(0, 0, w, h);
 }
 
+void WidgetOpenGLDraw::initializeOffscreen(int width, int height) {
+    // Hidden widget has no context of its own, makeCurrent() and doneCurrent() do nothing and the current one is used
+    resize(width, height);
+    initializeGL();
+    resizeGL(width, height);
+}
+
+void WidgetOpenGLDraw::renderOffscreen() {
+    paintGL();
+}
+
+void WidgetOpenGLDraw::setCamera(glm::vec3 position, float pitch, float yaw) {
+    cameraPos = position;
+    cameraPitch = pitch;
+    cameraYaw = yaw;
+    updateCameraFront();
+}
+
 void WidgetOpenGLDraw::paintGL() {
+    profiler.beginFrame();
+    meshPrograms.beginFrame();
+
+    // Profiler overlay is painted with QPainter, which doesn't restore these
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_CULL_FACE);
+
+    // Widget's framebuffer (or the one bound for headless rendering), deferred shading draws into G-buffer first
+    GLint targetFramebuffer = 0;
+    gl.glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &targetFramebuffer);
+    GLint viewport[4];
+    gl.glGetIntegerv(GL_VIEWPORT, viewport);
+    const bool deferred = deferredShading && gBuffer.resize(viewport[2], viewport[3]); // Forward if G-buffer is unusable
+
     // Clean color and depth buffer (clean frame start)
+    profiler.beginScope("Clear");
     gl.glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    if (deferred) {
+        gBuffer.bindFramebuffer();
+        gl.glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    }
+    profiler.endScope();
 
     // Projection matrix
     glm::mat4 P;
+    const float fieldOfView = glm::radians(70.0f);
+    const float nearPlane = projectionOrtho ? -1000.0f : 0.01f;
+    const float farPlane = 1000.0f;
     if (projectionOrtho)
-        P = glm::ortho(-10.0f, 10.0f, -10.0f, 10.0f, -1000.0f, 1000.0f);
+        P = glm::ortho(-10.0f, 10.0f, -10.0f, 10.0f, nearPlane, farPlane);
     else
-        P = glm::perspective(glm::radians(70.0f), float(width()) / height(), 0.01f, 1000.0f);
+        P = glm::perspective(fieldOfView, float(width()) / height(), nearPlane, farPlane);
 
     // View matrix (camera position, direction ...)
     glm::mat4 V = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
 
-    // Object
-    for (const auto &object : objects) {
-        // Bind textures to texture units
-        if (!object.textureImage.isNull()) {
-            gl.glActiveTexture(GL_TEXTURE0);
-            gl.glBindTexture(GL_TEXTURE_2D, object.TBO[0]); // Texture
-        }
-        if (!object.bumpMapImage.isNull()) {
-            gl.glActiveTexture(GL_TEXTURE1);
-            gl.glBindTexture(GL_TEXTURE_2D, object.TBO[1]); // Bump Map
-        }
-
-        gl.glBindVertexArray(object.VAO);
-
-        // Model matrix (object movement)
-        glm::mat4 M = glm::mat4(1);
-        M = glm::translate(M, object.translation);
-        M = glm::rotate(M, object.rotation.x, glm::vec3(1, 0, 0));
-        M = glm::rotate(M, object.rotation.y, glm::vec3(0, 0, 1));
-        M = glm::rotate(M, object.rotation.z, glm::vec3(0, 1, 0));
-        M = glm::scale(M, object.scale);
-
-        // Uniforms
-        gl.glUniformMatrix4fv(gl.glGetUniformLocation(programShaderID, "P"), 1, GL_FALSE, glm::value_ptr(P));
-        gl.glUniformMatrix4fv(gl.glGetUniformLocation(programShaderID, "V"), 1, GL_FALSE, glm::value_ptr(V));
-        gl.glUniformMatrix4fv(gl.glGetUniformLocation(programShaderID, "M"), 1, GL_FALSE, glm::value_ptr(M));
-        gl.glUniform1i(gl.glGetUniformLocation(programShaderID, "Texture"), 0);
-        gl.glUniform1i(gl.glGetUniformLocation(programShaderID, "BumpMap"), 1);
-        gl.glUniform3fv(gl.glGetUniformLocation(programShaderID, "LightPos"), 1, glm::value_ptr(light.translation));
-        gl.glUniform1f(gl.glGetUniformLocation(programShaderID, "LightPower"), light.scale.x);
-        gl.glUniform3fv(gl.glGetUniformLocation(programShaderID, "LightColor"), 1, glm::value_ptr(light.color));
-        gl.glUniform3fv(gl.glGetUniformLocation(programShaderID, "AmbientColor"), 1, glm::value_ptr(object.material.ambientColor));
-        gl.glUniform3fv(gl.glGetUniformLocation(programShaderID, "DiffuseColor"), 1, glm::value_ptr(object.material.diffuseColor));
-        gl.glUniform3fv(gl.glGetUniformLocation(programShaderID, "SpecularColor"), 1, glm::value_ptr(object.material.specularColor));
-        gl.glUniform1f(gl.glGetUniformLocation(programShaderID, "SpecularPower"), object.material.specularPower);
-        gl.glUniform1ui(gl.glGetUniformLocation(programShaderID, "TextureMappingType"), object.textureMappingType);
-        gl.glUniform1ui(gl.glGetUniformLocation(programShaderID, "TextureMappingAxis"), object.textureMappingAxis);
-        gl.glUniform3fv(gl.glGetUniformLocation(programShaderID, "BoundingBoxMin"), 1, glm::value_ptr(object.boundingBoxMin));
-        gl.glUniform3fv(gl.glGetUniformLocation(programShaderID, "BoundingBoxMax"), 1, glm::value_ptr(object.boundingBoxMax));
-
-        // Draw
-        gl.glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(object.indices.size()), GL_UNSIGNED_INT, nullptr);
-
-        // Unbind texture specifically to prevent error or already bound texture from being applied (and general cleanup)
-        gl.glActiveTexture(GL_TEXTURE0);
-        gl.glBindTexture(GL_TEXTURE_2D, 0);
-        gl.glActiveTexture(GL_TEXTURE1);
-        gl.glBindTexture(GL_TEXTURE_2D, 0);
-#ifdef QT_DEBUG
-        // Unbind to avoid accidental modification
-        gl.glBindVertexArray(0);
-#endif
+    // Point lights, assigned to clusters of view frustum on CPU and bound to texture units after Texture and NormalMap
+    profiler.beginScope("Light Clusters");
+    pointLights.resize(lights.size());
+    for (size_t i = 0; i < lights.size(); ++i) {
+        float power = lights[i].scale.x;
+        pointLights[i].position = lights[i].translation;
+        pointLights[i].radius = lightRadius(power, lights[i].color);
+        pointLights[i].color = lights[i].color * power;
+    }
+    ClusterDepth clusterDepth(nearPlane, farPlane, !projectionOrtho);
+    profiler.addUploadedBytes(lightClusters.update(pointLights, P, V, clusterDepth));
+    lightClusters.bind(2);
+    profiler.endScope();
+
+    // Per-frame uniforms (clusters are indexed by framebuffer pixels, which may differ from widget size)
+    FrameUniforms frame;
+    frame.P = P;
+    frame.V = V;
+    frame.inversePV = glm::inverse(P * V);
+    frame.viewportSize = glm::vec2(viewport[2], viewport[3]);
+    frame.clusterDepthScale = clusterDepth.scale;
+    frame.clusterDepthBias = clusterDepth.bias;
+    frame.clusterLogDepth = clusterDepth.logarithmic;
+    profiler.beginScope("Uniforms");
+    profiler.addUploadedBytes(uniformBuffers.updateFrame(frame));
+
+    // Instance material palette
+    paletteUniforms.resize(std::min(materialPalette.size(), maxPaletteMaterials));
+    for (size_t i = 0; i < paletteUniforms.size(); ++i) {
+        paletteUniforms[i].ambientColor = materialPalette[i].ambientColor;
+        paletteUniforms[i].diffuseColor = materialPalette[i].diffuseColor;
+        paletteUniforms[i].specularColor = materialPalette[i].specularColor;
+        paletteUniforms[i].specularPower = materialPalette[i].specularPower;
+    }
+    profiler.addUploadedBytes(uniformBuffers.updateMaterials(paletteUniforms));
+    profiler.endScope();
+
+    // Frustum culling, world space matrix and bounds are only recomputed for moved objects
+    profiler.beginScope("Culling");
+    glm::mat4 PV = P * V;
+    scene.updateTransforms();
+    const TransformArrays &transforms = scene.transforms;
+    size_t visibleCount = cullBounds(Frustum(PV), transforms.worldBounds, visibleObjects);
+    lastCullingStats.visible = static_cast<uint32_t>(visibleCount);
+    lastCullingStats.culled = static_cast<uint32_t>(scene.size() - visibleCount);
+    profiler.endScope();
+
+    // Mesh buffer was replaced (grown or defragmented) since ranges and own VAOs were taken
+    RenderArrays &render = scene.render;
+    if (renderDataGeneration != meshBuffer.generation()) {
+        for (size_t i = 0; i < scene.size(); ++i) {
+            MeshObject &object = scene.objects[i];
+            if (!object.instances.empty() && object.instanceVAOGeneration != meshBuffer.generation()) {
+                setupInstanceVertexArray(object);
+            }
+            updateRenderData(scene.handle(i));
+        }
+        renderDataGeneration = meshBuffer.generation();
     }
 
+    // Per-object uniforms of visible objects, uploaded at once
+    profiler.beginScope("Object Uniforms");
+    objectUniforms.clear();
+    for (size_t i = 0; i < scene.size(); ++i) {
+        if (!visibleObjects[i]) {
+            continue;
+        }
+
+        const Material &material = scene.materials[i];
+        objectUniforms.emplace_back();
+        ObjectUniforms &uniforms = objectUniforms.back();
+        uniforms.M = transforms.M[i];
+        uniforms.MVP = PV * uniforms.M;
+        uniforms.normalMatrix = transforms.normalMatrix[i];
+        uniforms.ambientColor = material.ambientColor;
+        uniforms.diffuseColor = material.diffuseColor;
+        uniforms.specularColor = material.specularColor;
+        uniforms.specularPower = material.specularPower;
+        uniforms.boundingBoxMin = render.boundingBoxMin[i];
+        uniforms.textureMappingType = render.textureMappingType[i];
+        uniforms.boundingBoxMax = render.boundingBoxMax[i];
+        uniforms.textureMappingAxis = render.textureMappingAxis[i];
+        uniforms.positionQuantized = render.range[i].vertexFormat != VERTEX_FORMAT_FLOAT;
+    }
+    profiler.addUploadedBytes(uniformBuffers.updateObjects(objectUniforms));
+    profiler.endScope();
+
+    // Queue visible object draws (placeholder textures until uploaded), sorted by state on submit
+    renderQueue.clear();
+    uint32_t uniformIndex = 0;
+    for (size_t i = 0; i < scene.size(); ++i) {
+        if (!visibleObjects[i]) {
+            continue;
+        }
+
+        const MeshRange &range = render.range[i];
+        const std::vector<MeshLevel> &levels = *render.levels[i];
+
+        // Level of detail with error below allowed pixel error, projected at nearest point of bounds
+        if (levels.size() > 1) {
+            const glm::mat4 &M = transforms.M[i];
+            float distance = std::max(glm::length(transforms.worldBounds.center(i) - cameraPos) - glm::length(transforms.worldBounds.extent(i)), 0.01f);
+            float worldPerPixel = projectionOrtho ? 20.0f / height() : 2.0f * distance * std::tan(fieldOfView / 2.0f) / height();
+            float scale = std::max(glm::length(glm::vec3(M[0])), std::max(glm::length(glm::vec3(M[1])), glm::length(glm::vec3(M[2]))));
+            render.level[i] = selectLevel(levels, render.level[i], lodPixelError * worldPerPixel / scale);
+        }
+        const MeshLevel &level = levels[std::min<size_t>(render.level[i], levels.size() - 1)];
+
+        DrawItem item;
+        item.program = deferred ? geometryProgramID : programShaderID;
+        if (specializeShaders) {
+            // Variants sort next to each other (program is most significant in sort key)
+            ShaderVariant variant;
+            variant.textureMappingType = render.textureMappingType[i];
+            variant.textureMappingAxis = render.textureMappingAxis[i];
+            variant.texture = render.texture[i] != 0;
+            variant.bumpMap = render.bumpMap[i] != 0;
+            variant.bumpFromHeight = derivativeBumpMapping;
+            variant.deferred = deferred;
+            GLuint program = meshPrograms.program(variant);
+            if (program != 0) {
+                item.program = program;
+            }
+        }
+        item.texture = render.texture[i] != 0 ? render.texture[i] : placeholderTBO[0];
+        item.bumpMap = render.bumpMap[i] != 0 ? render.bumpMap[i] : placeholderTBO[1];
+        item.VAO = render.VAO[i];
+        item.firstIndex = range.firstIndex + level.firstIndex;
+        item.indexType = range.indexType;
+        item.baseVertex = range.baseVertex;
+        item.indexCount = static_cast<GLsizei>(level.indexCount);
+        item.instanceCount = render.instanceCount[i];
+        item.uniformIndex = uniformIndex++;
+        item.group = item.instanceCount > 0 ? "Draw Instanced" : "Draw Meshes";
+
+        // Front to back among draws with equal state (distance from camera over far plane)
+        float depth = glm::length(transforms.translation[i] - cameraPos) / 1000.0f;
+        item.key = makeSortKey(item.program, item.texture, item.bumpMap, item.VAO, depth);
+        renderQueue.push(item);
+    }
+    renderQueue.submit(&gl, uniformBuffers, &profiler);
+
+    // Deferred shading, lights of each pixel's cluster are shaded once into target framebuffer
+    if (deferred) {
+        profiler.beginScope("Lighting Pass");
+        gl.glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(targetFramebuffer));
+        glDisable(GL_DEPTH_TEST);
+        gl.glUseProgram(deferredProgramID);
+        gBuffer.bindTextures(5);
+        gl.glBindVertexArray(fullscreenVAO);
+        gl.glDrawArrays(GL_TRIANGLES, 0, 3);
+        glEnable(GL_DEPTH_TEST);
+        profiler.endScope();
+    }
+
+    const RenderStats &stats = renderQueue.stats();
+    profiler.endFrame(stats.drawCalls, stats.triangles, stats.stateChanges);
+
     const unsigned int err = gl.glGetError();
     if (err != 0) {
         std::cerr << "OpenGL draw error: " << err << std::endl;
     }
+
+    // Headless rendering has no window to paint on
+    if (showProfiler && isVisible()) {
+        drawProfilerOverlay();
+        update(); // Keep redrawing, so shown profile stays current
+    }
+}
+
+void WidgetOpenGLDraw::drawProfilerOverlay() {
+    const FrameProfile &profile = profiler.lastProfile();
+    QStringList lines;
+    lines << QString("Frame %1").arg(profile.frame);
+    lines << QString("%1 %2 %3").arg("Scope", -24).arg("CPU ms", 10).arg("GPU ms", 10);
+    for (const auto &scope : profile.scopes) {
+        QString name = QString(static_cast<int>(scope.depth) * 2, ' ') + scope.name;
+        lines << QString("%1 %2 %3").arg(name, -24).arg(scope.cpuTime, 10, 'f', 3).arg(scope.gpuTime, 10, 'f', 3);
+    }
+    lines << QString("Draw calls %1, triangles %2").arg(profile.drawCalls).arg(profile.triangles);
+    lines << QString("State binds %1, uploaded %2 KiB").arg(profile.stateChanges).arg(profile.uploadedBytes / 1024.0, 0, 'f', 1);
+    lines << QString("Shader variants %1 live, %2 used").arg(meshPrograms.stats().live).arg(meshPrograms.stats().used);
+
+    QPainter painter(this);
+    QFont font = QFontDatabase::systemFont(QFontDatabase::FixedFont);
+    painter.setFont(font);
+    QFontMetrics metrics(font);
+    int lineHeight = metrics.height();
+    painter.fillRect(QRect(4, 4, metrics.averageCharWidth() * 46 + 8, lineHeight * lines.size() + 8), QColor(0, 0, 0, 160));
+    painter.setPen(Qt::white);
+    for (int i = 0; i < lines.size(); ++i) {
+        painter.drawText(8, 8 + metrics.ascent() + i * lineHeight, lines[i]);
+    }
+    painter.end();
 }
 
 void WidgetOpenGLDraw::handleKeys(QSet<int> keys, Qt::KeyboardModifiers modifiers) {
@@ -528,53 +1258,71 @@ void WidgetOpenGLDraw::handleKeys(QSet<int> keys, Qt::KeyboardModifiers modifier
         cameraPos -= cameraUp * cameraSpeed;
     }
 
-    // Selected Object movement
+    // Selected Object movement, on a copy of light's or object's transform
+    LightObject *light = selectedLight();
+    Transform transform = light != nullptr ? static_cast<Transform>(*light) : scene.transform(selectedObject);
     if (keys.contains(Qt::Key_U)) {
         // Move up
-        selectedObject->translation.y += 0.25f;
+        transform.translation.y += 0.25f;
     }
     if (keys.contains(Qt::Key_N)) {
         // Move down
-        selectedObject->translation.y -= 0.25f;
+        transform.translation.y -= 0.25f;
     }
     if (keys.contains(Qt::Key_H)) {
         // Move right
-        selectedObject->translation.x += 0.25f;
+        transform.translation.x += 0.25f;
     }
     if (keys.contains(Qt::Key_L)) {
         // Move left
-        selectedObject->translation.x -= 0.25f;
+        transform.translation.x -= 0.25f;
     }
     if (keys.contains(Qt::Key_K)) {
         // Move forward
-        selectedObject->translation.z += 0.25f;
+        transform.translation.z += 0.25f;
     }
     if (keys.contains(Qt::Key_J)) {
         // Move backward
-        selectedObject->translation.z -= 0.25f;
+        transform.translation.z -= 0.25f;
     }
     if (keys.contains(Qt::Key_Plus)) {
         // Scale up
-        selectedObject->scale *= glm::vec3(1.05f);
+        transform.scale *= glm::vec3(1.05f);
     }
     if (keys.contains(Qt::Key_Minus)) {
         // Scale down
-        selectedObject->scale *= glm::vec3(0.95f);
+        transform.scale *= glm::vec3(0.95f);
     }
     if (keys.contains(Qt::Key_X)) {
         // Rotate on X
         int8_t dir = (modifiers.testFlag(Qt::ControlModifier)) ? -1 : 1;
-        selectedObject->rotation.x += 0.1f * dir;
+        transform.rotation.x += 0.1f * dir;
     }
     if (keys.contains(Qt::Key_Y)) {
         // Rotate on Y
         int8_t dir = (modifiers.testFlag(Qt::ControlModifier)) ? -1 : 1;
-        selectedObject->rotation.z += 0.1f * dir;
+        transform.rotation.z += 0.1f * dir;
     }
     if (keys.contains(Qt::Key_C)) {
         // Rotate on Z
         int8_t dir = (modifiers.testFlag(Qt::ControlModifier)) ? -1 : 1;
-        selectedObject->rotation.y += 0.1f * dir;
+        transform.rotation.y += 0.1f * dir;
+    }
+
+    // World space bounds of selected object have to follow its transform
+    const Qt::Key transformKeys[] = {Qt::Key_U, Qt::Key_N, Qt::Key_H, Qt::Key_L, Qt::Key_K, Qt::Key_J,
+                                     Qt::Key_Plus, Qt::Key_Minus, Qt::Key_X, Qt::Key_Y, Qt::Key_C};
+    for (auto key : transformKeys) {
+        if (!keys.contains(key)) {
+            continue;
+        }
+        if (light != nullptr) {
+            static_cast<Transform &>(*light) = transform;
+            light->transformChanged = true;
+        } else {
+            scene.setTransform(selectedObject, transform);
+        }
+        break;
     }
 
     // Misc
@@ -582,6 +1330,18 @@ void WidgetOpenGLDraw::handleKeys(QSet<int> keys, Qt::KeyboardModifiers modifier
         // Swap projection (orthogonal or perspective)
         projectionOrtho = !projectionOrtho;
     }
+    if (keys.contains(Qt::Key_F3)) {
+        // Toggle profiler overlay
+        showProfiler = !showProfiler;
+    }
+    if (keys.contains(Qt::Key_F4)) {
+        // Swap forward and deferred shading
+        deferredShading = !deferredShading;
+    }
+    if (keys.contains(Qt::Key_F5)) {
+        // Swap specialized shader variants and single branching program
+        specializeShaders = !specializeShaders;
+    }
 
     update(); // Redraw scene
 }
@@ -625,164 +1385,238 @@ void WidgetOpenGLDraw::updateCameraFront() {
 }
 
 void WidgetOpenGLDraw::selectObject(int index) {
-    if (index == 0) {
-        selectedObject = &light;
+    // Lights come first in ComboBox (found by index), objects after them (by handle in item data)
+    if (index < 0 || static_cast<size_t>(index) < lights.size()) {
+        selectedObject = ObjectHandle();
     } else {
-        selectedObject = &objects.at(static_cast<uint32_t>(index - 1));
+        selectedObject = ObjectHandle::unpack(objectSelection->itemData(index).toULongLong());
     }
 }
 
 bool WidgetOpenGLDraw::isMeshObjectSelected() {
-    return selectedObject != &light;
+    return selectedLight() == nullptr;
 }
 
-void WidgetOpenGLDraw::loadModelsFromFile(QStringList &paths, bool preload) {
-    for (auto &path : paths) {
-        QFileInfo fileInfo(path);
-        MeshObject object(fileInfo.fileName());
+LightObject *WidgetOpenGLDraw::selectedLight() {
+    int index = objectSelection->currentIndex();
+    if (index < 0 || static_cast<size_t>(index) >= lights.size()) {
+        return nullptr;
+    }
+    return &lights[static_cast<size_t>(index)];
+}
 
-        bool loaded = loadModelOBJ(path.toUtf8().constData(), object);
-        if (loaded) {
-            objects.push_back(object);
+Material *WidgetOpenGLDraw::selectedMaterial() {
+    return scene.material(selectedObject);
+}
 
-            if (!preload) {
-                // Buffer new data to GPU
-                generateObjectBuffers(objects.back()); // Reference from objects vector, as it is moved in memory when placing into vector!
-            }
+void WidgetOpenGLDraw::removeSelectedObject() {
+    if (!isMeshObjectSelected()) {
+        if (lights.size() == 1) {
+            return;
         }
-    }
 
-    if (!preload) {
-        // Select last added object
-        // (objects index + 1) due to light being at position 0 in ComboBox, but not in objects vector
-        objectSelection->setCurrentIndex(static_cast<int>(objects.size()));
+        // Select next light or first object
+        int index = objectSelection->currentIndex();
+        lights.erase(lights.begin() + index);
+        objectSelection->removeItem(index);
+        selectObject(objectSelection->currentIndex());
 
         update(); // Redraw scene
+        return;
     }
-}
-
-void WidgetOpenGLDraw::applyTextureFromFile(QString path, GLuint mappingType, GLuint mappingAxis, MeshObject *object, bool preload) {
+    MeshObject *object = scene.find(selectedObject);
     if (object == nullptr) {
-        object = static_cast<MeshObject *>(selectedObject);
+        return;
     }
 
-    QImage img;
-    if (!img.load(path)) {
-        std::cerr << "Texture image loading failed! [" << path.toStdString() << "]" << std::endl;
-        return;
+    makeCurrent();
+    if (!object->instances.empty()) {
+        gl.glDeleteVertexArrays(1, &object->instanceVAO);
+        gl.glDeleteBuffers(1, &object->instanceVBO);
     }
+    scene.remove(selectedObject); // Shared mesh and textures are freed with last user
+    doneCurrent();
 
-    object->textureImage = img.convertToFormat(QImage::Format_ARGB32);
-    object->textureMappingType = mappingType;
-    object->textureMappingAxis = mappingAxis;
+    // Select next object (selected object is current item)
+    objectSelection->removeItem(objectSelection->currentIndex());
+    selectObject(objectSelection->currentIndex());
 
+    update(); // Redraw scene
+}
+
+void WidgetOpenGLDraw::loadModelsFromFile(QStringList &paths, bool preload) {
     if (!preload) {
+        // Parse on worker threads, objects are added by addLoadedModels() one by one
+        if (!modelLoader.isLoading()) {
+            modelsAdded = false;
+        }
+        modelLoader.load(paths);
+        return;
+    }
+
+    for (auto &path : paths) {
+        LoadedModel model;
+        if (loadModel(path, model)) {
+            addModelObject(model);
+        }
+    }
+}
+
+ObjectHandle WidgetOpenGLDraw::addModelObject(LoadedModel &model) {
+    MeshObject object(QFileInfo(model.path).fileName());
+    object.vertices.swap(model.vertices);
+    object.indices.swap(model.indices);
+    object.mappedMesh = model.mapped;
+    object.meshKey = assetKey(model.path, model.sourceHash);
+    object.levelIndices.swap(model.levelIndices);
+    object.levels.swap(model.levels);
+    return scene.add(std::move(object));
+}
+
+QString WidgetOpenGLDraw::fileAssetKey(const QString &path) {
+    // Hashing is cheaper than decoding, shared images are never decoded again
+    return assetKey(path, hashFileContents(path));
+}
+
+void WidgetOpenGLDraw::addLoadedModels() {
+    std::vector<LoadedModel> models = modelLoader.takeLoaded();
+    if (models.empty()) {
+        return;
+    }
+
+    makeCurrent();
+    for (auto &model : models) {
         // Buffer new data to GPU
-        loadObjectTexture(*object);
+        generateObjectBuffers(addModelObject(model));
+    }
+    doneCurrent();
+    modelsAdded = true;
 
-        update(); // Redraw scene
+    update(); // Redraw scene
+}
+
+void WidgetOpenGLDraw::modelLoadFinished() {
+    addLoadedModels();
+
+    if (modelsAdded) {
+        // Select last added object (objects are added to the end of ComboBox)
+        objectSelection->setCurrentIndex(objectSelection->count() - 1);
+        modelsAdded = false;
     }
 }
 
-void WidgetOpenGLDraw::applyBumpMapFromFile(QString path, MeshObject *object, bool preload) {
+void WidgetOpenGLDraw::applyTextureFromFile(QString path, GLuint mappingType, GLuint mappingAxis, ObjectHandle handle, bool preload) {
+    if (handle.isNull()) {
+        handle = selectedObject;
+    }
+    MeshObject *object = scene.find(handle);
     if (object == nullptr) {
-        object = static_cast<MeshObject *>(selectedObject);
+        return;
     }
 
-    QImage img;
-    if (!img.load(path)) {
-        std::cerr << "Bump map image loading failed! [" << path.toStdString() << "]" << std::endl;
+    // Already resident, shared without decoding
+    QString key = fileAssetKey(path);
+    std::shared_ptr<GpuTexture> texture = assetCache.findTexture(key);
+    if (texture) {
+        object->textureKey = key;
+        object->texture = texture;
+        object->textureMappingType = mappingType;
+        object->textureMappingAxis = mappingAxis;
+        if (!preload) {
+            makeCurrent();
+            updateTextureMapping(*object);
+            doneCurrent();
+        }
+        updateRenderData(handle);
+        update(); // Redraw scene
         return;
     }
 
-    object->bumpMapImage = img.convertToFormat(QImage::Format_ARGB32);
-
     if (!preload) {
-        // Buffer new data to GPU
-        loadObjectBumpMap(*object);
+        // Decode on worker threads, uploaded by addDecodedTextures() (object is found by handle, it may be removed meanwhile)
+        textureLoader.load(path, key, handle.packed(), TEXTURE_SLOT_TEXTURE, mappingType, mappingAxis);
+        return;
+    }
 
-        update(); // Redraw scene
+    if (TextureLoader::decode(path, object->textureImage, textureLoader.cpuMipmaps ? &object->textureMipmaps : nullptr)) {
+        object->textureKey = key;
+        object->textureMappingType = mappingType;
+        object->textureMappingAxis = mappingAxis;
     }
 }
 
-bool WidgetOpenGLDraw::loadModelOBJ(const char *path, MeshObject &object) {
-    std::vector<uint32_t> vertexIndices, uvIndices, normalIndices;
-    std::vector<glm::vec3> tmpPositions;
-    std::vector<glm::vec2> tmpUvs;
-    std::vector<glm::vec3> tmpNormals;
-
-    std::ifstream ifs;
-    ifs.open(path);
-
-    // Read file
-    bool error = false;
-    while (!error) {
-        std::string lineHeader;
-        ifs >> lineHeader;
-        if (ifs.eof()) break;
-
-        if (lineHeader == "v") {
-            glm::vec3 vertex;
-            if (!(ifs >> vertex.x >> vertex.y >> vertex.z)) error = true;
-            tmpPositions.push_back(vertex);
-        } else if (lineHeader == "vt") {
-            glm::vec2 uv;
-            if (!(ifs >> uv.x >> uv.y)) error = true;
-            tmpUvs.push_back(uv);
-        } else if (lineHeader == "vn") {
-            glm::vec3 normal;
-            if (!(ifs >> normal.x >> normal.y >> normal.z)) error = true;
-            tmpNormals.push_back(normal);
-        } else if (lineHeader == "f") {
-            uint32_t vertexIndex[3], uvIndex[3], normalIndex[3];
-            char s; // Indices separated by '/' (slash)
-            if (!(ifs >> vertexIndex[0] >> s >> uvIndex[0] >> s >> normalIndex[0]
-                      >> vertexIndex[1] >> s >> uvIndex[1] >> s >> normalIndex[1]
-                      >> vertexIndex[2] >> s >> uvIndex[2] >> s >> normalIndex[2])) error = true;
-
-            vertexIndices.insert(vertexIndices.end(), {vertexIndex[0], vertexIndex[1], vertexIndex[2]});
-            uvIndices.insert(uvIndices.end(), {uvIndex[0], uvIndex[1], uvIndex[2]});
-            normalIndices.insert(normalIndices.end(), {normalIndex[0], normalIndex[1], normalIndex[2]});
-        } else {
-            // Probably a comment (or something else we don't support), eat up the rest of the line
-            ifs.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-        }
+void WidgetOpenGLDraw::applyBumpMapFromFile(QString path, ObjectHandle handle, bool preload) {
+    if (handle.isNull()) {
+        handle = selectedObject;
+    }
+    MeshObject *object = scene.find(handle);
+    if (object == nullptr) {
+        return;
     }
 
-    if (error) {
-        std::cerr << "Model OBJ file parsing failed! [" << path << "]" << std::endl;
-        ifs.close();
-        return false;
+    // Normal map depends on conversion strength too
+    QString key = fileAssetKey(path) + QString("#normal%1").arg(static_cast<double>(textureLoader.bumpStrength));
+    std::shared_ptr<GpuTexture> bumpMap = assetCache.findTexture(key);
+    if (bumpMap) {
+        object->bumpMapKey = key;
+        object->bumpMap = bumpMap;
+        updateRenderData(handle);
+        update(); // Redraw scene
+        return;
     }
 
-    // Rearrange data - OBJ indexes all parts separately, OpenGL only supports 1 index buffer
-    // Ignore OBJ indexing and just duplicate data for non-index usage (but still directly index them to keep the rest of the code clean)
-    // Each triangle
-    for (uint32_t v = 0; v < vertexIndices.size(); v += 3) {
-        // Each vertex of the triangle
-        for (uint32_t i = 0; i < 3; ++i) {
-            //  Get indices of wanted parts
-            uint32_t vertexIndex = vertexIndices[v + i];
-            glm::vec3 position = tmpPositions[vertexIndex - 1];
+    if (!preload) {
+        textureLoader.load(path, key, handle.packed(), TEXTURE_SLOT_BUMP_MAP);
+        return;
+    }
 
-            uint32_t uvIndex = uvIndices[v + i];
-            glm::vec2 uv = tmpUvs[uvIndex - 1];
+    if (TextureLoader::decodeBumpMap(path, textureLoader.bumpStrength, object->bumpMapImage, textureLoader.cpuMipmaps ? &object->bumpMapMipmaps : nullptr)) {
+        object->bumpMapKey = key;
+    }
+}
 
-            uint32_t normalIndex = normalIndices[v + i];
-            glm::vec3 normal = tmpNormals[normalIndex - 1];
+void WidgetOpenGLDraw::addDecodedTextures() {
+    std::vector<DecodedTexture> textures = textureLoader.takeDecoded();
+    if (textures.empty()) {
+        return;
+    }
 
-            // Save parts into Vertex and use current overall index
-            object.vertices.push_back({position, uv, normal});
-            object.indices.push_back(v + i);
+    makeCurrent();
+    for (auto &texture : textures) {
+        // Object may have been removed while decoding
+        ObjectHandle handle = ObjectHandle::unpack(texture.objectHandle);
+        MeshObject *found = scene.find(handle);
+        if (found == nullptr) {
+            continue;
         }
+        MeshObject &object = *found;
+
+        // Buffer new data to GPU
+        if (texture.slot == TEXTURE_SLOT_TEXTURE) {
+            object.textureKey = texture.key;
+            object.textureImage = texture.image;
+            object.textureMipmaps = std::move(texture.mipmaps);
+            object.textureMappingType = texture.mappingType;
+            object.textureMappingAxis = texture.mappingAxis;
+            updateTextureMapping(object);
+            loadObjectTexture(object);
+        } else {
+            object.bumpMapKey = texture.key;
+            object.bumpMapImage = texture.image;
+            object.bumpMapMipmaps = std::move(texture.mipmaps);
+            loadObjectBumpMap(object);
+        }
+        updateRenderData(handle);
     }
+    doneCurrent();
 
-    ifs.close();
-    return true;
+    update(); // Redraw scene
 }
 
 MeshObject WidgetOpenGLDraw::makeCube(QString name) {
-    return makeCubeOffset(glm::vec3(0.0f, 0.0f, 0.0f), 0, name);
+    MeshObject cube = makeCubeOffset(glm::vec3(0.0f, 0.0f, 0.0f), 0, name);
+    cube.meshKey = "generated:cube";
+    return cube;
 }
 
 MeshObject WidgetOpenGLDraw::makeCubeOffset(glm::vec3 baseVertex, GLuint baseIndex, QString name) {
@@ -790,24 +1624,24 @@ MeshObject WidgetOpenGLDraw::makeCubeOffset(glm::vec3 baseVertex, GLuint baseInd
         name,
         // Some vertices duplicated to fit indexing of UVs
         {
-            {baseVertex + glm::vec3(0.0f, 1.0f, 0.0f), glm::vec2(0.0f, 0.66f),  glm::vec3(-1.0f, 2.0f, -1.0f)},
-            {baseVertex + glm::vec3(0.0f, 0.0f, 0.0f), glm::vec2(0.25f, 0.66f), glm::vec3(-1.0f, -1.0f, -1.0f)},
-            {baseVertex + glm::vec3(1.0f, 1.0f, 0.0f), glm::vec2(0.0f, 0.33f),  glm::vec3(2.0f, 2.0f, -1.0f)},
-            {baseVertex + glm::vec3(1.0f, 0.0f, 0.0f), glm::vec2(0.25f, 0.33f), glm::vec3(2.0f, -1.0f, -1.0f)},
+            {baseVertex + glm::vec3(0.0f, 1.0f, 0.0f), glm::vec2(0.0f, 0.66f),  glm::vec3(-1.0f, 2.0f, -1.0f), glm::vec4(0.0f)},
+            {baseVertex + glm::vec3(0.0f, 0.0f, 0.0f), glm::vec2(0.25f, 0.66f), glm::vec3(-1.0f, -1.0f, -1.0f), glm::vec4(0.0f)},
+            {baseVertex + glm::vec3(1.0f, 1.0f, 0.0f), glm::vec2(0.0f, 0.33f),  glm::vec3(2.0f, 2.0f, -1.0f), glm::vec4(0.0f)},
+            {baseVertex + glm::vec3(1.0f, 0.0f, 0.0f), glm::vec2(0.25f, 0.33f), glm::vec3(2.0f, -1.0f, -1.0f), glm::vec4(0.0f)},
 
-            {baseVertex + glm::vec3(0.0f, 0.0f, 1.0f), glm::vec2(0.5f, 0.66f),  glm::vec3(-1.0f, -1.0f, 2.0f)},
-            {baseVertex + glm::vec3(1.0f, 0.0f, 1.0f), glm::vec2(0.5f, 0.33f),  glm::vec3(2.0f, -1.0f, 2.0f)},
-            {baseVertex + glm::vec3(0.0f, 1.0f, 1.0f), glm::vec2(0.75f, 0.66f), glm::vec3(-1.0f, 2.0f, -1.0f)},
-            {baseVertex + glm::vec3(1.0f, 1.0f, 1.0f), glm::vec2(0.75f, 0.33f), glm::vec3(2.0f, 2.0f, 2.0f)},
+            {baseVertex + glm::vec3(0.0f, 0.0f, 1.0f), glm::vec2(0.5f, 0.66f),  glm::vec3(-1.0f, -1.0f, 2.0f), glm::vec4(0.0f)},
+            {baseVertex + glm::vec3(1.0f, 0.0f, 1.0f), glm::vec2(0.5f, 0.33f),  glm::vec3(2.0f, -1.0f, 2.0f), glm::vec4(0.0f)},
+            {baseVertex + glm::vec3(0.0f, 1.0f, 1.0f), glm::vec2(0.75f, 0.66f), glm::vec3(-1.0f, 2.0f, -1.0f), glm::vec4(0.0f)},
+            {baseVertex + glm::vec3(1.0f, 1.0f, 1.0f), glm::vec2(0.75f, 0.33f), glm::vec3(2.0f, 2.0f, 2.0f), glm::vec4(0.0f)},
 
-            {baseVertex + glm::vec3(0.0f, 1.0f, 0.0f), glm::vec2(1.0f, 0.66f),  glm::vec3(-1.0f, 2.0f, -1.0f)},
-            {baseVertex + glm::vec3(1.0f, 1.0f, 0.0f), glm::vec2(1.0f, 0.33f),  glm::vec3(2.0f, 2.0f, -1.0f)},
+            {baseVertex + glm::vec3(0.0f, 1.0f, 0.0f), glm::vec2(1.0f, 0.66f),  glm::vec3(-1.0f, 2.0f, -1.0f), glm::vec4(0.0f)},
+            {baseVertex + glm::vec3(1.0f, 1.0f, 0.0f), glm::vec2(1.0f, 0.33f),  glm::vec3(2.0f, 2.0f, -1.0f), glm::vec4(0.0f)},
 
-            {baseVertex + glm::vec3(0.0f, 1.0f, 0.0f), glm::vec2(0.25f, 1.0f),  glm::vec3(-1.0f, 2.0f, -1.0f)},
-            {baseVertex + glm::vec3(0.0f, 1.0f, 1.0f), glm::vec2(0.5f, 1.0f),   glm::vec3(-1.0f, 2.0f, 2.0f)},
+            {baseVertex + glm::vec3(0.0f, 1.0f, 0.0f), glm::vec2(0.25f, 1.0f),  glm::vec3(-1.0f, 2.0f, -1.0f), glm::vec4(0.0f)},
+            {baseVertex + glm::vec3(0.0f, 1.0f, 1.0f), glm::vec2(0.5f, 1.0f),   glm::vec3(-1.0f, 2.0f, 2.0f), glm::vec4(0.0f)},
 
-            {baseVertex + glm::vec3(1.0f, 1.0f, 0.0f), glm::vec2(0.25f, 0.0f),  glm::vec3(2.0f, 2.0f, -1.0f)},
-            {baseVertex + glm::vec3(1.0f, 1.0f, 1.0f), glm::vec2(0.5f, 0.0f),   glm::vec3(2.0f, 2.0f, 2.0f)},
+            {baseVertex + glm::vec3(1.0f, 1.0f, 0.0f), glm::vec2(0.25f, 0.0f),  glm::vec3(2.0f, 2.0f, -1.0f), glm::vec4(0.0f)},
+            {baseVertex + glm::vec3(1.0f, 1.0f, 1.0f), glm::vec2(0.5f, 0.0f),   glm::vec3(2.0f, 2.0f, 2.0f), glm::vec4(0.0f)},
         },
         {
             baseIndex + 0, baseIndex + 2, baseIndex + 1,baseIndex + 1, baseIndex + 2, baseIndex + 3, // Front
@@ -819,21 +1653,22 @@ MeshObject WidgetOpenGLDraw::makeCubeOffset(glm::vec3 baseVertex, GLuint baseInd
         }
     };
 
+    computeTangents(cube.vertices, cube.indices);
     return cube;
 }
 
-MeshObject WidgetOpenGLDraw::makePyramid(uint32_t rows, QString name) {
-    MeshObject pyramid(name);
+MeshObject WidgetOpenGLDraw::makePyramidInstanced(uint32_t rows, QString name) {
+    MeshObject pyramid = makeCube(name);
 
+    // Same placement as merged pyramid, cube mesh is stored once
     float offset = 0.0f;
     for (uint32_t row = 0; row < rows; ++row) {
         for (uint32_t i = 0; i < rows - row; ++i) {
             for (uint32_t j = 0; j < rows - row; ++j) {
-                // Make cube and merge it into the pyramid
-                MeshObject cube = makeCubeOffset(glm::vec3(offset + i, row, offset + j), static_cast<GLuint>(pyramid.vertices.size()));
-                pyramid.vertices.insert(std::end(pyramid.vertices), std::begin(cube.vertices), std::end(cube.vertices));
-                pyramid.indices.insert(std::end(pyramid.indices), std::begin(cube.indices), std::end(cube.indices));
-                // Note: Normals should be corrected here, but they aren't
+                InstanceData instance;
+                instance.M = glm::translate(glm::mat4(1), glm::vec3(offset + i, row, offset + j));
+                instance.materialIndex = 0;
+                pyramid.instances.push_back(instance);
             }
         }
 
@@ -850,3 +1685,131 @@ MeshObject WidgetOpenGLDraw::makePyramid(uint32_t rows, QString name) {
 
     return pyramid;
 }
+
+void WidgetOpenGLDraw::addScatteredCubes(uint32_t count, float radius) {
+    std::uniform_real_distribution<float> position(-radius, radius);
+    std::uniform_real_distribution<float> angle(0.0f, glm::two_pi<float>());
+    std::uniform_real_distribution<float> color(0.0f, 1.0f);
+
+    makeCurrent();
+    for (uint32_t i = 0; i < count; ++i) {
+        Transform transform;
+        transform.translation = cameraPos + glm::vec3(position(rng), position(rng), position(rng));
+        transform.rotation = glm::vec3(angle(rng), angle(rng), angle(rng));
+        Material material;
+        material.diffuseColor = glm::vec3(color(rng), color(rng), color(rng));
+
+        // Buffer new data to GPU
+        generateObjectBuffers(scene.add(makeCube(QString("Scattered Cube %1").arg(i)), transform, material));
+    }
+    doneCurrent();
+
+    update(); // Redraw scene
+}
+
+void WidgetOpenGLDraw::addBenchmarkObjects(uint32_t scale) {
+    const float radius = 10.0f * scale;
+
+    makeCurrent();
+    // Bigger pyramids, merged and instanced
+    Transform transform;
+    transform.translation = glm::vec3(radius, 0.0f, 0.0f);
+    ObjectHandle object = scene.add(makePyramid(5 * scale + 5, "Benchmark Pyramid"), transform);
+    loadObjectTexture(*scene.find(object));
+    generateObjectBuffers(object);
+
+    transform.translation = glm::vec3(-radius, 0.0f, 0.0f);
+    object = scene.add(makePyramidInstanced(5 * scale + 5, "Benchmark Pyramid Instanced"), transform);
+    loadObjectTexture(*scene.find(object));
+    generateObjectBuffers(object);
+
+    // Model copies in a ring, mesh and texture are shared through asset cache
+    QStringList paths = {"../test/models/icoSphere.obj"};
+    for (uint32_t i = 0; i < 16 * scale; ++i) {
+        size_t count = scene.size();
+        loadModelsFromFile(paths, true);
+        if (scene.size() == count) {
+            break;
+        }
+
+        float angle = glm::two_pi<float>() * i / (16 * scale);
+        object = scene.handle(scene.size() - 1);
+        scene.find(object)->name = QString("Benchmark IcoSphere %1").arg(i);
+        transform.translation = glm::vec3(std::cos(angle) * radius * 0.5f, 1.0f, std::sin(angle) * radius * 0.5f);
+        scene.setTransform(object, transform);
+        applyTextureFromFile("../test/textures/steelMesh.jpg", 0, 0, object, true);
+        loadObjectTexture(*scene.find(object));
+        generateObjectBuffers(object);
+    }
+    doneCurrent();
+
+    // Scattered cubes are placed around camera, put them around origin
+    glm::vec3 camera = cameraPos;
+    cameraPos = glm::vec3(0.0f);
+    addScatteredCubes(250 * scale, radius);
+    cameraPos = camera;
+}
+
+void WidgetOpenGLDraw::addLight() {
+    // In front of camera, so it is visible right away
+    lights.push_back(LightObject(QString("Light %1").arg(lights.size() + 1), cameraPos + cameraFront * 2.0f, 40.0f));
+    objectSelection->insertItem(static_cast<int>(lights.size()) - 1, lights.back().name);
+    objectSelection->setCurrentIndex(static_cast<int>(lights.size()) - 1);
+
+    // Selected light may have moved with the lights vector
+    selectObject(objectSelection->currentIndex());
+
+    update(); // Redraw scene
+}
+
+void WidgetOpenGLDraw::addScatteredLights(uint32_t count, float radius, float power) {
+    std::uniform_real_distribution<float> position(-radius, radius);
+    std::uniform_real_distribution<float> height(0.5f, 3.0f);
+    std::uniform_real_distribution<float> color(0.0f, 1.0f);
+
+    for (uint32_t i = 0; i < count; ++i) {
+        lights.push_back(LightObject(QString("Scattered Light %1").arg(i), glm::vec3(position(rng), height(rng), position(rng)), power));
+        lights.back().color = glm::vec3(color(rng), color(rng), color(rng));
+        objectSelection->insertItem(static_cast<int>(lights.size()) - 1, lights.back().name);
+    }
+
+    // Selected object may have moved with the lights vector
+    selectObject(objectSelection->currentIndex());
+
+    update(); // Redraw scene
+}
+
+MeshObject WidgetOpenGLDraw::makePyramid(uint32_t rows, QString name, bool optimize) {
+    MeshObject pyramid(name);
+
+    // Rows are offset by half a block, so grid has half-block cells along X and Z (same placement as instanced pyramid)
+    int size = static_cast<int>(rows);
+    VoxelGrid grid(glm::ivec3(2 * size, size, 2 * size), glm::vec3(0.0f), glm::vec3(0.5f, 1.0f, 0.5f));
+    for (int row = 0; row < size; ++row) {
+        for (int i = 0; i < size - row; ++i) {
+            for (int j = 0; j < size - row; ++j) {
+                glm::ivec3 cell(row + 2 * i, row, row + 2 * j);
+                grid.fill(cell, cell + glm::ivec3(2, 1, 2));
+            }
+        }
+    }
+
+    // Only outer faces of blocks are kept, merged into as few rectangles as possible
+    meshVoxels(grid, pyramid.vertices, pyramid.indices);
+
+    // Faces are generated plane by plane, reorder for GPU (unoptimized order is a different mesh, keyed apart)
+    if (optimize) {
+        optimizeMesh(pyramid.vertices, pyramid.indices);
+    }
+    pyramid.meshKey = QString("generated:pyramid:%1:%2").arg(rows).arg(optimize ? "optimized" : "plane-order");
+
+    // Random solid color texture
+    std::uniform_int_distribution<> dist(0, 255);
+    QColor rngColor(dist(rng), dist(rng), dist(rng));
+
+    QImage img(1, 1, QImage::Format_ARGB32);
+    img.fill(rngColor);
+    pyramid.textureImage = img;
+
+    return pyramid;
+}
@@ -1,90 +1,48 @@
 #pragma once
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <memory>
 #include <vector>
 #include <random>
-#include <fstream>
 
 #include <QApplication>
 #include <QOpenGLWidget>
+#include <QOpenGLContext>
 #include <QOpenGLFunctions_3_3_Core>
 #include <QTime>
 #include <QMouseEvent>
 #include <QComboBox>
 #include <QFileInfo>
+#include <QPainter>
+#include <QFontDatabase>
+#include <QStandardPaths>
 
 #include <glm/glm.hpp>
 #include <glm/ext.hpp>
 
-struct Vertex {
-    glm::vec3 position;
-    glm::vec2 uv;
-    glm::vec3 normal;
-};
-
-struct Material {
-    glm::vec3 ambientColor = glm::vec3(0.1f);
-    glm::vec3 diffuseColor = glm::vec3(0.5f);
-    glm::vec3 specularColor = glm::vec3(1.0f);
-    float specularPower = 10.0f; // Shininess factor
-};
-
-struct Object {
-    QString name;
-
-    glm::vec3 translation = glm::vec3(0.0f);
-    glm::vec3 rotation = glm::vec3(0.0f);
-    glm::vec3 scale = glm::vec3(1.0f);
-
-    Object(QString name_)
-        : name(name_) {}
-};
-
-struct MeshObject : Object {
-    std::vector<Vertex> vertices;
-    std::vector<GLuint> indices;
-
-    // Uniforms
-    Material material;
-    GLuint textureMappingType; // 0 - Simple, 1 - Planar, 2 - Cylindrical, 3 - Spherical
-    GLuint textureMappingAxis; // 0 - X, 1 - Y, 2 - Z
-    glm::vec3 boundingBoxMin;
-    glm::vec3 boundingBoxMax;
-
-    // Buffers
-    GLuint VAO; // Vertex Array Object
-    GLuint VBO; // Vertex Buffer Object
-    GLuint IBO; // Index Buffer Object
-    GLuint TBO[2]; // Texture Buffer Object (Texture, Bump Map)
-
-    // Helpers
-    QImage textureImage;
-    QImage bumpMapImage;
-
-    MeshObject(QString name_)
-        : Object(name_), vertices({}), indices({}) {}
-    MeshObject(QString name_, std::vector<Vertex> vertices_, std::vector<GLuint> indices_)
-        : Object(name_), vertices(vertices_), indices(indices_) {}
-};
-
-struct LightObject : Object {
-    // position = MeshObject.translation
-    // power = MeshObject.scale
-    glm::vec3 color = glm::vec3(1.0f);
-
-    LightObject()
-        : Object("") {}
-
-    LightObject(QString name_)
-        : Object(name_) {}
-
-    LightObject(QString name_, glm::vec3 position_ = {0.0f, 0.0f, 0.0f}, float power_ = 40.0f)
-        : Object(name_) {
-        translation = position_;
-        scale = glm::vec3(power_);
-    }
-};
+#include "mesh.h"
+#include "objloader.h"
+#include "modelloader.h"
+#include "textureloader.h"
+#include "mipmap.h"
+#include "uniforms.h"
+#include "renderqueue.h"
+#include "culling.h"
+#include "meshbuffer.h"
+#include "vertexformat.h"
+#include "meshoptimize.h"
+#include "assetcache.h"
+#include "profiler.h"
+#include "lightclusters.h"
+#include "gbuffer.h"
+#include "shadervariants.h"
+#include "normalmap.h"
+#include "texturemapping.h"
+#include "voxelmesh.h"
+#include "programcache.h"
+#include "scene.h"
 
 class QOpenGLFunctions_3_3_Core;
 
@@ -93,29 +51,78 @@ class WidgetOpenGLDraw : public QOpenGLWidget {
 public:
     QComboBox *objectSelection;
 
-    Object *selectedObject;
-    LightObject light; // Single light support only
+    ObjectHandle selectedObject; // Null while a light is selected
+    std::vector<LightObject> lights; // Point lights, each fragment is shaded only by lights of its cluster
+
+    ModelLoader modelLoader; // Asynchronous model loading
+    TextureLoader textureLoader; // Asynchronous texture decoding
+    std::vector<Material> materialPalette; // Instance materials (instance material index - 1)
+    float anisotropy = 8.0f; // Maximum anisotropic filtering samples for textures uploaded afterwards (1 - disabled)
+    float lodPixelError = 1.0f; // Allowed screen-space error of levels of detail (pixels, 0 - always original)
+    bool quantizeVertices = false; // Upload meshes added afterwards in packed vertex formats and 16-bit indices (converted copy of every mesh, off - mapped caches are uploaded as is)
+    bool showProfiler = false; // Overlay with frame profile
+    bool deferredShading = false; // Geometry pass into G-buffer, then lighting pass shades each pixel once
+    bool specializeShaders = true; // Mesh program variant per texture mapping and texture use (false - one program branching on uniforms)
+    bool bakeTextureMappings = true; // Procedural texture mappings computed into mesh UVs once (false - per vertex in every frame), objects mapped afterwards
+    bool derivativeBumpMapping = false; // Bump map heights differentiated per fragment instead of normal maps (specialized shaders only, for comparison)
+    QString programCacheDirectory = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/programs"; // Linked program binaries, read on initialization (empty - disabled)
 
     WidgetOpenGLDraw(QWidget* parent);
     ~WidgetOpenGLDraw() override;
 
     bool isMeshObjectSelected();
+    LightObject *selectedLight(); // nullptr if mesh object is selected
+    Material *selectedMaterial(); // nullptr if light is selected
+    void removeSelectedObject(); // Last light is kept
+
+    // GL calls and state changes of last frame
+    const RenderStats &renderStats() const { return renderQueue.stats(); }
+    // Visible and culled objects of last frame
+    const CullingStats &cullingStats() const { return lastCullingStats; }
+    // Shared asset hits, misses and resident GPU memory
+    const AssetCacheStats &assetCacheStats() const { return assetCache.stats(); }
+    // Mesh buffer utilization and fragmentation
+    MeshBufferStats meshBufferStats() const { return meshBuffer.stats(); }
+    // CPU and GPU time of frame passes and per-frame counters, a few frames old (see Profiler)
+    const FrameProfile &frameProfile() const { return profiler.lastProfile(); }
+    // Compiled and last frame's mesh program variants
+    const ShaderVariantStats &shaderVariantStats() const { return meshPrograms.stats(); }
+    // Program binaries loaded from and written to disk
+    const ProgramCacheStats &programCacheStats() const { return programCache.stats(); }
+    // Light to cluster assignment of last frame
+    const ClusterStats &lightClusterStats() const { return lightClusters.stats(); }
 
     // Input
     void handleKeys(QSet<int> keys, Qt::KeyboardModifiers modifiers);
 
     // Loaders
-    void loadModelsFromFile(QStringList &paths, bool preload = false);
-    void applyTextureFromFile(QString path, GLuint mappingType, GLuint mappingAxis, MeshObject *object = nullptr, bool preload = false);
-    void applyBumpMapFromFile(QString path, MeshObject *object = nullptr, bool preload = false);
+    void loadModelsFromFile(QStringList &paths, bool preload = false); // Asynchronous unless preloading
+    void applyTextureFromFile(QString path, GLuint mappingType, GLuint mappingAxis, ObjectHandle object = ObjectHandle(), bool preload = false); // Null handle - selected object
+    void applyBumpMapFromFile(QString path, ObjectHandle object = ObjectHandle(), bool preload = false);
 
     // Generators
     MeshObject makeCube(QString name = "");
-    MeshObject makePyramid(uint32_t rows, QString name = "");
+    MeshObject makePyramid(uint32_t rows, QString name = "", bool optimize = true); // Outer faces of blocks merged into one mesh (greedy voxel meshing)
+    MeshObject makePyramidInstanced(uint32_t rows, QString name = ""); // Single cube drawn instanced
+    void addScatteredCubes(uint32_t count, float radius); // Benchmark scene, randomly placed around camera
+    void addBenchmarkObjects(uint32_t scale); // Benchmark scene, scaled-up variants of built-in objects around origin
+    void addLight(); // In front of camera, selected
+    void addScatteredLights(uint32_t count, float radius, float power = 1.0f); // Benchmark scene, randomly colored around origin
+
+    // Headless rendering (widget is never shown) into framebuffer bound in current context, see benchmarkFrames()
+    void initializeOffscreen(int width, int height);
+    void renderOffscreen();
+    void setCamera(glm::vec3 position, float pitch, float yaw);
+    size_t objectCount() const { return scene.size(); }
 
 public slots:
     void selectObject(int index);
 
+private slots:
+    void addLoadedModels();
+    void modelLoadFinished();
+    void addDecodedTextures();
+
 protected:
     // OpenGL overrides
     void paintGL() override;
@@ -123,22 +130,67 @@ protected:
     void resizeGL(int w, int h) override;
 
     // Buffers
-    void generateObjectBuffers(MeshObject &object);
+    void generateObjectBuffers(ObjectHandle handle); // Also adds object to selection
+    std::shared_ptr<GpuMesh> uploadMesh(const QString &key, GpuMesh mesh, const Vertex *vertices, const GLuint *indices, size_t indexCount); // Index count of all levels
+    void updateTextureMapping(MeshObject &object); // Draw mesh with baked UVs of object's mapping, or original mesh
+    std::shared_ptr<GpuMesh> bakeMeshMapping(const GpuMesh &source, GLuint mappingType, GLuint mappingAxis, const QString &key);
+    void setupInstanceVertexArray(MeshObject &object); // Mesh buffer and instance buffer into object's own VAO
+    void updateRenderData(ObjectHandle handle); // Per-frame render data from object, after its mesh, mapping or textures change
+    void computeBoundingBox(MeshObject &object, GpuMesh &mesh);
     void loadObjectTexture(MeshObject &object);
     void loadObjectBumpMap(MeshObject &object);
+    std::shared_ptr<GpuTexture> uploadTexture(const QString &key, QImage &image, std::vector<QImage> &mipmaps);
+    size_t uploadTextureImage(GLuint texture, const QImage &image, std::vector<QImage> &mipmaps); // Returns GPU memory size
 
 private:
     QOpenGLFunctions_3_3_Core gl;
     std::mt19937 rng;
 
     // Shaders
+    static const GLchar* shaderVersionSource;
+    static const GLchar* variantDefaultsSource;
     static const GLchar* vertexShaderSource;
+    static const GLchar* surfaceShaderSource;
+    static const GLchar* lightingShaderSource;
     static const GLchar* fragmentShaderSource;
-    GLuint programShaderID;
-    GLuint vertexShaderID;
-    GLuint fragmentShaderID;
+    static const GLchar* geometryFragmentShaderSource;
+    static const GLchar* fullscreenVertexShaderSource;
+    static const GLchar* deferredFragmentShaderSource;
+    GLuint programShaderID; // Forward shading
+    GLuint geometryProgramID; // Deferred shading passes
+    GLuint deferredProgramID;
+    ShaderVariants meshPrograms; // Specialized forward and geometry pass programs
+    ProgramCache programCache; // Binaries of all programs, keyed by their full sources
+
+    MeshBuffer meshBuffer; // Vertices and indices of all meshes
+    uint32_t renderDataGeneration = 0; // Mesh buffer generation ranges in render data were taken from
+    AssetCache assetCache; // Meshes and textures shared by objects (outlives them)
+    Scene scene; // Mesh objects, found by handles (UI keeps them as selection item data)
 
-    std::vector<MeshObject> objects;
+    // Uniforms
+    UniformBuffers uniformBuffers;
+    std::vector<ObjectUniforms> objectUniforms; // Reused between frames
+    std::vector<MaterialUniforms> paletteUniforms;
+    RenderQueue renderQueue;
+    Profiler profiler;
+
+    // Lights
+    LightClusters lightClusters;
+    std::vector<PointLight> pointLights; // Reused between frames
+
+    // Deferred shading
+    GBuffer gBuffer;
+    GLuint fullscreenVAO = 0; // No attributes, core profile draws require a bound VAO
+
+    // Culling
+    std::vector<uint8_t> visibleObjects;
+    CullingStats lastCullingStats;
+
+    // Textures
+    PixelUploadRing pixelUploadRing;
+    GLuint placeholderTBO[2]; // Bound until object's own textures are uploaded (Texture - white, Bump Map - flat)
+    float maxAnisotropy = 0.0f; // 0 if anisotropic filtering is not supported
+    bool modelsAdded = false; // Any model added in current asynchronous load
 
     // Initial camera position
     glm::vec3 cameraPos = glm::vec3(6.5f, 5.5f, -10.0f);
@@ -152,8 +204,14 @@ private:
     glm::vec3 cameraUp = glm::vec3(0.0f, 1.0f, 0.0f);
     bool projectionOrtho = false;
 
+    // Profiling
+    void drawProfilerOverlay();
+
     // Shaders
     void compileShaders();
+    GLuint compileProgram(const std::vector<const GLchar *> &vertexSources, const std::vector<const GLchar *> &fragmentSources, const GLchar *defines = ""); // 0 on failure
+    GLuint compileMeshProgram(bool deferred, const GLchar *defines = "");
+    void setProgramTextureUnits(GLuint program);
     void printProgramInfoLog(GLuint obj);
     void printShaderInfoLog(GLuint obj);
 
@@ -162,8 +220,9 @@ private:
     void mouseMoveEvent(QMouseEvent *event) override;
     void updateCameraFront();
 
-    // Format loaders
-    bool loadModelOBJ(const char *path, MeshObject &object /* out */);
+    // Loaders
+    ObjectHandle addModelObject(LoadedModel &model);
+    QString fileAssetKey(const QString &path); // Content hashed
 
     // Generators
     MeshObject makeCubeOffset(glm::vec3 baseVertex, GLuint baseIndex = 0, QString name = "");